@@ -0,0 +1,1731 @@
+/* bench.cpp -- throughput and latency benchmarks for the heap implementations
+ *
+ * Usage: bench [-w workload,...] [-b backend,...] [-n size,...] [-o ops]
+ *              [-r ratio] [-k batch] [-s seed]
+ *
+ * Workloads (all keep roughly n elements in the heap):
+ *   hold    -- the classic hold model: take the minimum, re-insert it with
+ *              a slightly larger key.
+ *   burst   -- insert n random keys, then take n keys.
+ *   build   -- build a heap of n random keys at once, then take n keys.
+ *              Build latencies are reported per element.
+ *   sorted  -- like build, but the keys are handed over in increasing order,
+ *              which lets heap.h, iheap.h, ciheap.h and the binary heap
+ *              skip the comparisons.
+ *   union   -- build small heaps of 32 keys and merge them into the big heap,
+ *              then take 32 keys.
+ *   many    -- like hold, but take k keys at once (-k, default 64) and
+ *              re-insert them, each a random increment after the last
+ *              key taken. heap.h and iheap.h use their take_many();
+ *              the other backends take one key at a time. Take latencies
+ *              are reported per key.
+ *   update  -- decrease-key/delete heavy mix on a heap of n elements.
+ *   decrease -- Dijkstra-like: take the minimum, insert a slightly larger
+ *              key, and decrease r random elements (-r, default 10) to
+ *              slightly larger keys, unless they are smaller already.
+ *
+ * For each workload, backend, and size, the benchmark first runs the
+ * workload without per-operation timing to obtain the overall cost (total
+ * ns/op), and then runs it again while timing every single operation to
+ * report the mean and the p50/p99/p999 latency of each kind of operation.
+ * Per-operation latencies include the cost of reading the clock.
+ */
+
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "heap_pool.h"
+#include "ciheap.h"
+#include "riheap.h"
+#include "sheap.h"
+#include "fiheap.h"
+#include "rheap.h"
+#include "binomial_heap.hpp"
+
+#define BATCH 32
+#define HOLD_INCREMENT 4096
+
+typedef std::chrono::steady_clock bench_clock;
+
+/* xorshift64* -- fast enough not to show up in the measurements */
+struct rng {
+	unsigned long long state;
+
+	explicit rng(unsigned long long seed) : state(seed ? seed : 1) {}
+
+	unsigned long long next()
+	{
+		state ^= state >> 12;
+		state ^= state << 25;
+		state ^= state >> 27;
+		return state * 2685821657736338717ULL;
+	}
+
+	/* uniform in [0, bound) */
+	int below(int bound)
+	{
+		return (int) ((next() >> 33) % (unsigned long long) bound);
+	}
+
+	int key()
+	{
+		return below(1 << 30);
+	}
+};
+
+/* Hands out objects from fixed-size chunks so that addresses stay stable
+ * and the allocator does not show up in the measurements. */
+template <typename T>
+class freelist {
+	std::vector<T*> chunks;
+	std::vector<T*> avail;
+	enum { CHUNK = 4096 };
+
+public:
+	freelist() {}
+	freelist(const freelist&) = delete;
+	freelist& operator=(const freelist&) = delete;
+
+	~freelist()
+	{
+		for (size_t i = 0; i < chunks.size(); i++)
+			delete[] chunks[i];
+	}
+
+	T* get()
+	{
+		T* chunk;
+		T* obj;
+		if (avail.empty()) {
+			chunk = new T[CHUNK];
+			chunks.push_back(chunk);
+			for (int i = CHUNK - 1; i >= 0; i--)
+				avail.push_back(chunk + i);
+		}
+		obj = avail.back();
+		avail.pop_back();
+		return obj;
+	}
+
+	void put(T* obj)
+	{
+		avail.push_back(obj);
+	}
+};
+
+/* ------------------------------------------------------------------------ *
+ * Backends. Each backend offers
+ *   handle insert(int key), int take(), bool empty(),
+ *   void build(const int* keys, size_t n, bool sorted) (on an empty heap;
+ *   the keys are in increasing order if sorted),
+ *   void merge(backend& other), size_t take_many(int* keys, size_t k) if
+ *   native_take_many, and, if addressable,
+ *   void decrease(handle, int key), void remove(handle), int key(handle),
+ *   handle top(), and size_t& tag(handle) for the workload's bookkeeping.
+ * dump_stats(label) prints the operation counters of heap.h and iheap.h if
+ * bench was compiled with -DHEAP_STATS (see bench_stats); it is a no-op
+ * otherwise.
+ * ------------------------------------------------------------------------ */
+
+/* heap.h: generic comparator through a function pointer */
+struct heap_item {
+	int			key;
+	size_t			tag;
+	struct heap_node*	node;
+};
+
+static int heap_item_cmp(struct heap_node* _a, struct heap_node* _b)
+{
+	struct heap_item *a, *b;
+	a = (struct heap_item*) heap_node_value(_a);
+	b = (struct heap_item*) heap_node_value(_b);
+	return a->key < b->key;
+}
+
+class heap_backend {
+	struct heap			heap;
+	struct heap_pool&		nodes;
+	freelist<struct heap_item>&	items;
+	std::vector<struct heap_node*>	scratch;
+	/* plain nodes without ref: decrease and delete relink */
+	bool				relink;
+
+public:
+	typedef struct heap_item* handle;
+	static const bool addressable = true;
+	static const char* name() { return "heap.h"; }
+
+	heap_backend(struct heap_pool& n, freelist<struct heap_item>& i,
+		     bool lazy = false, bool r = false)
+		: nodes(n), items(i), relink(r)
+	{
+		if (lazy)
+			heap_init_lazy(&heap);
+		else
+			heap_init(&heap);
+	}
+
+	~heap_backend()
+	{
+		while (!empty())
+			take();
+	}
+
+	bool empty() { return heap_empty(&heap); }
+
+	void init_node(struct heap_item* it)
+	{
+		if (relink)
+			heap_node_init(it->node, it);
+		else
+			heap_node_init_ref(&it->node, it);
+	}
+
+	handle insert(int key)
+	{
+		struct heap_item* it = items.get();
+		it->key  = key;
+		it->node = heap_node_alloc(&nodes);
+		init_node(it);
+		heap_insert(heap_item_cmp, &heap, it->node);
+		return it;
+	}
+
+	int take()
+	{
+		struct heap_node* hn = heap_take(heap_item_cmp, &heap);
+		struct heap_item* it = (struct heap_item*) heap_node_value(hn);
+		int key = it->key;
+		heap_node_free(&nodes, hn);
+		items.put(it);
+		return key;
+	}
+
+	size_t take_many(int* keys, size_t k)
+	{
+		struct heap_item* it;
+		size_t n;
+		scratch.resize(k);
+		n = heap_take_many(heap_item_cmp, &heap, &scratch[0], k);
+		for (size_t i = 0; i < n; i++) {
+			it = (struct heap_item*) heap_node_value(scratch[i]);
+			keys[i] = it->key;
+			heap_node_free(&nodes, scratch[i]);
+			items.put(it);
+		}
+		return n;
+	}
+
+	void build(const int* keys, size_t n, bool sorted)
+	{
+		struct heap_item* it;
+		scratch.resize(n);
+		for (size_t i = 0; i < n; i++) {
+			it = items.get();
+			it->key  = keys[i];
+			it->node = heap_node_alloc(&nodes);
+			init_node(it);
+			scratch[i] = it->node;
+		}
+		if (sorted)
+			heap_build_sorted(heap_item_cmp, &heap, &scratch[0], n);
+		else
+			heap_build(heap_item_cmp, &heap, &scratch[0], n);
+	}
+
+	void merge(heap_backend& other)
+	{
+		heap_union(heap_item_cmp, &heap, &other.heap);
+	}
+
+	int key(handle h) { return h->key; }
+	size_t& tag(handle h) { return h->tag; }
+
+	handle top()
+	{
+		return (handle) heap_node_value(heap_peek(heap_item_cmp, &heap));
+	}
+
+	void decrease(handle h, int key)
+	{
+		h->key = key;
+		heap_decrease(heap_item_cmp, &heap, h->node);
+	}
+
+	void remove(handle h)
+	{
+		heap_delete(heap_item_cmp, &heap, h->node);
+		heap_node_free(&nodes, h->node);
+		items.put(h);
+	}
+
+	void dump_stats(const char* label)
+	{
+#ifdef HEAP_STATS
+		heap_stats_dump(stdout, label, &heap.stats);
+#else
+		(void) label;
+#endif
+	}
+};
+
+/* iheap.h: integer keys stored in the node */
+struct iheap_slot {
+	size_t			tag;
+	struct iheap_node*	node;
+};
+
+class iheap_backend {
+	struct iheap			heap;
+	struct heap_pool&		nodes;
+	freelist<struct iheap_slot>&	slots;
+	std::vector<struct iheap_node*>	scratch;
+	bool				relink;
+
+public:
+	typedef struct iheap_slot* handle;
+	static const bool addressable = true;
+	static const char* name() { return "iheap.h"; }
+
+	iheap_backend(struct heap_pool& n,
+		      freelist<struct iheap_slot>& s, bool lazy = false,
+		      bool r = false)
+		: nodes(n), slots(s), relink(r)
+	{
+		if (lazy)
+			iheap_init_lazy(&heap);
+		else
+			iheap_init(&heap);
+	}
+
+	~iheap_backend()
+	{
+		while (!empty())
+			take();
+	}
+
+	bool empty() { return iheap_empty(&heap); }
+
+	void init_node(struct iheap_slot* s, int key)
+	{
+		if (relink)
+			iheap_node_init(s->node, key, s);
+		else
+			iheap_node_init_ref(&s->node, key, s);
+	}
+
+	handle insert(int key)
+	{
+		struct iheap_slot* s = slots.get();
+		s->node = iheap_node_alloc(&nodes);
+		init_node(s, key);
+		iheap_insert(&heap, s->node);
+		return s;
+	}
+
+	int take()
+	{
+		struct iheap_node* hn = iheap_take(&heap);
+		int key = hn->key;
+		slots.put((struct iheap_slot*) iheap_node_value(hn));
+		iheap_node_free(&nodes, hn);
+		return key;
+	}
+
+	size_t take_many(int* keys, size_t k)
+	{
+		size_t n;
+		scratch.resize(k);
+		n = iheap_take_many(&heap, &scratch[0], k);
+		for (size_t i = 0; i < n; i++) {
+			keys[i] = scratch[i]->key;
+			slots.put((struct iheap_slot*)
+				  iheap_node_value(scratch[i]));
+			iheap_node_free(&nodes, scratch[i]);
+		}
+		return n;
+	}
+
+	void build(const int* keys, size_t n, bool sorted)
+	{
+		struct iheap_slot* s;
+		scratch.resize(n);
+		for (size_t i = 0; i < n; i++) {
+			s = slots.get();
+			s->node = iheap_node_alloc(&nodes);
+			init_node(s, keys[i]);
+			scratch[i] = s->node;
+		}
+		if (sorted)
+			iheap_build_sorted(&heap, &scratch[0], n);
+		else
+			iheap_build(&heap, &scratch[0], n);
+	}
+
+	void merge(iheap_backend& other)
+	{
+		iheap_union(&heap, &other.heap);
+	}
+
+	int key(handle h) { return h->node->key; }
+	size_t& tag(handle h) { return h->tag; }
+
+	handle top()
+	{
+		return (handle) iheap_node_value(iheap_peek(&heap));
+	}
+
+	void decrease(handle h, int key)
+	{
+		iheap_decrease(&heap, h->node, key);
+	}
+
+	void remove(handle h)
+	{
+		iheap_delete(&heap, h->node);
+		iheap_node_free(&nodes, h->node);
+		slots.put(h);
+	}
+
+	void dump_stats(const char* label)
+	{
+#ifdef HEAP_STATS
+		heap_stats_dump(stdout, label, &heap.stats);
+#else
+		(void) label;
+#endif
+	}
+};
+
+/* lazy variants: consolidation happens in take() */
+struct lazy_heap_backend : public heap_backend {
+	static const char* name() { return "heap.h (lazy)"; }
+
+	lazy_heap_backend(struct heap_pool& n, freelist<struct heap_item>& i)
+		: heap_backend(n, i, true)
+	{
+	}
+};
+
+struct lazy_iheap_backend : public iheap_backend {
+	static const char* name() { return "iheap.h (lazy)"; }
+
+	lazy_iheap_backend(struct heap_pool& n, freelist<struct iheap_slot>& s)
+		: iheap_backend(n, s, true)
+	{
+	}
+};
+
+/* relinking variants: nodes move instead of their values */
+struct relink_heap_backend : public heap_backend {
+	static const char* name() { return "heap.h (relink)"; }
+
+	relink_heap_backend(struct heap_pool& n, freelist<struct heap_item>& i)
+		: heap_backend(n, i, false, true)
+	{
+	}
+};
+
+struct relink_iheap_backend : public iheap_backend {
+	static const char* name() { return "iheap.h (relink)"; }
+
+	relink_iheap_backend(struct heap_pool& n,
+			     freelist<struct iheap_slot>& s)
+		: iheap_backend(n, s, false, true)
+	{
+	}
+};
+
+/* sheap.h: same comparator as heap.h, but insertion never carries */
+struct sheap_item {
+	int			key;
+	struct sheap_node*	node;
+};
+
+static int sheap_item_cmp(struct sheap_node* _a, struct sheap_node* _b)
+{
+	struct sheap_item *a, *b;
+	a = (struct sheap_item*) sheap_node_value(_a);
+	b = (struct sheap_item*) sheap_node_value(_b);
+	return a->key < b->key;
+}
+
+class sheap_backend {
+	struct sheap			heap;
+	struct heap_pool&		nodes;
+	freelist<struct sheap_item>&	items;
+
+public:
+	typedef int handle;
+	static const bool addressable = false;
+	static const char* name() { return "sheap.h"; }
+
+	sheap_backend(struct heap_pool& n, freelist<struct sheap_item>& i)
+		: nodes(n), items(i)
+	{
+		sheap_init(&heap);
+	}
+
+	~sheap_backend()
+	{
+		while (!empty())
+			take();
+	}
+
+	bool empty() { return sheap_empty(&heap); }
+
+	handle insert(int key)
+	{
+		struct sheap_item* it = items.get();
+		it->key  = key;
+		it->node = (struct sheap_node*) heap_pool_alloc(&nodes);
+		sheap_node_init(it->node, it);
+		sheap_insert(sheap_item_cmp, &heap, it->node);
+		return 0;
+	}
+
+	int take()
+	{
+		struct sheap_node* hn = sheap_take(sheap_item_cmp, &heap);
+		struct sheap_item* it;
+		int key;
+		it  = (struct sheap_item*) sheap_node_value(hn);
+		key = it->key;
+		heap_pool_free(&nodes, hn);
+		items.put(it);
+		return key;
+	}
+
+	void build(const int* keys, size_t n, bool)
+	{
+		for (size_t i = 0; i < n; i++)
+			insert(keys[i]);
+	}
+
+	void merge(sheap_backend& other)
+	{
+		sheap_union(sheap_item_cmp, &heap, &other.heap);
+	}
+
+	int key(handle) { return 0; }
+	size_t& tag(handle) { static size_t dummy; return dummy; }
+	handle top() { return 0; }
+	void decrease(handle, int) {}
+	void remove(handle) {}
+
+	void dump_stats(const char* label)
+	{
+#ifdef HEAP_STATS
+		heap_stats_dump(stdout, label, &heap.stats);
+#else
+		(void) label;
+#endif
+	}
+};
+
+/* riheap.h: iheap.h nodes, roots in a degree-indexed array */
+class riheap_backend {
+	struct riheap			heap;
+	struct heap_pool&		nodes;
+	freelist<struct iheap_slot>&	slots;
+
+public:
+	typedef struct iheap_slot* handle;
+	static const bool addressable = true;
+	static const char* name() { return "riheap.h"; }
+
+	riheap_backend(struct heap_pool& n, freelist<struct iheap_slot>& s)
+		: nodes(n), slots(s)
+	{
+		riheap_init(&heap);
+	}
+
+	~riheap_backend()
+	{
+		while (!empty())
+			take();
+	}
+
+	bool empty() { return riheap_empty(&heap); }
+
+	handle insert(int key)
+	{
+		struct iheap_slot* s = slots.get();
+		s->node = iheap_node_alloc(&nodes);
+		iheap_node_init_ref(&s->node, key, s);
+		riheap_insert(&heap, s->node);
+		return s;
+	}
+
+	int take()
+	{
+		struct iheap_node* hn = riheap_take(&heap);
+		int key = hn->key;
+		slots.put((struct iheap_slot*) iheap_node_value(hn));
+		iheap_node_free(&nodes, hn);
+		return key;
+	}
+
+	void build(const int* keys, size_t n, bool)
+	{
+		for (size_t i = 0; i < n; i++)
+			insert(keys[i]);
+	}
+
+	void merge(riheap_backend& other)
+	{
+		riheap_union(&heap, &other.heap);
+	}
+
+	int key(handle h) { return h->node->key; }
+	size_t& tag(handle h) { return h->tag; }
+
+	handle top()
+	{
+		return (handle) iheap_node_value(riheap_peek(&heap));
+	}
+
+	void decrease(handle h, int key)
+	{
+		riheap_decrease(&heap, h->node, key);
+	}
+
+	void remove(handle h)
+	{
+		riheap_delete(&heap, h->node);
+		iheap_node_free(&nodes, h->node);
+		slots.put(h);
+	}
+
+	void dump_stats(const char* label)
+	{
+#ifdef HEAP_STATS
+		heap_stats_dump(stdout, label, &heap.stats);
+#else
+		(void) label;
+#endif
+	}
+};
+
+/* fiheap.h: integer keys stored in the node, decrease cuts */
+struct fiheap_slot {
+	size_t			tag;
+	struct fiheap_node*	node;
+};
+
+class fiheap_backend {
+	struct fiheap			heap;
+	struct heap_pool&		nodes;
+	freelist<struct fiheap_slot>&	slots;
+
+public:
+	typedef struct fiheap_slot* handle;
+	static const bool addressable = true;
+	static const char* name() { return "fiheap.h"; }
+
+	fiheap_backend(struct heap_pool& n, freelist<struct fiheap_slot>& s)
+		: nodes(n), slots(s)
+	{
+		fiheap_init(&heap);
+	}
+
+	~fiheap_backend()
+	{
+		while (!empty())
+			take();
+	}
+
+	bool empty() { return fiheap_empty(&heap); }
+
+	handle insert(int key)
+	{
+		struct fiheap_slot* s = slots.get();
+		s->node = (struct fiheap_node*) heap_pool_alloc(&nodes);
+		fiheap_node_init(s->node, key, s);
+		fiheap_insert(&heap, s->node);
+		return s;
+	}
+
+	int take()
+	{
+		struct fiheap_node* hn = fiheap_take(&heap);
+		int key = hn->key;
+		slots.put((struct fiheap_slot*) fiheap_node_value(hn));
+		heap_pool_free(&nodes, hn);
+		return key;
+	}
+
+	void build(const int* keys, size_t n, bool)
+	{
+		for (size_t i = 0; i < n; i++)
+			insert(keys[i]);
+	}
+
+	void merge(fiheap_backend& other)
+	{
+		fiheap_union(&heap, &other.heap);
+	}
+
+	int key(handle h) { return h->node->key; }
+	size_t& tag(handle h) { return h->tag; }
+
+	handle top()
+	{
+		return (handle) fiheap_node_value(fiheap_peek(&heap));
+	}
+
+	void decrease(handle h, int key)
+	{
+		fiheap_decrease(&heap, h->node, key);
+	}
+
+	void remove(handle h)
+	{
+		fiheap_delete(&heap, h->node);
+		heap_pool_free(&nodes, h->node);
+		slots.put(h);
+	}
+
+	void dump_stats(const char* label)
+	{
+#ifdef HEAP_STATS
+		heap_stats_dump(stdout, label, &heap.stats);
+#else
+		(void) label;
+#endif
+	}
+};
+
+/* rheap.h: radix heap; only for the workloads with monotone keys */
+struct rheap_slot {
+	size_t			tag;
+	struct rheap_node*	node;
+};
+
+class rheap_backend {
+	struct rheap			heap;
+	struct heap_pool&		nodes;
+	freelist<struct rheap_slot>&	slots;
+
+public:
+	typedef struct rheap_slot* handle;
+	static const bool addressable = true;
+	static const char* name() { return "rheap.h"; }
+
+	rheap_backend(struct heap_pool& n, freelist<struct rheap_slot>& s)
+		: nodes(n), slots(s)
+	{
+		rheap_init(&heap);
+	}
+
+	~rheap_backend()
+	{
+		while (!empty())
+			take();
+	}
+
+	bool empty() { return rheap_empty(&heap); }
+
+	handle insert(int key)
+	{
+		struct rheap_slot* s = slots.get();
+		s->node = (struct rheap_node*) heap_pool_alloc(&nodes);
+		rheap_node_init(s->node, key, s);
+		rheap_insert(&heap, s->node);
+		return s;
+	}
+
+	int take()
+	{
+		struct rheap_node* hn = rheap_take(&heap);
+		int key = hn->key;
+		slots.put((struct rheap_slot*) rheap_node_value(hn));
+		heap_pool_free(&nodes, hn);
+		return key;
+	}
+
+	void build(const int* keys, size_t n, bool)
+	{
+		for (size_t i = 0; i < n; i++)
+			insert(keys[i]);
+	}
+
+	void merge(rheap_backend& other)
+	{
+		rheap_union(&heap, &other.heap);
+	}
+
+	int key(handle h) { return h->node->key; }
+	size_t& tag(handle h) { return h->tag; }
+
+	handle top()
+	{
+		return (handle) rheap_node_value(rheap_peek(&heap));
+	}
+
+	void decrease(handle h, int key)
+	{
+		rheap_decrease(&heap, h->node, key);
+	}
+
+	void remove(handle h)
+	{
+		rheap_delete(&heap, h->node);
+		heap_pool_free(&nodes, h->node);
+		slots.put(h);
+	}
+
+	void dump_stats(const char* label)
+	{
+#ifdef HEAP_STATS
+		heap_stats_dump(stdout, label, &heap.stats);
+#else
+		(void) label;
+#endif
+	}
+};
+
+/* ciheap.h: index-linked nodes in one array, keys stored in the node */
+class ciheap_backend {
+	struct ciheap			heap;
+	struct ciheap_arena&		arena;
+	/* indexed by node, like the arena */
+	std::vector<size_t>&		tags;
+	std::vector<uint32_t>		scratch;
+
+public:
+	typedef uint32_t handle;
+	static const bool addressable = true;
+	static const char* name() { return "ciheap.h"; }
+
+	ciheap_backend(struct ciheap_arena& a, std::vector<size_t>& t)
+		: arena(a), tags(t)
+	{
+		ciheap_init(&heap, &arena);
+	}
+
+	~ciheap_backend()
+	{
+		while (!empty())
+			take();
+	}
+
+	bool empty() { return ciheap_empty(&heap); }
+
+	handle insert(int key)
+	{
+		handle h = ciheap_node_alloc(&arena, key, 0);
+		ciheap_insert(&heap, h);
+		return h;
+	}
+
+	int take()
+	{
+		handle h = ciheap_take(&heap);
+		int key = ciheap_node_key(&arena, h);
+		ciheap_node_free(&arena, h);
+		return key;
+	}
+
+	void build(const int* keys, size_t n, bool sorted)
+	{
+		scratch.resize(n);
+		for (size_t i = 0; i < n; i++)
+			scratch[i] = ciheap_node_alloc(&arena, keys[i], 0);
+		if (sorted)
+			ciheap_build_sorted(&heap, &scratch[0], n);
+		else
+			ciheap_build(&heap, &scratch[0], n);
+	}
+
+	void merge(ciheap_backend& other)
+	{
+		ciheap_union(&heap, &other.heap);
+	}
+
+	int key(handle h) { return ciheap_node_key(&arena, h); }
+
+	size_t& tag(handle h)
+	{
+		if (h >= tags.size())
+			tags.resize(arena.capacity);
+		return tags[h];
+	}
+
+	handle top() { return ciheap_peek(&heap); }
+
+	void decrease(handle h, int key)
+	{
+		ciheap_decrease(&heap, h, key);
+	}
+
+	void remove(handle h)
+	{
+		ciheap_delete(&heap, h);
+		ciheap_node_free(&arena, h);
+	}
+
+	void dump_stats(const char* label)
+	{
+#ifdef HEAP_STATS
+		heap_stats_dump(stdout, label, &heap.stats);
+#else
+		(void) label;
+#endif
+	}
+};
+
+/* binomial_heap.hpp: inlined comparator, keys stored in the node */
+class binomial_heap_backend {
+	binomial_heap<int> heap;
+
+public:
+	typedef int handle;
+	static const bool addressable = false;
+	static const char* name() { return "binomial_heap"; }
+
+	bool empty() { return heap.empty(); }
+	handle insert(int key) { heap.push(key); return 0; }
+	int take() { return heap.take(); }
+	void merge(binomial_heap_backend& other) { heap.merge(other.heap); }
+
+	void build(const int* keys, size_t n, bool)
+	{
+		for (size_t i = 0; i < n; i++)
+			heap.push(keys[i]);
+	}
+
+	int key(handle) { return 0; }
+	size_t& tag(handle) { static size_t dummy; return dummy; }
+	handle top() { return 0; }
+	void decrease(handle, int) {}
+	void remove(handle) {}
+	void dump_stats(const char*) {}
+};
+
+/* std::priority_queue: union degenerates to repeated insertion */
+class std_pq_backend {
+	std::priority_queue<int, std::vector<int>, std::greater<int> > heap;
+
+public:
+	typedef int handle;
+	static const bool addressable = false;
+	static const char* name() { return "std::priority_queue"; }
+
+	bool empty() { return heap.empty(); }
+	handle insert(int key) { heap.push(key); return 0; }
+
+	int take()
+	{
+		int key = heap.top();
+		heap.pop();
+		return key;
+	}
+
+	void build(const int* keys, size_t n, bool)
+	{
+		std::vector<int> v(keys, keys + n);
+		heap = std::priority_queue<int, std::vector<int>,
+					   std::greater<int> >(
+			std::greater<int>(), std::move(v));
+	}
+
+	void merge(std_pq_backend& other)
+	{
+		while (!other.empty())
+			insert(other.take());
+	}
+
+	int key(handle) { return 0; }
+	size_t& tag(handle) { static size_t dummy; return dummy; }
+	handle top() { return 0; }
+	void decrease(handle, int) {}
+	void remove(handle) {}
+	void dump_stats(const char*) {}
+};
+
+/* Addressable binary heap: the textbook baseline for decrease-key. */
+class binary_backend {
+	struct item {
+		int	key;
+		size_t	pos;
+		size_t	tag;
+	};
+
+	std::vector<item*>	heap;
+	freelist<item>&		items;
+
+	void place(size_t pos, item* it)
+	{
+		heap[pos] = it;
+		it->pos   = pos;
+	}
+
+	void sift_up(size_t pos)
+	{
+		item* it = heap[pos];
+		while (pos > 0 && it->key < heap[(pos - 1) / 2]->key) {
+			place(pos, heap[(pos - 1) / 2]);
+			pos = (pos - 1) / 2;
+		}
+		place(pos, it);
+	}
+
+	void sift_down(size_t pos)
+	{
+		item* it = heap[pos];
+		size_t n = heap.size(), child;
+		while ((child = 2 * pos + 1) < n) {
+			if (child + 1 < n && heap[child + 1]->key < heap[child]->key)
+				child++;
+			if (!(heap[child]->key < it->key))
+				break;
+			place(pos, heap[child]);
+			pos = child;
+		}
+		place(pos, it);
+	}
+
+	void remove_at(size_t pos)
+	{
+		item* last = heap.back();
+		heap.pop_back();
+		if (pos < heap.size()) {
+			place(pos, last);
+			sift_down(pos);
+			sift_up(last->pos);
+		}
+	}
+
+public:
+	typedef item* handle;
+	static const bool addressable = true;
+	static const char* name() { return "binary heap"; }
+
+	explicit binary_backend(freelist<item>& i) : items(i) {}
+
+	~binary_backend()
+	{
+		while (!empty())
+			take();
+	}
+
+	bool empty() { return heap.empty(); }
+
+	handle insert(int key)
+	{
+		item* it = items.get();
+		it->key = key;
+		heap.push_back(it);
+		sift_up(heap.size() - 1);
+		return it;
+	}
+
+	int take()
+	{
+		item* it = heap[0];
+		int key = it->key;
+		remove_at(0);
+		items.put(it);
+		return key;
+	}
+
+	void build(const int* keys, size_t n, bool sorted)
+	{
+		item* it;
+		for (size_t i = 0; i < n; i++) {
+			it = items.get();
+			it->key = keys[i];
+			heap.push_back(it);
+			it->pos = i;
+		}
+		/* increasing keys already satisfy the heap property */
+		if (!sorted)
+			for (size_t i = n / 2; i-- > 0; )
+				sift_down(i);
+	}
+
+	void merge(binary_backend& other)
+	{
+		while (!other.empty())
+			insert(other.take());
+	}
+
+	int key(handle h) { return h->key; }
+	size_t& tag(handle h) { return h->tag; }
+	handle top() { return heap[0]; }
+
+	void decrease(handle h, int key)
+	{
+		h->key = key;
+		sift_up(h->pos);
+	}
+
+	void remove(handle h)
+	{
+		remove_at(h->pos);
+		items.put(h);
+	}
+
+	void dump_stats(const char*) {}
+
+	typedef freelist<item> item_list;
+};
+
+/* ------------------------------------------------------------------------ *
+ * Measurement
+ * ------------------------------------------------------------------------ */
+
+enum op_kind {
+	OP_INSERT,
+	OP_TAKE,
+	OP_UNION,
+	OP_DECREASE,
+	OP_DELETE,
+	OP_BUILD,
+	NUM_OPS
+};
+
+static const char* op_names[NUM_OPS] = {
+	"insert", "take", "union", "decrease", "delete", "build"
+};
+
+/* With TIMED == false, the recorder only counts operations. */
+template <bool TIMED>
+struct recorder {
+	std::vector<unsigned int>	samples[NUM_OPS];
+	unsigned long			count;
+	bench_clock::time_point		start;
+	/* set once the heap has been populated */
+	bench_clock::time_point		t0;
+
+	bench_clock::time_point		t1;
+
+	recorder() : count(0) {}
+
+	void go()
+	{
+		t0 = bench_clock::now();
+	}
+
+	void stop()
+	{
+		t1 = bench_clock::now();
+	}
+
+	void begin()
+	{
+		if (TIMED)
+			start = bench_clock::now();
+	}
+
+	/* an operation on several elements at once counts as weight ops */
+	void end(op_kind op, unsigned long weight = 1)
+	{
+		long ns;
+		count += weight;
+		if (TIMED) {
+			ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+				bench_clock::now() - start).count();
+			samples[op].push_back((unsigned int) (ns / weight));
+		}
+	}
+};
+
+struct config {
+	unsigned long	ops;
+	/* decreases per take in the decrease workload */
+	unsigned long	ratio;
+	/* keys per take in the many workload */
+	unsigned long	batch;
+	unsigned long	seed;
+};
+
+/* Sum of taken keys; printed so that the work cannot be optimized away. */
+static unsigned long long checksum;
+
+template <typename B, bool TIMED>
+static void hold(B& heap, size_t n, const config& cfg, recorder<TIMED>& rec)
+{
+	rng r(cfg.seed);
+	int key;
+
+	for (size_t i = 0; i < n; i++)
+		heap.insert(r.key());
+	rec.go();
+	while (rec.count < cfg.ops) {
+		rec.begin();
+		key = heap.take();
+		rec.end(OP_TAKE);
+		checksum += key;
+		key += r.below(HOLD_INCREMENT);
+		rec.begin();
+		heap.insert(key);
+		rec.end(OP_INSERT);
+	}
+}
+
+template <typename B, bool TIMED>
+static void burst(B& heap, size_t n, const config& cfg, recorder<TIMED>& rec)
+{
+	rng r(cfg.seed);
+	int key;
+	size_t i;
+
+	rec.go();
+	while (rec.count < cfg.ops) {
+		for (i = 0; i < n; i++) {
+			key = r.key();
+			rec.begin();
+			heap.insert(key);
+			rec.end(OP_INSERT);
+		}
+		for (i = 0; i < n; i++) {
+			rec.begin();
+			key = heap.take();
+			rec.end(OP_TAKE);
+			checksum += key;
+		}
+	}
+}
+
+template <typename B, bool TIMED>
+static void build(B& heap, size_t n, const config& cfg, recorder<TIMED>& rec,
+		  bool sorted)
+{
+	rng r(cfg.seed);
+	std::vector<int> keys(n);
+	size_t i;
+
+	rec.go();
+	while (rec.count < cfg.ops) {
+		for (i = 0; i < n; i++)
+			keys[i] = r.key();
+		if (sorted)
+			std::sort(keys.begin(), keys.end());
+		rec.begin();
+		heap.build(&keys[0], n, sorted);
+		rec.end(OP_BUILD, n);
+		for (i = 0; i < n; i++) {
+			rec.begin();
+			checksum += heap.take();
+			rec.end(OP_TAKE);
+		}
+	}
+}
+
+/* heap.h and iheap.h take batches natively; the others take one by one */
+template <typename B> struct native_take_many {
+	static const bool value = std::is_base_of<heap_backend, B>::value ||
+				  std::is_base_of<iheap_backend, B>::value;
+};
+
+template <typename B, bool NATIVE = native_take_many<B>::value>
+struct take_many_op {
+	static size_t run(B& heap, int* keys, size_t k)
+	{
+		size_t i = 0;
+		while (i < k && !heap.empty())
+			keys[i++] = heap.take();
+		return i;
+	}
+};
+
+template <typename B> struct take_many_op<B, true> {
+	static size_t run(B& heap, int* keys, size_t k)
+	{
+		return heap.take_many(keys, k);
+	}
+};
+
+template <typename B, bool TIMED>
+static void many(B& heap, size_t n, const config& cfg, recorder<TIMED>& rec)
+{
+	rng r(cfg.seed);
+	std::vector<int> keys(cfg.batch);
+	size_t i, got;
+
+	for (i = 0; i < n; i++)
+		heap.insert(r.key());
+	rec.go();
+	while (rec.count < cfg.ops) {
+		rec.begin();
+		got = take_many_op<B>::run(heap, &keys[0], keys.size());
+		rec.end(OP_TAKE, got);
+		/* keys come out in order; stay at or above the last one so
+		 * that the keys remain monotone, as in hold */
+		for (i = 0; i < got; i++) {
+			checksum += keys[i];
+			rec.begin();
+			heap.insert(keys[got - 1] + r.below(HOLD_INCREMENT));
+			rec.end(OP_INSERT);
+		}
+	}
+}
+
+template <typename B, bool TIMED>
+static void merge(B& heap, B& small, size_t n, const config& cfg,
+		  recorder<TIMED>& rec)
+{
+	rng r(cfg.seed);
+	int i;
+
+	for (size_t j = 0; j < n; j++)
+		heap.insert(r.key());
+	rec.go();
+	while (rec.count < cfg.ops) {
+		for (i = 0; i < BATCH; i++)
+			small.insert(r.key());
+		rec.begin();
+		heap.merge(small);
+		rec.end(OP_UNION);
+		for (i = 0; i < BATCH; i++) {
+			rec.begin();
+			checksum += heap.take();
+			rec.end(OP_TAKE);
+		}
+	}
+}
+
+/* 40% decrease-key, 20% delete + insert, 40% take + insert */
+template <typename B, bool TIMED>
+static void update(B& heap, size_t n, const config& cfg, recorder<TIMED>& rec)
+{
+	rng r(cfg.seed);
+	std::vector<typename B::handle> live;
+	typename B::handle h;
+	size_t idx;
+	int key, dice;
+
+	for (size_t i = 0; i < n; i++) {
+		live.push_back(heap.insert(r.key()));
+		heap.tag(live.back()) = i;
+	}
+	rec.go();
+	while (rec.count < cfg.ops) {
+		dice = r.below(10);
+		if (dice < 4) {
+			h   = live[(size_t) r.below((int) live.size())];
+			key = heap.key(h) - r.below(HOLD_INCREMENT) - 1;
+			rec.begin();
+			heap.decrease(h, key);
+			rec.end(OP_DECREASE);
+			continue;
+		} else if (dice < 6) {
+			idx = (size_t) r.below((int) live.size());
+			rec.begin();
+			heap.remove(live[idx]);
+			rec.end(OP_DELETE);
+		} else {
+			idx = heap.tag(heap.top());
+			rec.begin();
+			checksum += heap.take();
+			rec.end(OP_TAKE);
+		}
+		key = r.key();
+		rec.begin();
+		h = heap.insert(key);
+		rec.end(OP_INSERT);
+		heap.tag(h) = idx;
+		live[idx]   = h;
+	}
+}
+
+/* take + insert, then cfg.ratio decrease-keys to just above the minimum, as
+ * relaxing the edges of the vertex just taken does in Dijkstra's algorithm
+ */
+template <typename B, bool TIMED>
+static void decrease(B& heap, size_t n, const config& cfg,
+		     recorder<TIMED>& rec)
+{
+	rng r(cfg.seed);
+	std::vector<typename B::handle> live;
+	typename B::handle h;
+	size_t idx;
+	int key, min;
+
+	for (size_t i = 0; i < n; i++) {
+		live.push_back(heap.insert(r.key()));
+		heap.tag(live.back()) = i;
+	}
+	rec.go();
+	while (rec.count < cfg.ops) {
+		idx = heap.tag(heap.top());
+		rec.begin();
+		min = heap.take();
+		rec.end(OP_TAKE);
+		checksum += min;
+		key = min + r.below(HOLD_INCREMENT);
+		rec.begin();
+		h = heap.insert(key);
+		rec.end(OP_INSERT);
+		heap.tag(h) = idx;
+		live[idx]   = h;
+		for (unsigned long i = 0; i < cfg.ratio; i++) {
+			h   = live[(size_t) r.below((int) live.size())];
+			key = min + r.below(HOLD_INCREMENT);
+			if (key >= heap.key(h))
+				continue;
+			rec.begin();
+			heap.decrease(h, key);
+			rec.end(OP_DECREASE);
+		}
+	}
+}
+
+/* Builds a fresh backend instance together with its node storage. */
+template <typename B> struct factory;
+
+template <> struct factory<heap_backend> {
+	struct heap_pool nodes;
+	freelist<struct heap_item> items;
+	factory() { heap_pool_init(&nodes, sizeof(struct heap_node)); }
+	~factory() { heap_pool_destroy(&nodes); }
+	heap_backend* make() { return new heap_backend(nodes, items); }
+};
+
+template <> struct factory<iheap_backend> {
+	struct heap_pool nodes;
+	freelist<struct iheap_slot> slots;
+	factory() { heap_pool_init(&nodes, sizeof(struct iheap_node)); }
+	~factory() { heap_pool_destroy(&nodes); }
+	iheap_backend* make() { return new iheap_backend(nodes, slots); }
+};
+
+template <> struct factory<lazy_heap_backend> {
+	struct heap_pool nodes;
+	freelist<struct heap_item> items;
+	factory() { heap_pool_init(&nodes, sizeof(struct heap_node)); }
+	~factory() { heap_pool_destroy(&nodes); }
+	lazy_heap_backend* make() { return new lazy_heap_backend(nodes, items); }
+};
+
+template <> struct factory<lazy_iheap_backend> {
+	struct heap_pool nodes;
+	freelist<struct iheap_slot> slots;
+	factory() { heap_pool_init(&nodes, sizeof(struct iheap_node)); }
+	~factory() { heap_pool_destroy(&nodes); }
+	lazy_iheap_backend* make()
+	{
+		return new lazy_iheap_backend(nodes, slots);
+	}
+};
+
+template <> struct factory<relink_heap_backend> {
+	struct heap_pool nodes;
+	freelist<struct heap_item> items;
+	factory() { heap_pool_init(&nodes, sizeof(struct heap_node)); }
+	~factory() { heap_pool_destroy(&nodes); }
+	relink_heap_backend* make()
+	{
+		return new relink_heap_backend(nodes, items);
+	}
+};
+
+template <> struct factory<relink_iheap_backend> {
+	struct heap_pool nodes;
+	freelist<struct iheap_slot> slots;
+	factory() { heap_pool_init(&nodes, sizeof(struct iheap_node)); }
+	~factory() { heap_pool_destroy(&nodes); }
+	relink_iheap_backend* make()
+	{
+		return new relink_iheap_backend(nodes, slots);
+	}
+};
+
+template <> struct factory<sheap_backend> {
+	struct heap_pool nodes;
+	freelist<struct sheap_item> items;
+	factory() { heap_pool_init(&nodes, sizeof(struct sheap_node)); }
+	~factory() { heap_pool_destroy(&nodes); }
+	sheap_backend* make() { return new sheap_backend(nodes, items); }
+};
+
+template <> struct factory<riheap_backend> {
+	struct heap_pool nodes;
+	freelist<struct iheap_slot> slots;
+	factory() { heap_pool_init(&nodes, sizeof(struct iheap_node)); }
+	~factory() { heap_pool_destroy(&nodes); }
+	riheap_backend* make() { return new riheap_backend(nodes, slots); }
+};
+
+template <> struct factory<fiheap_backend> {
+	struct heap_pool nodes;
+	freelist<struct fiheap_slot> slots;
+	factory() { heap_pool_init(&nodes, sizeof(struct fiheap_node)); }
+	~factory() { heap_pool_destroy(&nodes); }
+	fiheap_backend* make() { return new fiheap_backend(nodes, slots); }
+};
+
+template <> struct factory<rheap_backend> {
+	struct heap_pool nodes;
+	freelist<struct rheap_slot> slots;
+	factory() { heap_pool_init(&nodes, sizeof(struct rheap_node)); }
+	~factory() { heap_pool_destroy(&nodes); }
+	rheap_backend* make() { return new rheap_backend(nodes, slots); }
+};
+
+template <> struct factory<ciheap_backend> {
+	struct ciheap_arena arena;
+	std::vector<size_t> tags;
+	factory() { ciheap_arena_init(&arena); }
+	~factory() { ciheap_arena_destroy(&arena); }
+	ciheap_backend* make() { return new ciheap_backend(arena, tags); }
+};
+
+template <> struct factory<binomial_heap_backend> {
+	binomial_heap_backend* make() { return new binomial_heap_backend(); }
+};
+
+template <> struct factory<std_pq_backend> {
+	std_pq_backend* make() { return new std_pq_backend(); }
+};
+
+template <> struct factory<binary_backend> {
+	binary_backend::item_list items;
+	binary_backend* make() { return new binary_backend(items); }
+};
+
+/* Backends that reject keys below the last minimum taken cannot run union
+ * and update, which insert and decrease to random keys.
+ */
+template <typename B> struct monotone_only {
+	static const bool value = false;
+};
+
+template <> struct monotone_only<rheap_backend> {
+	static const bool value = true;
+};
+
+template <typename B, bool TIMED>
+static bool run_once(const std::string& workload, size_t n, const config& cfg,
+		     recorder<TIMED>& rec)
+{
+	factory<B> f;
+	B* heap  = f.make();
+	B* small = f.make();
+	bool ok  = true;
+
+	if (monotone_only<B>::value &&
+	    (workload == "union" || workload == "update"))
+		ok = false;
+	else if (workload == "hold")
+		hold(*heap, n, cfg, rec);
+	else if (workload == "burst")
+		burst(*heap, n, cfg, rec);
+	else if (workload == "build")
+		build(*heap, n, cfg, rec, false);
+	else if (workload == "sorted")
+		build(*heap, n, cfg, rec, true);
+	else if (workload == "union")
+		merge(*heap, *small, n, cfg, rec);
+	else if (workload == "many")
+		many(*heap, n, cfg, rec);
+	else if (workload == "update" && B::addressable)
+		update(*heap, n, cfg, rec);
+	else if (workload == "decrease" && B::addressable)
+		decrease(*heap, n, cfg, rec);
+	else
+		ok = false;
+	rec.stop();
+	if (ok && !TIMED) {
+		std::string label = "# stats " + workload + " " +
+			B::name() + " " + std::to_string(n);
+		heap->dump_stats(label.c_str());
+	}
+	delete small;
+	delete heap;
+	return ok;
+}
+
+static unsigned int percentile(std::vector<unsigned int>& v, double p)
+{
+	size_t idx = (size_t) (p * (double) (v.size() - 1));
+	std::nth_element(v.begin(), v.begin() + idx, v.end());
+	return v[idx];
+}
+
+template <typename B>
+static void run(const std::string& workload, size_t n, const config& cfg)
+{
+	recorder<false> quick;
+	recorder<true>  timed;
+	double total, mean;
+	std::vector<unsigned int>* s;
+
+	if (!run_once<B>(workload, n, cfg, quick)) {
+		printf("%-8s %-20s %10lu  (not supported)\n",
+		       workload.c_str(), B::name(), (unsigned long) n);
+		return;
+	}
+	total = (double) std::chrono::duration_cast<std::chrono::nanoseconds>(
+		quick.t1 - quick.t0).count();
+	printf("%-8s %-20s %10lu  %-8s %9.1f\n",
+	       workload.c_str(), B::name(), (unsigned long) n, "total",
+	       total / (double) quick.count);
+
+	run_once<B>(workload, n, cfg, timed);
+	for (int op = 0; op < NUM_OPS; op++) {
+		s = &timed.samples[op];
+		if (s->empty())
+			continue;
+		mean = 0;
+		for (size_t i = 0; i < s->size(); i++)
+			mean += (*s)[i];
+		mean /= (double) s->size();
+		printf("%-8s %-20s %10lu  %-8s %9.1f %8u %8u %8u\n",
+		       workload.c_str(), B::name(), (unsigned long) n,
+		       op_names[op], mean,
+		       percentile(*s, 0.5), percentile(*s, 0.99),
+		       percentile(*s, 0.999));
+	}
+	fflush(stdout);
+}
+
+/* median cost of an empty begin()/end() pair */
+static unsigned int clock_overhead(void)
+{
+	recorder<true> rec;
+	for (int i = 0; i < 100000; i++) {
+		rec.begin();
+		rec.end(OP_INSERT);
+	}
+	return percentile(rec.samples[OP_INSERT], 0.5);
+}
+
+static std::vector<std::string> split(const char* arg)
+{
+	std::vector<std::string> out;
+	std::string cur;
+	for (const char* c = arg; *c; c++) {
+		if (*c == ',') {
+			out.push_back(cur);
+			cur.clear();
+		} else
+			cur += *c;
+	}
+	out.push_back(cur);
+	return out;
+}
+
+static bool wanted(const std::vector<std::string>& list, const char* name)
+{
+	return list.empty() ||
+		std::find(list.begin(), list.end(), name) != list.end();
+}
+
+static void usage(const char* prog)
+{
+	fprintf(stderr,
+		"usage: %s [-w workload,...] [-b backend,...] [-n size,...] "
+		"[-o ops] [-r ratio] [-k batch] [-s seed]\n"
+		"  workloads: hold burst build sorted many union update "
+		"decrease\n"
+		"  backends:  heap heap-lazy heap-relink iheap iheap-lazy "
+		"iheap-relink\n"
+		"             sheap riheap fiheap rheap ciheap binomial_heap "
+		"std binary\n"
+		"  sizes default to 1e2,1e3,...,1e7; ops default to 1e6\n",
+		prog);
+	exit(1);
+}
+
+int main(int argc, char** argv)
+{
+	std::vector<std::string> workloads, backends, sizes;
+	std::vector<size_t> ns;
+	config cfg;
+	size_t n;
+	int i;
+
+	cfg.ops   = 1000000;
+	cfg.ratio = 10;
+	cfg.batch = 64;
+	cfg.seed  = 42;
+	for (i = 1; i < argc; i++) {
+		if (i + 1 == argc)
+			usage(argv[0]);
+		if (!strcmp(argv[i], "-w"))
+			workloads = split(argv[++i]);
+		else if (!strcmp(argv[i], "-b"))
+			backends = split(argv[++i]);
+		else if (!strcmp(argv[i], "-n"))
+			sizes = split(argv[++i]);
+		else if (!strcmp(argv[i], "-o"))
+			cfg.ops = (unsigned long) atof(argv[++i]);
+		else if (!strcmp(argv[i], "-r"))
+			cfg.ratio = strtoul(argv[++i], NULL, 0);
+		else if (!strcmp(argv[i], "-k"))
+			cfg.batch = strtoul(argv[++i], NULL, 0);
+		else if (!strcmp(argv[i], "-s"))
+			cfg.seed = strtoul(argv[++i], NULL, 0);
+		else
+			usage(argv[0]);
+	}
+	if (!cfg.batch)
+		usage(argv[0]);
+	if (workloads.empty())
+		workloads = split("hold,burst,build,sorted,many,union,"
+				  "update,decrease");
+	if (sizes.empty())
+		sizes = split("1e2,1e3,1e4,1e5,1e6,1e7");
+	for (i = 0; i < (int) sizes.size(); i++) {
+		n = (size_t) atof(sizes[i].c_str());
+		if (!n)
+			usage(argv[0]);
+		ns.push_back(n);
+	}
+
+	printf("# clock overhead: %u ns per timed operation\n",
+	       clock_overhead());
+	printf("%-8s %-20s %10s  %-8s %9s %8s %8s %8s\n",
+	       "workload", "backend", "n", "op", "ns/op",
+	       "p50", "p99", "p999");
+	for (size_t w = 0; w < workloads.size(); w++)
+		for (size_t j = 0; j < ns.size(); j++) {
+			if (wanted(backends, "heap"))
+				run<heap_backend>(workloads[w], ns[j], cfg);
+			if (wanted(backends, "heap-lazy"))
+				run<lazy_heap_backend>(workloads[w], ns[j],
+						       cfg);
+			if (wanted(backends, "heap-relink"))
+				run<relink_heap_backend>(workloads[w], ns[j],
+							 cfg);
+			if (wanted(backends, "iheap"))
+				run<iheap_backend>(workloads[w], ns[j], cfg);
+			if (wanted(backends, "iheap-lazy"))
+				run<lazy_iheap_backend>(workloads[w], ns[j],
+							cfg);
+			if (wanted(backends, "iheap-relink"))
+				run<relink_iheap_backend>(workloads[w], ns[j],
+							  cfg);
+			if (wanted(backends, "sheap"))
+				run<sheap_backend>(workloads[w], ns[j], cfg);
+			if (wanted(backends, "riheap"))
+				run<riheap_backend>(workloads[w], ns[j], cfg);
+			if (wanted(backends, "fiheap"))
+				run<fiheap_backend>(workloads[w], ns[j], cfg);
+			if (wanted(backends, "rheap"))
+				run<rheap_backend>(workloads[w], ns[j], cfg);
+			if (wanted(backends, "ciheap"))
+				run<ciheap_backend>(workloads[w], ns[j], cfg);
+			if (wanted(backends, "binomial_heap"))
+				run<binomial_heap_backend>(workloads[w],
+							   ns[j], cfg);
+			if (wanted(backends, "std"))
+				run<std_pq_backend>(workloads[w], ns[j], cfg);
+			if (wanted(backends, "binary"))
+				run<binary_backend>(workloads[w], ns[j], cfg);
+		}
+	fprintf(stderr, "checksum: %llu\n", checksum);
+	return 0;
+}
@@ -1,4 +1,4 @@
-#!/usr/bin/env python
+#!/usr/bin/env python3
 #
 # Copyright (c) 2008, Bjoern B. Brandenburg <bbb [at] cs.unc.edu>
 #
@@ -45,9 +45,16 @@ From Wikipedia:
 
   More details: http://en.wikipedia.org/wiki/Binomial_heap
 
-This implementation is based on the description in CLRS.
+This implementation is based on the description in CLRS. It runs on Python 3
+(and 2.7).
 """
 
+from __future__ import print_function
+
+import heapq
+import itertools
+import sys
+
 class ItemRef(object):
     """Reference to an item in the heap. Used for decreasing keys and deletion.
     Do not use this class directly; only use instances returned by
@@ -55,11 +62,16 @@ class ItemRef(object):
 
     You should only use ItemRef.delete() and ItemRef.decrease(new_priority).
     """
-    def __init__(self, node, get_heap):
+    __slots__ = ('ref', 'owner', 'in_tree')
+
+    def __init__(self, node, owner):
         self.ref      = node
-        self.get_heap = get_heap
+        self.owner    = owner
         self.in_tree  = True
 
+    def get_heap(self):
+        return self.owner.get_heap()
+
     def __str__(self):
         if self.in_tree:
             return "<BinomialHeap Reference to '%s'>" % str(self.ref.val)
@@ -103,21 +115,23 @@ class BinomialHeap(object):
     > H2 = BinomialHeap([(30, "quite"), (20, "is")])
     > H1 += H2
     > for x in H1:
-    >   print x,
+    >   print(x, end=' ')
      =>  "Merging is quite fast."
 
     """
 
     class Node(object):
         "Internal node of the heap. Don't use directly."
-        def __init__(self, get_heap, key, val=None):
+        __slots__ = ('degree', 'parent', 'next', 'child', 'key', 'ref', 'val')
+
+        def __init__(self, owner, key, val=None):
             self.degree = 0
             self.parent = None
             self.next   = None
             self.child  = None
             self.key    = key
-            self.ref    = ItemRef(self, get_heap)
-            if val == None:
+            self.ref    = ItemRef(self, owner)
+            if val is None:
                 val = key
             self.val    = val
 
@@ -200,6 +214,8 @@ class BinomialHeap(object):
             return h
 
     class __Ref(object):
+        __slots__ = ('heap', 'ref')
+
         def __init__(self, h):
             self.heap = h
             self.ref  = None
@@ -217,15 +233,12 @@ class BinomialHeap(object):
         """Populate a new heap with the (key, value) pairs in 'lst'.
         If the elements of lst are not subscriptable, then they are treated as
         opaque elements and inserted into the heap themselves.
+        Takes O(len(lst)) time.
         """
         self.head = None
         self.size = 0
         self.ref  = BinomialHeap.__Ref(self)
-        for x in lst:
-            try:
-                self.insert(x[0], x[1])
-            except TypeError:
-                self.insert(x)
+        self.insert_many(lst)
 
     def insert(self, key, value=None):
         """Insert 'value' in to the heap with priority 'key'. If 'value' is omitted,
@@ -233,11 +246,30 @@ class BinomialHeap(object):
         Returns a reference (of type ItemRef) to the internal node in the tree.
         Use this reference to delete the key or to change its priority.
         """
-        n = BinomialHeap.Node(self.ref.get_heap, key, value)
+        n = BinomialHeap.Node(self.ref, key, value)
         self.__union(n)
         self.size += 1
         return n.ref
 
+    def insert_many(self, lst):
+        """Insert the (key, value) pairs in 'lst', like __init__(), in
+        O(len(lst) + log n) time.
+        Returns a list of references (of type ItemRef), one per item.
+        """
+        trees = []
+        refs  = []
+        for x in lst:
+            try:
+                (key, value) = (x[0], x[1])
+            except TypeError:
+                (key, value) = (x, None)
+            n = BinomialHeap.Node(self.ref, key, value)
+            BinomialHeap.__carry(trees, n)
+            refs.append(n.ref)
+        self.__union(BinomialHeap.__collect(trees))
+        self.size += len(refs)
+        return refs
+
     def union(self, other):
         """Merge 'other' into 'self'. Returns None.
         Note: This is a destructive operation; 'other' is an empty heap afterwards.
@@ -276,9 +308,74 @@ class BinomialHeap(object):
             self.size -= 1
             return x.val
 
-    def __nonzero__(self):
+    def extract_many(self, k):
+        """Returns a list of the (at most) k values with the smallest keys
+        (= highest priorities) in the heap, in order, AND removes them from
+        the heap.
+        Cheaper than k calls to extract_min(): the roots are kept in a
+        binary heap, a removed root is replaced by its children, and the
+        remaining trees are linked only once.
+        """
+        # ties are broken by discovery order, so nodes are never compared
+        frontier = []
+        count    = 0
+        cur      = self.head
+        while cur:
+            heapq.heappush(frontier, (cur.key, count, cur))
+            count += 1
+            cur    = cur.next
+        vals = []
+        while frontier and len(vals) < k:
+            x   = heapq.heappop(frontier)[2]
+            cur = x.child
+            while cur:
+                cur.parent = None
+                heapq.heappush(frontier, (cur.key, count, cur))
+                count += 1
+                cur    = cur.next
+            x.ref.in_tree = False
+            vals.append(x.val)
+        # every candidate is the root of an intact tree
+        trees = []
+        for (_, _, x) in frontier:
+            BinomialHeap.__carry(trees, x)
+        self.head  = BinomialHeap.__collect(trees)
+        self.size -= len(vals)
+        return vals
+
+    def ordered(self):
+        """Returns a _non-destructive_ iterator over the values in the heap,
+        in order of increasing keys. The heap must not be changed while the
+        iterator is in use. The first k values cost O(k log k) time.
+        """
+        # ties are broken by discovery order, so nodes are never compared
+        frontier = []
+        count    = 0
+        cur      = self.head
+        while cur:
+            heapq.heappush(frontier, (cur.key, count, cur))
+            count += 1
+            cur    = cur.next
+        while frontier:
+            x   = heapq.heappop(frontier)[2]
+            cur = x.child
+            while cur:
+                heapq.heappush(frontier, (cur.key, count, cur))
+                count += 1
+                cur    = cur.next
+            yield x.val
+
+    def top(self, k):
+        """Returns a list of the (at most) k values with the smallest keys
+        (= highest priorities) in the heap, in order, without removing them.
+        """
+        return list(itertools.islice(self.ordered(), k))
+
+    def __bool__(self):
         """True if the heap is not empty; False otherwise."""
-        return self.head != None
+        return self.head is not None
+
+    __nonzero__ = __bool__
 
     def __iter__(self):
         """Returns a _destructive_ iterator over the values in the heap.
@@ -303,7 +400,7 @@ class BinomialHeap(object):
         self.union(other)
         return self
 
-    def next(self):
+    def __next__(self):
         """Returns the value with the minimum key (= highest priority) in the heap
         AND removes it from the heap; raises StopIteration if the heap is empty.
         """
@@ -312,11 +409,13 @@ class BinomialHeap(object):
         else:
             raise StopIteration
 
+    next = __next__
+
     def __contains__(self, ref):
         """Test whether a given reference 'ref' (of ItemRef) is in this heap.
         """
         if type(ref) != ItemRef:
-            raise TypeError, "Expected an ItemRef"
+            raise TypeError("Expected an ItemRef")
         else:
             return ref.in_heap(self)
 
@@ -335,6 +434,32 @@ class BinomialHeap(object):
             cur  = cur.next
         return (min, min_prev)
 
+    @staticmethod
+    def __carry(trees, x):
+        """Add the tree rooted at x to trees, where trees[d] holds the tree
+        of degree d, if any. Works like incrementing a binary counter.
+        """
+        x.next = None
+        while x.degree < len(trees) and trees[x.degree]:
+            y = trees[x.degree]
+            trees[x.degree] = None
+            if y.key < x.key:
+                x, y = y, x
+            x.link(y)
+        while len(trees) <= x.degree:
+            trees.append(None)
+        trees[x.degree] = x
+
+    @staticmethod
+    def __collect(trees):
+        "Turn trees into a root list, ordered by degree. Returns the head."
+        head = None
+        for x in reversed(trees):
+            if x:
+                x.next = head
+                head   = x
+        return head
+
     def __union(self, h2):
         if not h2:
             # nothing to do
@@ -352,7 +477,7 @@ class BinomialHeap(object):
                     (next.next and next.next.degree == x.degree):
                 prev = x
                 x    = next
-            elif x.key <= next.key:
+            elif not next.key < x.key:
                 # x becomes the root of next
                 x.next = next.next
                 x.link(next)
@@ -370,12 +495,24 @@ class BinomialHeap(object):
             next = x.next
         self.head = h1
 
+# Use the C implementation of the _bh module if it has been built.
+try:
+    from _bh import BinomialHeap, ItemRef
+except ImportError:
+    pass
+
 def heap(lst=[]):
     """Create a new heap. lst should be a sequence of (key, value) pairs.
     Shortcut for BinomialHeap(lst)
     """
     return BinomialHeap(lst)
 
+def heapify(lst):
+    """Create a new heap from the (key, value) pairs in lst in O(len(lst))
+    time. Equivalent to heap(lst).
+    """
+    return BinomialHeap(lst)
+
 if __name__ == "__main__":
     tokens1 = [(24, 'all'), (16, 'star'), (9, 'true.\nSinging'), (7, 'clear'),
                (25, 'praises'), (13, 'to'), (5, 'Heel'),
@@ -409,26 +546,28 @@ if __name__ == "__main__":
              h3.insert(666, "Blue Devils") ]
 
     ref = bad[0]
-    print "%s: \n\tin h1: %s\n\tin h2: %s\n\tin h3: %s" % \
-        (str(ref), ref in h1, ref in h2, ref in h3)
+    print("%s: \n\tin h1: %s\n\tin h2: %s\n\tin h3: %s" % \
+        (str(ref), ref in h1, ref in h2, ref in h3))
 
-    print "Merging h3 into h2..."
+    print("Merging h3 into h2...")
     h2 += h3
 
-    print "%s: \n\tin h1: %s\n\tin h2: %s\n\tin h3: %s" % \
-        (str(ref), ref in h1, ref in h2, ref in h3)
+    print("%s: \n\tin h1: %s\n\tin h2: %s\n\tin h3: %s" % \
+        (str(ref), ref in h1, ref in h2, ref in h3))
 
-    print "Merging h2 into h1..."
+    print("Merging h2 into h1...")
     h1 += h2
 
-    print "%s: \n\tin h1: %s\n\tin h2: %s\n\tin h3: %s" % \
-        (str(ref), ref in h1, ref in h2, ref in h3)
+    print("%s: \n\tin h1: %s\n\tin h2: %s\n\tin h3: %s" % \
+        (str(ref), ref in h1, ref in h2, ref in h3))
 
     t1ref.decrease(-1)
     t2ref.decrease(99)
 
     for ref in bad:
         ref.delete()
+    # like Python 2's "print x,": no space after a line break
+    sep = ''
     for x in h1:
-        print x,
-
+        sys.stdout.write(sep + x)
+        sep = '' if x.endswith('\n') else ' '
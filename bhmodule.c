@@ -0,0 +1,1278 @@
+/* bhmodule.c -- Binomial Heaps for Python, in C
+ *
+ * Copyright (c) 2008, Bjoern B. Brandenburg <bbb [at] cs.unc.edu>
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University of North Carolina nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY  COPYRIGHT OWNER AND CONTRIBUTERS ``AS IS'' AND
+ * ANY  EXPRESS OR  IMPLIED  WARRANTIES,  INCLUDING, BUT  NOT  LIMITED TO,  THE
+ * IMPLIED WARRANTIES  OF MERCHANTABILITY AND FITNESS FOR  A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO  EVENT SHALL THE  COPYRIGHT OWNER OR  CONTRIBUTERS BE
+ * LIABLE  FOR  ANY  DIRECT,   INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT  OF
+ * SUBSTITUTE GOODS  OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+ * INTERRUPTION)  HOWEVER CAUSED  AND ON  ANY THEORY  OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR  TORT (INCLUDING  NEGLIGENCE OR  OTHERWISE)
+ * ARISING IN ANY WAY  OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* The _bh extension module implements BinomialHeap and ItemRef with the same
+ * interface as bh.py, which imports them if the module has been built.
+ *
+ * The algorithms are those of iheap.h, but keys are arbitrary Python objects
+ * that are compared with <. Nodes are the ItemRef objects themselves and move
+ * by relinking, so a reference always stays with its item. A heap owns one
+ * reference to each of its nodes.
+ *
+ * Key comparisons may raise or run arbitrary code. If a comparison raises,
+ * the current operation still leaves a structurally valid heap behind (though
+ * possibly out of order) and then reports the exception. A heap cannot be
+ * changed from within one of its own key comparisons.
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <limits.h>
+
+#define NOT_IN_HEAP UINT_MAX
+
+/* upper bound on the degree of any node; requires <limits.h> */
+#define HEAP_MAX_DEGREE (sizeof(size_t) * CHAR_BIT)
+
+/* Like bh.py's BinomialHeap.__Ref: nodes remember the heap that they were
+ * inserted into through an owner, and a union forwards the addition's owner
+ * to the target's.
+ */
+struct bh_owner {
+	Py_ssize_t		refs;
+	struct bh_owner*	forward;
+	/* NULL once the heap is gone or has been merged into another */
+	struct bh_heap*		heap;
+};
+
+struct bh_node {
+	PyObject_HEAD
+	struct bh_node*		parent;
+	struct bh_node*		next;
+	struct bh_node*		child;
+
+	unsigned int		degree;
+	PyObject*		key;
+	PyObject*		val;
+	/* NULL once the node has left its heap */
+	struct bh_owner*	owner;
+};
+
+struct bh_heap {
+	PyObject_HEAD
+	struct bh_node*		head;
+	Py_ssize_t		size;
+	struct bh_owner*	owner;
+	/* bumped by every change; checked by ordered() iterators */
+	unsigned long		version;
+	/* set while keys are compared */
+	int			busy;
+	/* set if a comparison raised */
+	int			error;
+};
+
+struct bh_iter {
+	PyObject_HEAD
+	struct bh_heap*		heap;
+	unsigned long		version;
+	/* binary heap of nodes whose parents have been yielded */
+	struct bh_node**	front;
+	size_t			n;
+	size_t			capacity;
+};
+
+static PyTypeObject bh_heap_type;
+static PyTypeObject bh_ref_type;
+static PyTypeObject bh_iter_type;
+
+#if PY_MAJOR_VERSION >= 3
+#define BH_STR_FROM_STRING PyUnicode_FromString
+#else
+#define BH_STR_FROM_STRING PyString_FromString
+#endif
+
+/* owners */
+
+static struct bh_owner* bh_owner_new(struct bh_heap* heap)
+{
+	struct bh_owner* owner = PyMem_Malloc(sizeof(struct bh_owner));
+	if (!owner) {
+		PyErr_NoMemory();
+		return NULL;
+	}
+	owner->refs    = 1;
+	owner->forward = NULL;
+	owner->heap    = heap;
+	return owner;
+}
+
+static void bh_owner_put(struct bh_owner* owner)
+{
+	struct bh_owner* forward;
+	while (owner && !--owner->refs) {
+		forward = owner->forward;
+		PyMem_Free(owner);
+		owner = forward;
+	}
+}
+
+/* follow (and compact) the forwarding chain */
+static struct bh_owner* bh_owner_resolve(struct bh_owner* owner)
+{
+	struct bh_owner* last;
+	if (!owner->forward)
+		return owner;
+	last = bh_owner_resolve(owner->forward);
+	if (last != owner->forward) {
+		last->refs++;
+		bh_owner_put(owner->forward);
+		owner->forward = last;
+	}
+	return last;
+}
+
+static struct bh_heap* bh_node_heap(struct bh_node* node)
+{
+	if (node->degree == NOT_IN_HEAP)
+		return NULL;
+	return bh_owner_resolve(node->owner)->heap;
+}
+
+/* the heap algorithms */
+
+/* all key comparisons go through here; after an error, nothing is compared */
+static int __bh_less(struct bh_heap* heap, struct bh_node* a,
+		     struct bh_node* b)
+{
+	int r;
+	if (heap->error || !a->key || !b->key)
+		return 0;
+	r = PyObject_RichCompareBool(a->key, b->key, Py_LT);
+	if (r < 0) {
+		heap->error = 1;
+		return 0;
+	}
+	return r;
+}
+
+/* make child a subtree of root */
+static void __bh_link(struct bh_node* root, struct bh_node* child)
+{
+	child->parent = root;
+	child->next   = root->child;
+	root->child   = child;
+	root->degree++;
+}
+
+/* merge root lists */
+static struct bh_node* __bh_merge(struct bh_node* a, struct bh_node* b)
+{
+	struct bh_node* head = NULL;
+	struct bh_node** pos = &head;
+
+	while (a && b) {
+		if (a->degree < b->degree) {
+			*pos = a;
+			a = a->next;
+		} else {
+			*pos = b;
+			b = b->next;
+		}
+		pos = &(*pos)->next;
+	}
+	if (a)
+		*pos = a;
+	else
+		*pos = b;
+	return head;
+}
+
+/* reverse a linked list of nodes. also clears parent pointer */
+static struct bh_node* __bh_reverse(struct bh_node* h)
+{
+	struct bh_node* tail = NULL;
+	struct bh_node* next;
+
+	if (!h)
+		return h;
+
+	h->parent = NULL;
+	while (h->next) {
+		next    = h->next;
+		h->next = tail;
+		tail    = h;
+		h       = next;
+		h->parent = NULL;
+	}
+	h->next = tail;
+	return h;
+}
+
+static void __bh_min(struct bh_heap* heap, struct bh_node** prev,
+		     struct bh_node** node)
+{
+	struct bh_node *_prev, *cur;
+	*prev = NULL;
+
+	if (!heap->head) {
+		*node = NULL;
+		return;
+	}
+	*node = heap->head;
+	_prev = heap->head;
+	cur   = heap->head->next;
+	while (cur) {
+		if (__bh_less(heap, cur, *node)) {
+			*node = cur;
+			*prev = _prev;
+		}
+		_prev = cur;
+		cur   = cur->next;
+	}
+}
+
+static void __bh_union(struct bh_heap* heap, struct bh_node* h2)
+{
+	struct bh_node* h1;
+	struct bh_node *prev, *x, *next;
+	if (!h2)
+		return;
+	h1 = heap->head;
+	if (!h1) {
+		heap->head = h2;
+		return;
+	}
+	h1 = __bh_merge(h1, h2);
+	prev = NULL;
+	x    = h1;
+	next = x->next;
+	while (next) {
+		if (x->degree != next->degree ||
+		    (next->next && next->next->degree == x->degree)) {
+			/* nothing to do, advance */
+			prev = x;
+			x    = next;
+		} else if (!__bh_less(heap, next, x)) {
+			/* x becomes the root of next */
+			x->next = next->next;
+			__bh_link(x, next);
+		} else {
+			/* next becomes the root of x */
+			if (prev)
+				prev->next = next;
+			else
+				h1 = next;
+			__bh_link(next, x);
+			x = next;
+		}
+		next = x->next;
+	}
+	heap->head = h1;
+}
+
+/* detach a node that has left the heap */
+static void __bh_release(struct bh_node* node)
+{
+	node->parent = NULL;
+	node->next   = NULL;
+	node->child  = NULL;
+	node->degree = NOT_IN_HEAP;
+	bh_owner_put(node->owner);
+	node->owner  = NULL;
+}
+
+/* Remove the node with the smallest key. The heap's reference to the node is
+ * handed to the caller.
+ */
+static struct bh_node* __bh_extract_min(struct bh_heap* heap)
+{
+	struct bh_node *prev, *node;
+	__bh_min(heap, &prev, &node);
+	if (!node)
+		return NULL;
+	if (prev)
+		prev->next = node->next;
+	else
+		heap->head = node->next;
+	__bh_union(heap, __bh_reverse(node->child));
+	__bh_release(node);
+	heap->size--;
+	heap->version++;
+	return node;
+}
+
+/* swap node with its parent by relinking both of them (see iheap.h) */
+static void __bh_lift(struct bh_heap* heap, struct bh_node* node)
+{
+	struct bh_node *parent = node->parent;
+	struct bh_node *pos, *tmp;
+	struct bh_node** link;
+	unsigned int degree;
+
+	/* node takes parent's place among parent's siblings... */
+	link = parent->parent ? &parent->parent->child : &heap->head;
+	while (*link != parent)
+		link = &(*link)->next;
+	*link = node;
+	/* ...and parent takes node's place among its own children */
+	link = &parent->child;
+	while (*link != node)
+		link = &(*link)->next;
+	*link = parent;
+
+	tmp            = node->next;
+	node->next     = parent->next;
+	parent->next   = tmp;
+	tmp            = node->child;
+	node->child    = parent->child;
+	parent->child  = tmp;
+	node->parent   = parent->parent;
+	degree         = node->degree;
+	node->degree   = parent->degree;
+	parent->degree = degree;
+	for (pos = node->child; pos; pos = pos->next)
+		pos->parent = node;
+	for (pos = parent->child; pos; pos = pos->next)
+		pos->parent = parent;
+}
+
+/* Remove node from the heap without moving any other node and return the
+ * remaining pieces of its tree as a root list ordered by degree (see iheap.h).
+ */
+static struct bh_node* __bh_cut(struct bh_heap* heap, struct bh_node* node)
+{
+	struct bh_node* path[HEAP_MAX_DEGREE];
+	struct bh_node *head = NULL, *root, *down, *pos, *next;
+	struct bh_node** link;
+	unsigned int depth = 0;
+
+	for (root = node; root->parent; root = root->parent)
+		path[depth++] = root;
+	link = &heap->head;
+	while (*link != root)
+		link = &(*link)->next;
+	*link = root->next;
+	while (depth--) {
+		down = path[depth];
+		/* children are ordered by decreasing degree */
+		for (pos = root->child; pos != down; pos = next) {
+			next        = pos->next;
+			pos->parent = NULL;
+			pos->next   = head;
+			head        = pos;
+		}
+		root->child  = down->next;
+		root->degree = down->degree;
+		root->next   = head;
+		head         = root;
+		down->parent = NULL;
+		root         = down;
+	}
+	for (pos = node->child; pos; pos = next) {
+		next        = pos->next;
+		pos->parent = NULL;
+		pos->next   = head;
+		head        = pos;
+	}
+	return head;
+}
+
+/* Take all nodes out of the heap and drop its references to them. */
+static void __bh_clear(struct bh_heap* heap)
+{
+	struct bh_node *pos, *tail, *tmp;
+
+	pos = heap->head;
+	heap->head = NULL;
+	heap->size = 0;
+	heap->version++;
+	/* Walk the forest without recursion: splice each node's children into
+	 * the list of nodes that remain to be released. */
+	while (pos) {
+		if (pos->child) {
+			for (tail = pos->child; tail->next; tail = tail->next)
+				;
+			tail->next = pos->next;
+			tmp = pos->child;
+		} else
+			tmp = pos->next;
+		__bh_release(pos);
+		Py_DECREF(pos);
+		pos = tmp;
+	}
+}
+
+/* Keys are compared in Python, which must not get to change the heap. */
+static int bh_enter(struct bh_heap* heap)
+{
+	if (heap->busy) {
+		PyErr_SetString(PyExc_RuntimeError,
+				"BinomialHeap changed during a key comparison");
+		return -1;
+	}
+	heap->busy = 1;
+	return 0;
+}
+
+/* returns -1 if a comparison raised */
+static int bh_leave(struct bh_heap* heap)
+{
+	heap->busy = 0;
+	if (heap->error) {
+		heap->error = 0;
+		return -1;
+	}
+	return 0;
+}
+
+/* ItemRef */
+
+static PyObject* bh_ref_str(PyObject* self)
+{
+	struct bh_node* node = (struct bh_node*) self;
+	PyObject *str, *res;
+
+	if (node->degree == NOT_IN_HEAP)
+		return BH_STR_FROM_STRING("<stale BinomialHeap Reference>");
+	str = PyObject_Str(node->val);
+	if (!str)
+		return NULL;
+#if PY_MAJOR_VERSION >= 3
+	res = PyUnicode_FromFormat("<BinomialHeap Reference to '%U'>", str);
+#else
+	res = PyString_FromFormat("<BinomialHeap Reference to '%s'>",
+				  PyString_AsString(str));
+#endif
+	Py_DECREF(str);
+	return res;
+}
+
+static PyObject* bh_ref_decrease(PyObject* self, PyObject* new_key)
+{
+	struct bh_node* node = (struct bh_node*) self;
+	struct bh_heap* heap = bh_node_heap(node);
+	PyObject* old;
+	int r;
+
+	if (!heap) {
+		PyErr_SetString(PyExc_ValueError,
+				"stale BinomialHeap Reference");
+		return NULL;
+	}
+	if (bh_enter(heap))
+		return NULL;
+	r = PyObject_RichCompareBool(new_key, node->key, Py_LT);
+	if (r <= 0) {
+		heap->busy = 0;
+		if (!r)
+			PyErr_SetString(PyExc_ValueError,
+					"new key must be smaller");
+		return NULL;
+	}
+	old = node->key;
+	Py_INCREF(new_key);
+	node->key = new_key;
+	Py_DECREF(old);
+	while (node->parent && __bh_less(heap, node, node->parent))
+		__bh_lift(heap, node);
+	heap->version++;
+	if (bh_leave(heap))
+		return NULL;
+	Py_RETURN_NONE;
+}
+
+static PyObject* bh_ref_delete(PyObject* self, PyObject* unused)
+{
+	struct bh_node* node = (struct bh_node*) self;
+	struct bh_heap* heap = bh_node_heap(node);
+	int r;
+
+	(void) unused;
+	if (!heap) {
+		PyErr_SetString(PyExc_ValueError,
+				"stale BinomialHeap Reference");
+		return NULL;
+	}
+	if (bh_enter(heap))
+		return NULL;
+	__bh_union(heap, __bh_cut(heap, node));
+	__bh_release(node);
+	heap->size--;
+	heap->version++;
+	r = bh_leave(heap);
+	/* drop the heap's reference last; this may run arbitrary code */
+	Py_DECREF(node);
+	if (r)
+		return NULL;
+	Py_RETURN_NONE;
+}
+
+static PyObject* bh_ref_in_heap(PyObject* self, PyObject* heap)
+{
+	return PyBool_FromLong(bh_node_heap((struct bh_node*) self) ==
+			       (struct bh_heap*) heap);
+}
+
+static PyObject* bh_ref_in_tree(PyObject* self, void* closure)
+{
+	(void) closure;
+	return PyBool_FromLong(((struct bh_node*) self)->degree !=
+			       NOT_IN_HEAP);
+}
+
+/* behaves like negative infinity */
+static PyObject* bh_ref_richcompare(PyObject* self, PyObject* other, int op)
+{
+	(void) self;
+	(void) other;
+	if (op == Py_LT)
+		Py_RETURN_TRUE;
+	if (op == Py_GT)
+		Py_RETURN_FALSE;
+	Py_INCREF(Py_NotImplemented);
+	return Py_NotImplemented;
+}
+
+static int bh_ref_traverse(PyObject* self, visitproc visit, void* arg)
+{
+	struct bh_node* node = (struct bh_node*) self;
+	Py_VISIT(node->key);
+	Py_VISIT(node->val);
+	return 0;
+}
+
+static int bh_ref_clear(PyObject* self)
+{
+	struct bh_node* node = (struct bh_node*) self;
+	Py_CLEAR(node->key);
+	Py_CLEAR(node->val);
+	return 0;
+}
+
+static void bh_ref_dealloc(PyObject* self)
+{
+	struct bh_node* node = (struct bh_node*) self;
+	PyObject_GC_UnTrack(self);
+	bh_ref_clear(self);
+	bh_owner_put(node->owner);
+	PyObject_GC_Del(self);
+}
+
+static PyMethodDef bh_ref_methods[] = {
+	{"decrease", bh_ref_decrease, METH_O,
+	 "Update the priority of the referenced item to a lower value."},
+	{"delete", bh_ref_delete, METH_NOARGS,
+	 "Remove the referenced item from the heap."},
+	{"in_heap", bh_ref_in_heap, METH_O,
+	 "Returns True if the referenced item is part of the BinomialHeap "
+	 "'heap';\nFalse otherwise."},
+	{NULL, NULL, 0, NULL}
+};
+
+static PyGetSetDef bh_ref_getset[] = {
+	{"in_tree", bh_ref_in_tree, NULL,
+	 "True while the referenced item is in a heap.", NULL},
+	{NULL, NULL, NULL, NULL, NULL}
+};
+
+static PyTypeObject bh_ref_type = {
+	PyVarObject_HEAD_INIT(NULL, 0)
+	.tp_name        = "_bh.ItemRef",
+	.tp_basicsize   = sizeof(struct bh_node),
+	.tp_dealloc     = bh_ref_dealloc,
+	.tp_str         = bh_ref_str,
+	.tp_flags       = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC,
+	.tp_doc         = "Reference to an item in the heap. Used for "
+			  "decreasing keys and deletion.\n"
+			  "Only use instances returned by "
+			  "BinomialHeap.insert()!",
+	.tp_traverse    = bh_ref_traverse,
+	.tp_clear       = bh_ref_clear,
+	.tp_richcompare = bh_ref_richcompare,
+	.tp_methods     = bh_ref_methods,
+	.tp_getset      = bh_ref_getset,
+};
+
+/* BinomialHeap */
+
+/* a new node that is not part of any heap yet, with a reference for heap */
+static struct bh_node* __bh_node_new(struct bh_heap* heap, PyObject* key,
+				     PyObject* val)
+{
+	struct bh_node* node = PyObject_GC_New(struct bh_node, &bh_ref_type);
+	if (!node)
+		return NULL;
+	node->parent = NULL;
+	node->next   = NULL;
+	node->child  = NULL;
+	node->degree = 0;
+	Py_INCREF(key);
+	node->key    = key;
+	if (val == Py_None)
+		val = key;
+	Py_INCREF(val);
+	node->val    = val;
+	node->owner  = heap->owner;
+	heap->owner->refs++;
+	PyObject_GC_Track((PyObject*) node);
+	return node;
+}
+
+static struct bh_node* bh_insert(struct bh_heap* heap, PyObject* key,
+				 PyObject* val)
+{
+	struct bh_node* node;
+
+	if (bh_enter(heap))
+		return NULL;
+	node = __bh_node_new(heap, key, val);
+	if (!node) {
+		heap->busy = 0;
+		return NULL;
+	}
+	/* one reference for the heap, one for the caller */
+	Py_INCREF(node);
+	__bh_union(heap, node);
+	heap->size++;
+	heap->version++;
+	if (bh_leave(heap)) {
+		Py_DECREF(node);
+		return NULL;
+	}
+	return node;
+}
+
+/* Linking trees into a degree-indexed array works like incrementing a binary
+ * counter (see iheap.h).
+ */
+static void __bh_carry(struct bh_heap* heap, struct bh_node** trees,
+		       struct bh_node* node)
+{
+	struct bh_node* other;
+	unsigned int d = node->degree;
+	while ((other = trees[d])) {
+		trees[d] = NULL;
+		if (__bh_less(heap, other, node)) {
+			__bh_link(other, node);
+			node = other;
+		} else
+			__bh_link(node, other);
+		d++;
+	}
+	trees[d] = node;
+}
+
+/* turn an array of trees into a root list, ordered by degree */
+static struct bh_node* __bh_collect(struct bh_node** trees)
+{
+	struct bh_node* head = NULL;
+	unsigned int d = HEAP_MAX_DEGREE;
+	while (d--)
+		if (trees[d]) {
+			trees[d]->next = head;
+			head = trees[d];
+		}
+	return head;
+}
+
+/* Insert the (key, value) pairs in lst in O(len(lst) + log n) time. Elements
+ * that are not subscriptable are inserted as opaque elements, like in bh.py.
+ * Returns a new list of the nodes if refs is set, and None otherwise.
+ */
+static PyObject* bh_insert_many(struct bh_heap* heap, PyObject* lst,
+				int refs)
+{
+	struct bh_node* trees[HEAP_MAX_DEGREE];
+	struct bh_node* node;
+	PyObject *it, *x, *key, *val, *res;
+	Py_ssize_t added = 0;
+	unsigned int d;
+	int r;
+
+	it = PyObject_GetIter(lst);
+	if (!it)
+		return NULL;
+	res = refs ? PyList_New(0) : Py_None;
+	if (!refs)
+		Py_INCREF(res);
+	if (!res || bh_enter(heap)) {
+		Py_XDECREF(res);
+		Py_DECREF(it);
+		return NULL;
+	}
+	for (d = 0; d < HEAP_MAX_DEGREE; d++)
+		trees[d] = NULL;
+	while ((x = PyIter_Next(it))) {
+		key = PySequence_GetItem(x, 0);
+		val = key ? PySequence_GetItem(x, 1) : NULL;
+		if (!val && PyErr_ExceptionMatches(PyExc_TypeError)) {
+			PyErr_Clear();
+			Py_XDECREF(key);
+			key = x;
+			Py_INCREF(key);
+			val = Py_None;
+			Py_INCREF(val);
+		}
+		node = key && val ? __bh_node_new(heap, key, val) : NULL;
+		Py_XDECREF(key);
+		Py_XDECREF(val);
+		Py_DECREF(x);
+		if (!node)
+			break;
+		__bh_carry(heap, trees, node);
+		added++;
+		if (refs && PyList_Append(res, (PyObject*) node))
+			break;
+	}
+	Py_DECREF(it);
+	/* keep whatever was added before an error */
+	__bh_union(heap, __bh_collect(trees));
+	heap->size += added;
+	heap->version++;
+	r = bh_leave(heap);
+	if (r || PyErr_Occurred()) {
+		Py_DECREF(res);
+		return NULL;
+	}
+	return res;
+}
+
+static PyObject* bh_heap_new(PyTypeObject* type, PyObject* args,
+			     PyObject* kwds)
+{
+	struct bh_heap* heap;
+
+	(void) args;
+	(void) kwds;
+	heap = (struct bh_heap*) type->tp_alloc(type, 0);
+	if (!heap)
+		return NULL;
+	heap->owner = bh_owner_new(heap);
+	if (!heap->owner) {
+		Py_DECREF(heap);
+		return NULL;
+	}
+	return (PyObject*) heap;
+}
+
+/* Populate a new heap with the (key, value) pairs in 'lst'. */
+static int bh_heap_init(PyObject* self, PyObject* args, PyObject* kwds)
+{
+	PyObject *lst = NULL, *res;
+	static char* kwlist[] = {"lst", NULL};
+
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "|O:BinomialHeap",
+					 kwlist, &lst))
+		return -1;
+	if (!lst)
+		return 0;
+	res = bh_insert_many((struct bh_heap*) self, lst, 0);
+	Py_XDECREF(res);
+	return res ? 0 : -1;
+}
+
+static int bh_heap_traverse(PyObject* self, visitproc visit, void* arg)
+{
+	struct bh_node* pos = ((struct bh_heap*) self)->head;
+	/* depth first, along the parent pointers */
+	while (pos) {
+		Py_VISIT(pos);
+		if (pos->child)
+			pos = pos->child;
+		else {
+			while (pos && !pos->next)
+				pos = pos->parent;
+			if (pos)
+				pos = pos->next;
+		}
+	}
+	return 0;
+}
+
+static int bh_heap_clear(PyObject* self)
+{
+	__bh_clear((struct bh_heap*) self);
+	return 0;
+}
+
+static void bh_heap_dealloc(PyObject* self)
+{
+	struct bh_heap* heap = (struct bh_heap*) self;
+	PyObject_GC_UnTrack(self);
+	__bh_clear(heap);
+	heap->owner->heap = NULL;
+	bh_owner_put(heap->owner);
+	Py_TYPE(self)->tp_free(self);
+}
+
+static PyObject* bh_heap_insert(PyObject* self, PyObject* args)
+{
+	PyObject *key, *val = Py_None;
+	if (!PyArg_UnpackTuple(args, "insert", 1, 2, &key, &val))
+		return NULL;
+	return (PyObject*) bh_insert((struct bh_heap*) self, key, val);
+}
+
+static PyObject* bh_heap_insert_many(PyObject* self, PyObject* lst)
+{
+	return bh_insert_many((struct bh_heap*) self, lst, 1);
+}
+
+static PyObject* bh_heap_union(PyObject* self, PyObject* arg)
+{
+	struct bh_heap* heap = (struct bh_heap*) self;
+	struct bh_heap* other;
+	struct bh_owner* owner;
+
+	if (!PyObject_TypeCheck(arg, &bh_heap_type)) {
+		PyErr_SetString(PyExc_TypeError, "Expected a BinomialHeap");
+		return NULL;
+	}
+	other = (struct bh_heap*) arg;
+	if (other == heap)
+		Py_RETURN_NONE;
+	if (other->busy) {
+		PyErr_SetString(PyExc_RuntimeError,
+				"BinomialHeap changed during a key comparison");
+		return NULL;
+	}
+	owner = bh_owner_new(other);
+	if (!owner || bh_enter(heap)) {
+		bh_owner_put(owner);
+		return NULL;
+	}
+	__bh_union(heap, other->head);
+	heap->size += other->size;
+	heap->version++;
+	/* this is a destructive merge */
+	other->head = NULL;
+	other->size = 0;
+	other->version++;
+	other->owner->heap    = NULL;
+	other->owner->forward = heap->owner;
+	heap->owner->refs++;
+	bh_owner_put(other->owner);
+	other->owner = owner;
+	if (bh_leave(heap))
+		return NULL;
+	Py_RETURN_NONE;
+}
+
+static PyObject* bh_heap_min(PyObject* self, PyObject* unused)
+{
+	struct bh_heap* heap = (struct bh_heap*) self;
+	struct bh_node *prev, *node;
+
+	(void) unused;
+	if (bh_enter(heap))
+		return NULL;
+	__bh_min(heap, &prev, &node);
+	if (bh_leave(heap))
+		return NULL;
+	if (!node)
+		Py_RETURN_NONE;
+	Py_INCREF(node->val);
+	return node->val;
+}
+
+/* returns NULL with no exception set if the heap is empty */
+static PyObject* bh_extract(struct bh_heap* heap)
+{
+	struct bh_node* node;
+	PyObject* val;
+	int r;
+
+	if (bh_enter(heap))
+		return NULL;
+	node = __bh_extract_min(heap);
+	r = bh_leave(heap);
+	if (!node)
+		return NULL;
+	val = node->val;
+	Py_INCREF(val);
+	Py_DECREF(node);
+	if (r) {
+		Py_DECREF(val);
+		return NULL;
+	}
+	return val;
+}
+
+static PyObject* bh_heap_extract_min(PyObject* self, PyObject* unused)
+{
+	PyObject* val = bh_extract((struct bh_heap*) self);
+	(void) unused;
+	if (!val && !PyErr_Occurred())
+		Py_RETURN_NONE;
+	return val;
+}
+
+static PyObject* bh_heap_extract_many(PyObject* self, PyObject* arg)
+{
+	PyObject *vals, *val;
+	Py_ssize_t k, i;
+
+	k = PyNumber_AsSsize_t(arg, PyExc_OverflowError);
+	if (k == -1 && PyErr_Occurred())
+		return NULL;
+	vals = PyList_New(0);
+	for (i = 0; vals && i < k; i++) {
+		val = bh_extract((struct bh_heap*) self);
+		if (!val || PyList_Append(vals, val)) {
+			Py_XDECREF(val);
+			if (PyErr_Occurred())
+				Py_CLEAR(vals);
+			break;
+		}
+		Py_DECREF(val);
+	}
+	return vals;
+}
+
+/* the destructive iterator of bh.py */
+static PyObject* bh_heap_iternext(PyObject* self)
+{
+	return bh_extract((struct bh_heap*) self);
+}
+
+static PyObject* bh_heap_iter(PyObject* self)
+{
+	Py_INCREF(self);
+	return self;
+}
+
+/* ordered(): non-destructive iteration, as in heap_iter.h */
+
+static int __bh_iter_push(struct bh_iter* iter, struct bh_node* node)
+{
+	struct bh_node** front;
+	size_t i, up, cap;
+
+	if (iter->n == iter->capacity) {
+		cap   = iter->capacity ? iter->capacity * 2 : HEAP_MAX_DEGREE;
+		front = PyMem_Realloc(iter->front, cap * sizeof(void*));
+		if (!front) {
+			PyErr_NoMemory();
+			return -1;
+		}
+		iter->front    = front;
+		iter->capacity = cap;
+	}
+	i = iter->n++;
+	while (i) {
+		up = (i - 1) / 2;
+		if (!__bh_less(iter->heap, node, iter->front[up]))
+			break;
+		iter->front[i] = iter->front[up];
+		i = up;
+	}
+	iter->front[i] = node;
+	return 0;
+}
+
+static struct bh_node* __bh_iter_pop(struct bh_iter* iter)
+{
+	struct bh_node** front = iter->front;
+	struct bh_node *top = front[0], *last = front[--iter->n];
+	size_t i = 0, c, n = iter->n;
+	while ((c = 2 * i + 1) < n) {
+		if (c + 1 < n && __bh_less(iter->heap, front[c + 1], front[c]))
+			c++;
+		if (!__bh_less(iter->heap, front[c], last))
+			break;
+		front[i] = front[c];
+		i = c;
+	}
+	front[i] = last;
+	return top;
+}
+
+static PyObject* bh_iter_next(PyObject* self)
+{
+	struct bh_iter* iter = (struct bh_iter*) self;
+	struct bh_heap* heap = iter->heap;
+	struct bh_node *node, *pos;
+
+	if (!iter->n)
+		return NULL;
+	if (heap->version != iter->version) {
+		PyErr_SetString(PyExc_RuntimeError,
+				"BinomialHeap changed during iteration");
+		return NULL;
+	}
+	if (bh_enter(heap))
+		return NULL;
+	node = __bh_iter_pop(iter);
+	for (pos = node->child; pos; pos = pos->next)
+		if (__bh_iter_push(iter, pos))
+			break;
+	if (bh_leave(heap) || PyErr_Occurred()) {
+		/* the frontier may be out of order; stop */
+		iter->n = 0;
+		return NULL;
+	}
+	Py_INCREF(node->val);
+	return node->val;
+}
+
+static int bh_iter_traverse(PyObject* self, visitproc visit, void* arg)
+{
+	Py_VISIT(((struct bh_iter*) self)->heap);
+	return 0;
+}
+
+static void bh_iter_dealloc(PyObject* self)
+{
+	struct bh_iter* iter = (struct bh_iter*) self;
+	PyObject_GC_UnTrack(self);
+	Py_XDECREF(iter->heap);
+	PyMem_Free(iter->front);
+	PyObject_GC_Del(self);
+}
+
+static PyObject* bh_heap_ordered(PyObject* self, PyObject* unused)
+{
+	struct bh_heap* heap = (struct bh_heap*) self;
+	struct bh_iter* iter;
+	struct bh_node* pos;
+
+	(void) unused;
+	iter = PyObject_GC_New(struct bh_iter, &bh_iter_type);
+	if (!iter)
+		return NULL;
+	Py_INCREF(heap);
+	iter->heap     = heap;
+	iter->version  = heap->version;
+	iter->front    = NULL;
+	iter->n        = 0;
+	iter->capacity = 0;
+	PyObject_GC_Track((PyObject*) iter);
+	if (bh_enter(heap)) {
+		Py_DECREF(iter);
+		return NULL;
+	}
+	for (pos = heap->head; pos; pos = pos->next)
+		if (__bh_iter_push(iter, pos))
+			break;
+	if (bh_leave(heap) || PyErr_Occurred()) {
+		Py_DECREF(iter);
+		return NULL;
+	}
+	return (PyObject*) iter;
+}
+
+static PyObject* bh_heap_top(PyObject* self, PyObject* arg)
+{
+	PyObject *iter, *vals, *val;
+	Py_ssize_t k, i;
+
+	k = PyNumber_AsSsize_t(arg, PyExc_OverflowError);
+	if (k == -1 && PyErr_Occurred())
+		return NULL;
+	iter = bh_heap_ordered(self, NULL);
+	if (!iter)
+		return NULL;
+	vals = PyList_New(0);
+	for (i = 0; vals && i < k; i++) {
+		val = bh_iter_next(iter);
+		if (!val || PyList_Append(vals, val)) {
+			Py_XDECREF(val);
+			if (PyErr_Occurred())
+				Py_CLEAR(vals);
+			break;
+		}
+		Py_DECREF(val);
+	}
+	Py_DECREF(iter);
+	return vals;
+}
+
+static Py_ssize_t bh_heap_len(PyObject* self)
+{
+	return ((struct bh_heap*) self)->size;
+}
+
+static int bh_heap_bool(PyObject* self)
+{
+	return ((struct bh_heap*) self)->head != NULL;
+}
+
+static int bh_heap_contains(PyObject* self, PyObject* ref)
+{
+	if (!PyObject_TypeCheck(ref, &bh_ref_type)) {
+		PyErr_SetString(PyExc_TypeError, "Expected an ItemRef");
+		return -1;
+	}
+	return bh_node_heap((struct bh_node*) ref) == (struct bh_heap*) self;
+}
+
+static int bh_heap_setitem(PyObject* self, PyObject* key, PyObject* val)
+{
+	struct bh_node* node;
+	if (!val) {
+		PyErr_SetString(PyExc_TypeError,
+				"BinomialHeap items cannot be deleted by key");
+		return -1;
+	}
+	node = bh_insert((struct bh_heap*) self, key, val);
+	Py_XDECREF(node);
+	return node ? 0 : -1;
+}
+
+static PyObject* bh_heap_iadd(PyObject* self, PyObject* other)
+{
+	PyObject* r = bh_heap_union(self, other);
+	if (!r)
+		return NULL;
+	Py_DECREF(r);
+	Py_INCREF(self);
+	return self;
+}
+
+static PyMethodDef bh_heap_methods[] = {
+	{"insert", bh_heap_insert, METH_VARARGS,
+	 "Insert 'value' in to the heap with priority 'key'. If 'value' is "
+	 "omitted,\nthen 'key' is used as the value.\n"
+	 "Returns a reference (of type ItemRef) to the internal node in the "
+	 "tree."},
+	{"insert_many", bh_heap_insert_many, METH_O,
+	 "Insert the (key, value) pairs in 'lst', like __init__(), in\n"
+	 "O(len(lst) + log n) time. Returns a list of references."},
+	{"union", bh_heap_union, METH_O,
+	 "Merge 'other' into 'self'. Returns None.\n"
+	 "Note: This is a destructive operation; 'other' is an empty heap "
+	 "afterwards."},
+	{"min", bh_heap_min, METH_NOARGS,
+	 "Returns the value with the minimum key (= highest priority) in the "
+	 "heap\nwithout removing it, or None if the heap is empty."},
+	{"extract_min", bh_heap_extract_min, METH_NOARGS,
+	 "Returns the value with the minimum key (= highest priority) in the "
+	 "heap\nAND removes it from the heap, or None if the heap is empty."},
+	{"extract_many", bh_heap_extract_many, METH_O,
+	 "Returns a list of the (at most) k values with the smallest keys,\n"
+	 "in order, AND removes them from the heap."},
+	{"ordered", bh_heap_ordered, METH_NOARGS,
+	 "Returns a _non-destructive_ iterator over the values in the heap,\n"
+	 "in order of increasing keys."},
+	{"top", bh_heap_top, METH_O,
+	 "Returns a list of the (at most) k values with the smallest keys,\n"
+	 "in order, without removing them."},
+	{NULL, NULL, 0, NULL}
+};
+
+static PyNumberMethods bh_heap_as_number = {
+#if PY_MAJOR_VERSION >= 3
+	.nb_bool         = bh_heap_bool,
+#else
+	.nb_nonzero      = bh_heap_bool,
+#endif
+	.nb_inplace_add  = bh_heap_iadd,
+};
+
+static PySequenceMethods bh_heap_as_sequence = {
+	.sq_length       = bh_heap_len,
+	.sq_contains     = bh_heap_contains,
+};
+
+static PyMappingMethods bh_heap_as_mapping = {
+	.mp_length        = bh_heap_len,
+	.mp_ass_subscript = bh_heap_setitem,
+};
+
+static PyTypeObject bh_heap_type = {
+	PyVarObject_HEAD_INIT(NULL, 0)
+	.tp_name        = "_bh.BinomialHeap",
+	.tp_basicsize   = sizeof(struct bh_heap),
+	.tp_dealloc     = bh_heap_dealloc,
+	.tp_as_number   = &bh_heap_as_number,
+	.tp_as_sequence = &bh_heap_as_sequence,
+	.tp_as_mapping  = &bh_heap_as_mapping,
+	.tp_flags       = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE |
+			  Py_TPFLAGS_HAVE_GC,
+	.tp_doc         = "A binomial heap of (key, value) pairs. Smaller keys "
+			  "have higher priority.\nIterating over a heap "
+			  "empties it; see ordered().",
+	.tp_traverse    = bh_heap_traverse,
+	.tp_clear       = bh_heap_clear,
+	.tp_iter        = bh_heap_iter,
+	.tp_iternext    = bh_heap_iternext,
+	.tp_methods     = bh_heap_methods,
+	.tp_init        = bh_heap_init,
+	.tp_new         = bh_heap_new,
+};
+
+static PyTypeObject bh_iter_type = {
+	PyVarObject_HEAD_INIT(NULL, 0)
+	.tp_name        = "_bh.OrderedIterator",
+	.tp_basicsize   = sizeof(struct bh_iter),
+	.tp_dealloc     = bh_iter_dealloc,
+	.tp_flags       = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC,
+	.tp_traverse    = bh_iter_traverse,
+	.tp_iter        = PyObject_SelfIter,
+	.tp_iternext    = bh_iter_next,
+};
+
+/* module */
+
+static int bh_add_types(PyObject* module)
+{
+	if (PyType_Ready(&bh_heap_type) || PyType_Ready(&bh_ref_type) ||
+	    PyType_Ready(&bh_iter_type))
+		return -1;
+	Py_INCREF(&bh_heap_type);
+	if (PyModule_AddObject(module, "BinomialHeap",
+			       (PyObject*) &bh_heap_type))
+		return -1;
+	Py_INCREF(&bh_ref_type);
+	if (PyModule_AddObject(module, "ItemRef", (PyObject*) &bh_ref_type))
+		return -1;
+	return 0;
+}
+
+#define BH_DOC "Binomial Heaps in C; see bh.py."
+
+#if PY_MAJOR_VERSION >= 3
+
+static struct PyModuleDef bh_module = {
+	PyModuleDef_HEAD_INIT,
+	.m_name = "_bh",
+	.m_doc  = BH_DOC,
+	.m_size = -1,
+};
+
+PyMODINIT_FUNC PyInit__bh(void)
+{
+	PyObject* module = PyModule_Create(&bh_module);
+	if (module && bh_add_types(module))
+		Py_CLEAR(module);
+	return module;
+}
+
+#else
+
+PyMODINIT_FUNC init_bh(void)
+{
+	PyObject* module = Py_InitModule3("_bh", NULL, BH_DOC);
+	if (module)
+		bh_add_types(module);
+}
+
+#endif
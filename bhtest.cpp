@@ -0,0 +1,275 @@
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "binomial_heap.hpp"
+
+/* Random pushes, takes, and merges against a table of the values that should
+ * be in each heap, a heap of move-only values, and heaps whose allocators
+ * count what they allocate: every node must go back to the allocator that it
+ * came from, also after moves and swaps, whether or not the allocator
+ * propagates.
+ */
+
+#define N	1000
+#define STEPS	40000
+
+typedef binomial_heap<int> int_heap;
+
+/* take the smallest value from heap, which must match the table */
+static int take(int_heap& heap, std::vector<int>& values)
+{
+	std::vector<int>::iterator min;
+	int got;
+
+	if (heap.empty() != values.empty() || heap.size() != values.size()) {
+		std::fprintf(stderr, "bhtest: %lu values, expected %lu\n",
+			     (unsigned long) heap.size(),
+			     (unsigned long) values.size());
+		return 1;
+	}
+	if (values.empty())
+		return 0;
+	min = std::min_element(values.begin(), values.end());
+	got = heap.top();
+	if (got != *min || (got = heap.take()) != *min) {
+		std::fprintf(stderr, "bhtest: took %d, expected %d\n", got,
+			     *min);
+		return 1;
+	}
+	values.erase(min);
+	return 0;
+}
+
+static int test_random()
+{
+	int_heap heaps[2];
+	std::vector<int> values[2];
+	int i, h, dice, err = 0;
+
+	for (i = 0; i < STEPS && !err; i++) {
+		h    = std::rand() % 2;
+		dice = std::rand() % 16;
+		if (dice < 8) {
+			values[h].push_back(std::rand() % N);
+			heaps[h].push(values[h].back());
+		} else if (dice < 15) {
+			err = take(heaps[h], values[h]);
+		} else if (std::rand() % 4 == 0) {
+			heaps[h].merge(heaps[!h]);
+			values[h].insert(values[h].end(), values[!h].begin(),
+					 values[!h].end());
+			values[!h].clear();
+		}
+	}
+	for (h = 0; h < 2; h++) {
+		while (!err && !values[h].empty())
+			err = take(heaps[h], values[h]);
+		err = err || take(heaps[h], values[h]);
+	}
+	return err;
+}
+
+struct ptr_less {
+	bool operator()(const std::unique_ptr<int>& a,
+			const std::unique_ptr<int>& b) const
+	{
+		return *a < *b;
+	}
+};
+
+/* values that can only be moved go in and out of the heap */
+static int test_move_only()
+{
+	binomial_heap<std::unique_ptr<int>, ptr_less> heap, other;
+	std::unique_ptr<int> p;
+	int i, last = -1;
+
+	for (i = 0; i < N; i++) {
+		p.reset(new int((i * 7) % N));
+		heap.push(std::move(p));
+	}
+	heap.emplace(new int(N));
+	other = std::move(heap);
+	for (i = 0; !other.empty(); i++) {
+		p = other.take();
+		if (!p || *p != last + 1) {
+			std::fprintf(stderr, "bhtest: took %d after %d\n",
+				     p ? *p : -1, last);
+			return 1;
+		}
+		last = *p;
+	}
+	if (i != N + 1 || !heap.empty()) {
+		std::fprintf(stderr, "bhtest: took %d of %d pointers\n", i,
+			     N + 1);
+		return 1;
+	}
+	return 0;
+}
+
+/* what one allocator (and all of its copies) handed out and got back */
+struct counter {
+	unsigned long allocs;
+	unsigned long deallocs;
+};
+
+template <typename T, bool Propagate>
+struct counting_alloc {
+	typedef T value_type;
+	typedef std::integral_constant<bool, Propagate>
+		propagate_on_container_move_assignment;
+	typedef std::integral_constant<bool, Propagate>
+		propagate_on_container_swap;
+
+	template <typename U>
+	struct rebind {
+		typedef counting_alloc<U, Propagate> other;
+	};
+
+	counter* c;
+
+	explicit counting_alloc(counter* c) : c(c)
+	{
+	}
+
+	template <typename U>
+	counting_alloc(const counting_alloc<U, Propagate>& other) : c(other.c)
+	{
+	}
+
+	T* allocate(std::size_t n)
+	{
+		c->allocs += n;
+		return static_cast<T*>(::operator new(n * sizeof(T)));
+	}
+
+	void deallocate(T* p, std::size_t n)
+	{
+		c->deallocs += n;
+		::operator delete(p);
+	}
+};
+
+template <typename T, typename U, bool Propagate>
+static bool operator==(const counting_alloc<T, Propagate>& a,
+		       const counting_alloc<U, Propagate>& b)
+{
+	return a.c == b.c;
+}
+
+template <typename T, typename U, bool Propagate>
+static bool operator!=(const counting_alloc<T, Propagate>& a,
+		       const counting_alloc<U, Propagate>& b)
+{
+	return a.c != b.c;
+}
+
+/* heap holds 0..n-1, from its own counter or not */
+template <typename Heap>
+static int check_heap(const char* what, Heap& heap, int n, counter* c)
+{
+	int i;
+	if (heap.get_allocator().c != c || heap.size() != (std::size_t) n) {
+		std::fprintf(stderr, "bhtest: %s: wrong allocator or size\n",
+			     what);
+		return 1;
+	}
+	for (i = 0; i < n; i++)
+		if (heap.take() != i) {
+			std::fprintf(stderr, "bhtest: %s: lost %d\n", what, i);
+			return 1;
+		}
+	return 0;
+}
+
+template <typename Heap>
+static void fill(Heap& heap, int n)
+{
+	int i;
+	for (i = n - 1; i >= 0; i--)
+		heap.push(i);
+}
+
+/* each counter must have gotten back everything that it handed out */
+static int check_counters(const char* what, counter* c, unsigned long allocs)
+{
+	int i;
+	for (i = 0; i < 2; i++)
+		if (c[i].allocs != c[i].deallocs) {
+			std::fprintf(stderr, "bhtest: %s: allocator %d handed "
+				     "out %lu nodes and got back %lu\n", what,
+				     i, c[i].allocs, c[i].deallocs);
+			return 1;
+		}
+	if (c[0].allocs + c[1].allocs != allocs) {
+		std::fprintf(stderr, "bhtest: %s: %lu nodes allocated, "
+			     "expected %lu\n", what,
+			     c[0].allocs + c[1].allocs, allocs);
+		return 1;
+	}
+	return 0;
+}
+
+/* Move-assign and swap heaps with unequal allocators. If the allocator
+ * propagates, the nodes go along with it; otherwise, each heap keeps its
+ * allocator, and the values are moved into new nodes. Either way, the nodes
+ * left over at the end go back to the allocators that they came from.
+ */
+template <bool Propagate>
+static int test_alloc()
+{
+	typedef counting_alloc<int, Propagate> alloc;
+	typedef binomial_heap<int, std::less<int>, alloc> heap;
+	const char* what = Propagate ? "propagate" : "keep";
+	counter c[2] = {{0, 0}, {0, 0}};
+	std::less<int> cmp;
+	int err;
+
+	{
+		heap a(cmp, alloc(c)), b(cmp, alloc(c + 1));
+		fill(a, 10);
+		fill(b, 20);
+		b = std::move(a);
+		err = check_heap(what, b, 10, c + !Propagate) || !a.empty();
+		fill(b, 3);
+	}
+	{
+		heap a(cmp, alloc(c)), b(cmp, alloc(c + 1));
+		fill(a, 30);
+		fill(b, 40);
+		a.swap(b);
+		err = err || check_heap(what, a, 40, c + Propagate) ||
+			check_heap(what, b, 30, c + !Propagate);
+		fill(a, 5);
+		fill(b, 6);
+	}
+	if (err || check_counters(what, c, Propagate ? 114 : 194))
+		return 1;
+
+	/* with equal allocators, the nodes go along in any case */
+	c[0].allocs = c[0].deallocs = c[1].allocs = c[1].deallocs = 0;
+	{
+		heap a(cmp, alloc(c)), b(cmp, alloc(c));
+		fill(a, 10);
+		fill(b, 20);
+		b = std::move(a);
+		fill(a, 30);
+		a.swap(b);
+		err = check_heap("equal", a, 10, c) ||
+			check_heap("equal", b, 30, c);
+	}
+	return err || check_counters("equal", c, 60);
+}
+
+int main()
+{
+	std::srand(1);
+	if (test_random() || test_move_only() || test_alloc<true>() ||
+	    test_alloc<false>())
+		return 1;
+	return 0;
+}
@@ -0,0 +1,523 @@
+/* binomial_heap.hpp -- Binomial Heaps for C++
+ *
+ * Copyright (c) 2008, Bjoern B. Brandenburg <bbb [at] cs.unc.edu>
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University of North Carolina nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY  COPYRIGHT OWNER AND CONTRIBUTERS ``AS IS'' AND
+ * ANY  EXPRESS OR  IMPLIED  WARRANTIES,  INCLUDING, BUT  NOT  LIMITED TO,  THE
+ * IMPLIED WARRANTIES  OF MERCHANTABILITY AND FITNESS FOR  A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO  EVENT SHALL THE  COPYRIGHT OWNER OR  CONTRIBUTERS BE
+ * LIABLE  FOR  ANY  DIRECT,   INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT  OF
+ * SUBSTITUTE GOODS  OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+ * INTERRUPTION)  HOWEVER CAUSED  AND ON  ANY THEORY  OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR  TORT (INCLUDING  NEGLIGENCE OR  OTHERWISE)
+ * ARISING IN ANY WAY  OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BINOMIAL_HEAP_HPP
+#define BINOMIAL_HEAP_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+/* A binomial heap that stores values of type T directly in its nodes.
+ *
+ * This is the same algorithm as heap.h, but the comparator is a type
+ * parameter and can thus be inlined. Compare(a, b) must return true if a has
+ * higher priority than b; hence, the default std::less<T> yields a min-heap
+ * (unlike std::priority_queue).
+ *
+ * Values are moved into and out of the heap, so T may be a move-only type.
+ * The heap itself can be moved, but not copied. Moves and swaps follow the
+ * propagation traits of the allocator.
+ */
+template <typename T,
+	  typename Compare = std::less<T>,
+	  typename Alloc   = std::allocator<T> >
+class binomial_heap
+{
+public:
+	typedef T		value_type;
+	typedef Compare		value_compare;
+	typedef Alloc		allocator_type;
+	typedef std::size_t	size_type;
+
+private:
+	struct node {
+		node*		parent;
+		node*		next;
+		node*		child;
+
+		unsigned int	degree;
+		T		value;
+
+		template <typename... Args>
+		explicit node(Args&&... args)
+			: parent(nullptr), next(nullptr), child(nullptr),
+			  degree(0), value(std::forward<Args>(args)...)
+		{
+		}
+	};
+
+	typedef typename std::allocator_traits<Alloc>::template
+		rebind_alloc<node>			node_alloc;
+	typedef std::allocator_traits<node_alloc>	node_traits;
+
+	node*		head;
+	/* We cache the minimum of the heap.
+	 * This speeds up repeated top() operations.
+	 */
+	node*		min;
+	size_type	count;
+	Compare		higher_prio;
+	node_alloc	alloc;
+
+public:
+	binomial_heap()
+		: head(nullptr), min(nullptr), count(0),
+		  higher_prio(), alloc()
+	{
+	}
+
+	explicit binomial_heap(const Compare& cmp, const Alloc& a = Alloc())
+		: head(nullptr), min(nullptr), count(0),
+		  higher_prio(cmp), alloc(a)
+	{
+	}
+
+	binomial_heap(binomial_heap&& other)
+		: head(other.head), min(other.min), count(other.count),
+		  higher_prio(std::move(other.higher_prio)),
+		  alloc(std::move(other.alloc))
+	{
+		other.head  = nullptr;
+		other.min   = nullptr;
+		other.count = 0;
+	}
+
+	/* Unless the allocator propagates or the allocators are equal, the
+	 * values are moved over one by one.
+	 */
+	binomial_heap& operator=(binomial_heap&& other)
+	{
+		if (this != &other) {
+			clear();
+			higher_prio = std::move(other.higher_prio);
+			move_assign(other, typename node_traits::
+				    propagate_on_container_move_assignment());
+		}
+		return *this;
+	}
+
+	binomial_heap(const binomial_heap&) = delete;
+	binomial_heap& operator=(const binomial_heap&) = delete;
+
+	~binomial_heap()
+	{
+		clear();
+	}
+
+	bool empty() const
+	{
+		return head == nullptr && min == nullptr;
+	}
+
+	size_type size() const
+	{
+		return count;
+	}
+
+	void push(const T& value)
+	{
+		emplace(value);
+	}
+
+	void push(T&& value)
+	{
+		emplace(std::move(value));
+	}
+
+	template <typename... Args>
+	void emplace(Args&&... args)
+	{
+		insert(make_node(std::forward<Args>(args)...));
+		count++;
+	}
+
+	/* Heap must not be empty. */
+	const T& top()
+	{
+		assert(!empty());
+		if (!min)
+			min = extract_min();
+		return min->value;
+	}
+
+	/* Heap must not be empty. */
+	void pop()
+	{
+		assert(!empty());
+		if (!min)
+			min = extract_min();
+		destroy_node(min);
+		min = nullptr;
+		count--;
+	}
+
+	/* Remove the top element and hand it to the caller.
+	 * Heap must not be empty.
+	 */
+	T take()
+	{
+		assert(!empty());
+		if (!min)
+			min = extract_min();
+		T value(std::move(min->value));
+		destroy_node(min);
+		min = nullptr;
+		count--;
+		return value;
+	}
+
+	/* Merge addition into this heap. This is a destructive merge: addition
+	 * is empty afterwards. Both heaps must use equal allocators.
+	 */
+	void merge(binomial_heap& addition)
+	{
+		assert(alloc == addition.alloc);
+		if (this == &addition)
+			return;
+		/* first insert any cached minima, if necessary */
+		uncache_min();
+		addition.uncache_min();
+		union_roots(addition.head);
+		count += addition.count;
+		addition.head  = nullptr;
+		addition.count = 0;
+	}
+
+	void clear()
+	{
+		consume([](T&) {});
+	}
+
+	/* Unless the allocator propagates or the allocators are equal, the
+	 * values are moved over one by one.
+	 */
+	void swap(binomial_heap& other)
+	{
+		using std::swap;
+		swap(higher_prio, other.higher_prio);
+		if (node_traits::propagate_on_container_swap::value ||
+		    alloc == other.alloc) {
+			swap_alloc(other, typename node_traits::
+				   propagate_on_container_swap());
+			swap(head, other.head);
+			swap(min, other.min);
+			swap(count, other.count);
+		} else {
+			/* each heap keeps its allocator and its nodes */
+			binomial_heap tmp(higher_prio, allocator_type(alloc));
+			tmp.move_values(other);
+			other.move_values(*this);
+			steal(tmp);
+		}
+	}
+
+	value_compare value_comp() const
+	{
+		return higher_prio;
+	}
+
+	allocator_type get_allocator() const
+	{
+		return allocator_type(alloc);
+	}
+
+private:
+	/* take over the nodes of other, whose allocator can free them */
+	void steal(binomial_heap& other)
+	{
+		head  = other.head;
+		min   = other.min;
+		count = other.count;
+		other.head  = nullptr;
+		other.min   = nullptr;
+		other.count = 0;
+	}
+
+	void move_assign(binomial_heap& other, std::true_type)
+	{
+		alloc = std::move(other.alloc);
+		steal(other);
+	}
+
+	void move_assign(binomial_heap& other, std::false_type)
+	{
+		if (alloc == other.alloc)
+			steal(other);
+		else
+			move_values(other);
+	}
+
+	void swap_alloc(binomial_heap& other, std::true_type)
+	{
+		using std::swap;
+		swap(alloc, other.alloc);
+	}
+
+	void swap_alloc(binomial_heap&, std::false_type)
+	{
+	}
+
+	/* move the values of from into nodes of our own, and empty from */
+	void move_values(binomial_heap& from)
+	{
+		from.consume([this](T& value) { push(std::move(value)); });
+	}
+
+	/* Hand each value to f, in no particular order, and free its node.
+	 * Walk the forest without recursion: splice each node's children into
+	 * the list of nodes that remain to be visited.
+	 */
+	template <typename F>
+	void consume(F f)
+	{
+		node *pos, *tail, *tmp;
+
+		if (min) {
+			f(min->value);
+			destroy_node(min);
+			min = nullptr;
+		}
+		pos = head;
+		while (pos) {
+			if (pos->child) {
+				for (tail = pos->child; tail->next; tail = tail->next)
+					;
+				tail->next = pos->next;
+				tmp = pos->child;
+			} else
+				tmp = pos->next;
+			f(pos->value);
+			destroy_node(pos);
+			pos = tmp;
+		}
+		head  = nullptr;
+		count = 0;
+	}
+
+	template <typename... Args>
+	node* make_node(Args&&... args)
+	{
+		node* n = node_traits::allocate(alloc, 1);
+		try {
+			node_traits::construct(alloc, n,
+					       std::forward<Args>(args)...);
+		} catch (...) {
+			node_traits::deallocate(alloc, n, 1);
+			throw;
+		}
+		return n;
+	}
+
+	void destroy_node(node* n)
+	{
+		node_traits::destroy(alloc, n);
+		node_traits::deallocate(alloc, n, 1);
+	}
+
+	bool prio(const node* a, const node* b)
+	{
+		return higher_prio(a->value, b->value);
+	}
+
+	/* make child a subtree of root */
+	static void link(node* root, node* child)
+	{
+		child->parent = root;
+		child->next   = root->child;
+		root->child   = child;
+		root->degree++;
+	}
+
+	/* merge root lists */
+	static node* merge_roots(node* a, node* b)
+	{
+		node*  head = nullptr;
+		node** pos  = &head;
+
+		while (a && b) {
+			if (a->degree < b->degree) {
+				*pos = a;
+				a = a->next;
+			} else {
+				*pos = b;
+				b = b->next;
+			}
+			pos = &(*pos)->next;
+		}
+		if (a)
+			*pos = a;
+		else
+			*pos = b;
+		return head;
+	}
+
+	/* reverse a linked list of nodes. also clears parent pointer */
+	static node* reverse(node* h)
+	{
+		node* tail = nullptr;
+		node* next;
+
+		if (!h)
+			return h;
+
+		h->parent = nullptr;
+		while (h->next) {
+			next    = h->next;
+			h->next = tail;
+			tail    = h;
+			h       = next;
+			h->parent = nullptr;
+		}
+		h->next = tail;
+		return h;
+	}
+
+	void find_min(node** prev, node** n)
+	{
+		node *_prev, *cur;
+		*prev = nullptr;
+
+		if (!head) {
+			*n = nullptr;
+			return;
+		}
+
+		*n    = head;
+		_prev = head;
+		cur   = head->next;
+		while (cur) {
+			if (prio(cur, *n)) {
+				*n    = cur;
+				*prev = _prev;
+			}
+			_prev = cur;
+			cur   = cur->next;
+		}
+	}
+
+	void union_roots(node* h2)
+	{
+		node* h1;
+		node *prev, *x, *next;
+		if (!h2)
+			return;
+		h1 = head;
+		if (!h1) {
+			head = h2;
+			return;
+		}
+		h1 = merge_roots(h1, h2);
+		prev = nullptr;
+		x    = h1;
+		next = x->next;
+		while (next) {
+			if (x->degree != next->degree ||
+			    (next->next && next->next->degree == x->degree)) {
+				/* nothing to do, advance */
+				prev = x;
+				x    = next;
+			} else if (prio(x, next)) {
+				/* x becomes the root of next */
+				x->next = next->next;
+				link(x, next);
+			} else {
+				/* next becomes the root of x */
+				if (prev)
+					prev->next = next;
+				else
+					h1 = next;
+				link(next, x);
+				x = next;
+			}
+			next = x->next;
+		}
+		head = h1;
+	}
+
+	node* extract_min()
+	{
+		node *prev, *n;
+		find_min(&prev, &n);
+		if (!n)
+			return nullptr;
+		if (prev)
+			prev->next = n->next;
+		else
+			head = n->next;
+		union_roots(reverse(n->child));
+		n->child  = nullptr;
+		n->degree = 0;
+		return n;
+	}
+
+	/* insert (and reinitialize) a node into the heap */
+	void insert(node* n)
+	{
+		node* old;
+		n->child  = nullptr;
+		n->parent = nullptr;
+		n->next   = nullptr;
+		n->degree = 0;
+		if (min && prio(n, min)) {
+			/* swap min cache */
+			old = min;
+			old->child  = nullptr;
+			old->parent = nullptr;
+			old->next   = nullptr;
+			old->degree = 0;
+			union_roots(old);
+			min = n;
+		} else
+			union_roots(n);
+	}
+
+	void uncache_min()
+	{
+		node* old;
+		if (min) {
+			old = min;
+			min = nullptr;
+			insert(old);
+		}
+	}
+};
+
+template <typename T, typename Compare, typename Alloc>
+inline void swap(binomial_heap<T, Compare, Alloc>& a,
+		 binomial_heap<T, Compare, Alloc>& b)
+{
+	a.swap(b);
+}
+
+#endif /* BINOMIAL_HEAP_HPP */
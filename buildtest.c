@@ -0,0 +1,205 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <stdint.h>
+
+#include "heap.h"
+#include "iheap.h"
+#include "ciheap.h"
+
+/* Build heaps from random and from sorted keys, into empty heaps and into
+ * heaps that already hold keys (and a cached minimum), and check that all
+ * keys come out in sorted order.
+ */
+
+#define N	1000
+/* keys already in the target heap */
+#define OLD	100
+
+static int keys[N + OLD];
+static int expected[N + OLD];
+
+struct item {
+	int key;
+};
+
+static struct item items[N + OLD];
+static struct heap_node hnodes[N + OLD];
+static struct heap_node* hptrs[N];
+static struct iheap_node inodes[N + OLD];
+static struct iheap_node* iptrs[N];
+static uint32_t cptrs[N];
+
+static int int_cmp(const void* a, const void* b)
+{
+	int x = *(const int*) a, y = *(const int*) b;
+	return (x > y) - (x < y);
+}
+
+static int item_less(struct heap_node* a, struct heap_node* b)
+{
+	return ((struct item*) heap_node_value(a))->key <
+	       ((struct item*) heap_node_value(b))->key;
+}
+
+/* N new keys (sorted if requested) followed by OLD keys for the target */
+static void make_keys(int sorted)
+{
+	int i;
+	for (i = 0; i < N + OLD; i++)
+		keys[i] = rand() % (4 * N);
+	if (sorted)
+		qsort(keys, N, sizeof(int), int_cmp);
+	for (i = 0; i < N + OLD; i++)
+		expected[i] = keys[i];
+}
+
+static int check(const char* what, int i, int key)
+{
+	if (key != expected[i]) {
+		fprintf(stderr, "buildtest: %s: key %d is %d, expected %d\n",
+			what, i, key, expected[i]);
+		return 1;
+	}
+	return 0;
+}
+
+static int test_heap(int lazy, int sorted, int old)
+{
+	struct heap heap;
+	struct heap_node* hn;
+	int i, total = N + old;
+
+	if (lazy)
+		heap_init_lazy(&heap);
+	else
+		heap_init(&heap);
+	for (i = 0; i < N + OLD; i++) {
+		items[i].key = keys[i];
+		heap_node_init(hnodes + i, items + i);
+	}
+	for (i = N; i < total; i++)
+		heap_insert(item_less, &heap, hnodes + i);
+	if (old)
+		heap_peek(item_less, &heap);
+	for (i = 0; i < N; i++)
+		hptrs[i] = hnodes + i;
+	if (sorted)
+		heap_build_sorted(item_less, &heap, hptrs, N);
+	else
+		heap_build(item_less, &heap, hptrs, N);
+	qsort(expected, total, sizeof(int), int_cmp);
+	for (i = 0; i < total; i++) {
+		hn = heap_take(item_less, &heap);
+		if (!hn) {
+			fprintf(stderr, "buildtest: heap ran empty\n");
+			return 1;
+		}
+		if (check("heap", i, ((struct item*) heap_node_value(hn))->key))
+			return 1;
+	}
+	if (!heap_empty(&heap)) {
+		fprintf(stderr, "buildtest: heap not empty\n");
+		return 1;
+	}
+	return 0;
+}
+
+static int test_iheap(int lazy, int sorted, int old)
+{
+	struct iheap heap;
+	struct iheap_node* hn;
+	int i, total = N + old;
+
+	if (lazy)
+		iheap_init_lazy(&heap);
+	else
+		iheap_init(&heap);
+	for (i = 0; i < N + OLD; i++)
+		iheap_node_init(inodes + i, keys[i], NULL);
+	for (i = N; i < total; i++)
+		iheap_insert(&heap, inodes + i);
+	if (old)
+		iheap_peek(&heap);
+	for (i = 0; i < N; i++)
+		iptrs[i] = inodes + i;
+	if (sorted)
+		iheap_build_sorted(&heap, iptrs, N);
+	else
+		iheap_build(&heap, iptrs, N);
+	qsort(expected, total, sizeof(int), int_cmp);
+	for (i = 0; i < total; i++) {
+		hn = iheap_take(&heap);
+		if (!hn) {
+			fprintf(stderr, "buildtest: iheap ran empty\n");
+			return 1;
+		}
+		if (check("iheap", i, hn->key))
+			return 1;
+	}
+	if (!iheap_empty(&heap)) {
+		fprintf(stderr, "buildtest: iheap not empty\n");
+		return 1;
+	}
+	return 0;
+}
+
+static int test_ciheap(int lazy, int sorted, int old)
+{
+	struct ciheap_arena arena;
+	struct ciheap heap;
+	uint32_t hn;
+	int i, total = N + old, err = 0;
+
+	ciheap_arena_init(&arena);
+	if (lazy)
+		ciheap_init_lazy(&heap, &arena);
+	else
+		ciheap_init(&heap, &arena);
+	for (i = N; i < total; i++)
+		ciheap_insert(&heap, ciheap_node_alloc(&arena, keys[i], 0));
+	if (old)
+		ciheap_peek(&heap);
+	for (i = 0; i < N; i++)
+		cptrs[i] = ciheap_node_alloc(&arena, keys[i], 0);
+	if (sorted)
+		ciheap_build_sorted(&heap, cptrs, N);
+	else
+		ciheap_build(&heap, cptrs, N);
+	qsort(expected, total, sizeof(int), int_cmp);
+	for (i = 0; i < total && !err; i++) {
+		hn = ciheap_take(&heap);
+		if (hn == CIHEAP_NIL) {
+			fprintf(stderr, "buildtest: ciheap ran empty\n");
+			err = 1;
+		} else
+			err = check("ciheap", i, ciheap_node_key(&arena, hn));
+	}
+	if (!err && !ciheap_empty(&heap)) {
+		fprintf(stderr, "buildtest: ciheap not empty\n");
+		err = 1;
+	}
+	ciheap_arena_destroy(&arena);
+	return err;
+}
+
+int main(int argc __attribute__((unused)), char** argv __attribute__((unused)))
+{
+	int lazy, sorted, old;
+
+	srand(1);
+	for (lazy = 0; lazy < 2; lazy++)
+		for (sorted = 0; sorted < 2; sorted++)
+			for (old = 0; old <= OLD; old += OLD) {
+				make_keys(sorted);
+				if (test_heap(lazy, sorted, old))
+					return 1;
+				make_keys(sorted);
+				if (test_iheap(lazy, sorted, old))
+					return 1;
+				make_keys(sorted);
+				if (test_ciheap(lazy, sorted, old))
+					return 1;
+			}
+	return 0;
+}
@@ -0,0 +1,701 @@
+/* ciheap.h -- Binomial Heaps with compact, index-linked nodes
+ *
+ * Copyright (c) 2008, Bjoern B. Brandenburg <bbb [at] cs.unc.edu>
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University of North Carolina nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY  COPYRIGHT OWNER AND CONTRIBUTERS ``AS IS'' AND
+ * ANY  EXPRESS OR  IMPLIED  WARRANTIES,  INCLUDING, BUT  NOT  LIMITED TO,  THE
+ * IMPLIED WARRANTIES  OF MERCHANTABILITY AND FITNESS FOR  A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO  EVENT SHALL THE  COPYRIGHT OWNER OR  CONTRIBUTERS BE
+ * LIABLE  FOR  ANY  DIRECT,   INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT  OF
+ * SUBSTITUTE GOODS  OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+ * INTERRUPTION)  HOWEVER CAUSED  AND ON  ANY THEORY  OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR  TORT (INCLUDING  NEGLIGENCE OR  OTHERWISE)
+ * ARISING IN ANY WAY  OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CIHEAP_H
+#define CIHEAP_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#define NOT_IN_HEAP UINT_MAX
+
+/* upper bound on the degree of any node; requires <limits.h> */
+#define HEAP_MAX_DEGREE (sizeof(size_t) * CHAR_BIT)
+
+#ifdef HEAP_STATS
+#include "heap_stats.h"
+#define __HEAP_STAT(heap, field, n)	((heap)->stats.field += (n))
+#else
+#define __HEAP_STAT(heap, field, n)	((void) (heap))
+#endif
+
+/* index that does not refer to any node */
+#define CIHEAP_NIL UINT32_MAX
+
+/* The same heap as iheap.h, but nodes live in one array and refer to each
+ * other by 32-bit indices. A node takes 24 bytes instead of 48, and the
+ * payload is an integer (e.g., an index into the caller's own array) rather
+ * than a pointer.
+ *
+ * Nodes never move between slots, so a node's index is a stable handle; no
+ * refs are needed. Decrease and delete move nodes by relinking them.
+ */
+struct ciheap_node {
+	uint32_t	parent;
+	uint32_t	next;
+	uint32_t	child;
+
+	unsigned int	degree;
+	int		key;
+	uint32_t	value;
+};
+
+/* Node storage. Several heaps may share an arena; this is required for
+ * ciheap_union(). Growing the arena may move the array, so pointers returned
+ * by ciheap_node() are only valid until the next ciheap_node_alloc().
+ */
+struct ciheap_arena {
+	struct ciheap_node*	nodes;
+	uint32_t		size;
+	uint32_t		capacity;
+	/* recycled slots, linked through their next field */
+	uint32_t		free;
+};
+
+struct ciheap {
+	struct ciheap_arena*	arena;
+	uint32_t		head;
+	/* the last root; see struct heap in heap.h */
+	uint32_t		tail;
+	/* We cache the minimum of the heap.
+	 * This speeds up repeated peek operations.
+	 */
+	uint32_t		min;
+	/* In lazy mode, insertions and unions only splice root lists in O(1).
+	 * Consolidation is deferred until the minimum is needed, or until a
+	 * node is removed from within its tree; see struct heap in heap.h.
+	 */
+	int			lazy;
+#ifdef HEAP_STATS
+	struct heap_stats	stats;
+#endif
+};
+
+static inline void ciheap_arena_init(struct ciheap_arena* arena)
+{
+	arena->nodes    = NULL;
+	arena->size     = 0;
+	arena->capacity = 0;
+	arena->free     = CIHEAP_NIL;
+}
+
+/* make room for at least capacity nodes; returns 0 on success */
+static inline int ciheap_arena_reserve(struct ciheap_arena* arena,
+				       size_t capacity)
+{
+	struct ciheap_node* nodes;
+	if (capacity <= arena->capacity)
+		return 0;
+	/* CIHEAP_NIL itself is not a valid index */
+	if (capacity > CIHEAP_NIL)
+		return -1;
+	nodes = (struct ciheap_node*)
+		realloc(arena->nodes, capacity * sizeof(struct ciheap_node));
+	if (!nodes)
+		return -1;
+	arena->nodes    = nodes;
+	arena->capacity = (uint32_t) capacity;
+	return 0;
+}
+
+/* Release all nodes at once. Heaps using the arena must not be used anymore
+ * unless they are reinitialized.
+ */
+static inline void ciheap_arena_destroy(struct ciheap_arena* arena)
+{
+	free(arena->nodes);
+	ciheap_arena_init(arena);
+}
+
+/* (Re)initialize an allocated node that is not in any heap, e.g., to give a
+ * taken or deleted node a new key before it is inserted again.
+ */
+static inline void ciheap_node_init(struct ciheap_arena* arena, uint32_t idx,
+				    int key, uint32_t value)
+{
+	struct ciheap_node* node = arena->nodes + idx;
+	node->parent = CIHEAP_NIL;
+	node->next   = CIHEAP_NIL;
+	node->child  = CIHEAP_NIL;
+	node->degree = NOT_IN_HEAP;
+	node->key    = key;
+	node->value  = value;
+}
+
+/* returns CIHEAP_NIL if the arena cannot grow */
+static inline uint32_t ciheap_node_alloc(struct ciheap_arena* arena,
+					 int key, uint32_t value)
+{
+	uint32_t idx;
+	size_t capacity;
+
+	if (arena->free != CIHEAP_NIL) {
+		idx = arena->free;
+		arena->free = arena->nodes[idx].next;
+	} else {
+		if (arena->size == arena->capacity) {
+			capacity = arena->capacity ?
+				2 * (size_t) arena->capacity : 64;
+			if (capacity > CIHEAP_NIL)
+				capacity = CIHEAP_NIL;
+			if (ciheap_arena_reserve(arena, capacity) ||
+			    arena->size == arena->capacity)
+				return CIHEAP_NIL;
+		}
+		idx = arena->size++;
+	}
+	ciheap_node_init(arena, idx, key, value);
+	return idx;
+}
+
+static inline void ciheap_node_free(struct ciheap_arena* arena, uint32_t idx)
+{
+	arena->nodes[idx].degree = NOT_IN_HEAP;
+	arena->nodes[idx].next   = arena->free;
+	arena->free = idx;
+}
+
+static inline struct ciheap_node* ciheap_node(struct ciheap_arena* arena,
+					      uint32_t idx)
+{
+	return arena->nodes + idx;
+}
+
+static inline int ciheap_node_key(struct ciheap_arena* arena, uint32_t idx)
+{
+	return arena->nodes[idx].key;
+}
+
+static inline uint32_t ciheap_node_value(struct ciheap_arena* arena,
+					 uint32_t idx)
+{
+	return arena->nodes[idx].value;
+}
+
+static inline int ciheap_node_in_heap(struct ciheap_arena* arena, uint32_t idx)
+{
+	return arena->nodes[idx].degree != NOT_IN_HEAP;
+}
+
+static inline void ciheap_init(struct ciheap* heap, struct ciheap_arena* arena)
+{
+	heap->arena = arena;
+	heap->head  = CIHEAP_NIL;
+	heap->tail  = CIHEAP_NIL;
+	heap->min   = CIHEAP_NIL;
+#ifdef HEAP_LAZY
+	heap->lazy = 1;
+#else
+	heap->lazy = 0;
+#endif
+#ifdef HEAP_STATS
+	heap_stats_reset(&heap->stats);
+#endif
+}
+
+static inline void ciheap_init_lazy(struct ciheap* heap,
+				    struct ciheap_arena* arena)
+{
+	ciheap_init(heap, arena);
+	heap->lazy = 1;
+}
+
+static inline int ciheap_empty(struct ciheap* heap)
+{
+	return heap->head == CIHEAP_NIL && heap->min == CIHEAP_NIL;
+}
+
+/* all key comparisons go through here so that they can be counted */
+static inline int __ciheap_less(struct ciheap* heap, uint32_t a, uint32_t b)
+{
+	__HEAP_STAT(heap, compares, 1);
+	return heap->arena->nodes[a].key < heap->arena->nodes[b].key;
+}
+
+/* make child a subtree of root */
+static inline void __ciheap_link(struct ciheap_node* n,
+				 uint32_t root, uint32_t child)
+{
+	n[child].parent = root;
+	n[child].next   = n[root].child;
+	n[root].child   = child;
+	n[root].degree++;
+}
+
+/* merge root lists */
+static inline uint32_t __ciheap_merge(struct ciheap_node* n,
+				      uint32_t a, uint32_t b)
+{
+	uint32_t head = CIHEAP_NIL;
+	uint32_t* pos = &head;
+
+	while (a != CIHEAP_NIL && b != CIHEAP_NIL) {
+		if (n[a].degree < n[b].degree) {
+			*pos = a;
+			a = n[a].next;
+		} else {
+			*pos = b;
+			b = n[b].next;
+		}
+		pos = &n[*pos].next;
+	}
+	if (a != CIHEAP_NIL)
+		*pos = a;
+	else
+		*pos = b;
+	return head;
+}
+
+/* reverse a linked list of nodes. also clears parent index */
+static inline uint32_t __ciheap_reverse(struct ciheap_node* n, uint32_t h)
+{
+	uint32_t tail = CIHEAP_NIL;
+	uint32_t next;
+
+	if (h == CIHEAP_NIL)
+		return h;
+
+	n[h].parent = CIHEAP_NIL;
+	while (n[h].next != CIHEAP_NIL) {
+		next      = n[h].next;
+		n[h].next = tail;
+		tail      = h;
+		h         = next;
+		n[h].parent = CIHEAP_NIL;
+	}
+	n[h].next = tail;
+	return h;
+}
+
+/* replace the root list; the tail is searched, so only for short lists */
+static inline void __ciheap_set_roots(struct ciheap* heap, uint32_t head)
+{
+	struct ciheap_node* n = heap->arena->nodes;
+	heap->head = head;
+	heap->tail = head;
+	if (head != CIHEAP_NIL)
+		while (n[heap->tail].next != CIHEAP_NIL)
+			heap->tail = n[heap->tail].next;
+}
+
+/* unlink a root, given the root before it (or CIHEAP_NIL) */
+static inline void __ciheap_remove_root(struct ciheap* heap, uint32_t prev,
+					uint32_t node)
+{
+	struct ciheap_node* n = heap->arena->nodes;
+	if (prev != CIHEAP_NIL)
+		n[prev].next = n[node].next;
+	else
+		heap->head = n[node].next;
+	if (heap->tail == node)
+		heap->tail = prev;
+}
+
+static inline void __ciheap_min(struct ciheap* heap,
+				uint32_t* prev, uint32_t* node)
+{
+	struct ciheap_node* n = heap->arena->nodes;
+	uint32_t _prev, cur;
+	*prev = CIHEAP_NIL;
+
+	if (heap->head == CIHEAP_NIL) {
+		*node = CIHEAP_NIL;
+		return;
+	}
+
+	__HEAP_STAT(heap, min_scans, 1);
+	__HEAP_STAT(heap, roots_scanned, 1);
+	*node = heap->head;
+	_prev = heap->head;
+	cur   = n[heap->head].next;
+	while (cur != CIHEAP_NIL) {
+		__HEAP_STAT(heap, roots_scanned, 1);
+		if (__ciheap_less(heap, cur, *node)) {
+			*node = cur;
+			*prev = _prev;
+		}
+		_prev = cur;
+		cur   = n[cur].next;
+	}
+}
+
+static inline void __ciheap_union(struct ciheap* heap, uint32_t h2)
+{
+	struct ciheap_node* n = heap->arena->nodes;
+	uint32_t h1;
+	uint32_t prev, x, next;
+	if (h2 == CIHEAP_NIL)
+		return;
+	h1 = heap->head;
+	if (h1 == CIHEAP_NIL) {
+		__ciheap_set_roots(heap, h2);
+		return;
+	}
+	h1 = __ciheap_merge(n, h1, h2);
+	prev = CIHEAP_NIL;
+	x    = h1;
+	next = n[x].next;
+	while (next != CIHEAP_NIL) {
+		if (n[x].degree != n[next].degree ||
+		    (n[next].next != CIHEAP_NIL &&
+		     n[n[next].next].degree == n[x].degree)) {
+			/* nothing to do, advance */
+			prev = x;
+			x    = next;
+		} else if (__ciheap_less(heap, x, next)) {
+			/* x becomes the root of next */
+			n[x].next = n[next].next;
+			__ciheap_link(n, x, next);
+			__HEAP_STAT(heap, links, 1);
+		} else {
+			/* next becomes the root of x */
+			if (prev != CIHEAP_NIL)
+				n[prev].next = next;
+			else
+				h1 = next;
+			__ciheap_link(n, next, x);
+			__HEAP_STAT(heap, links, 1);
+			x = next;
+		}
+		next = n[x].next;
+	}
+	heap->head = h1;
+	heap->tail = x;
+}
+
+/* see __iheap_carry() */
+static inline void __ciheap_carry(struct ciheap* heap, uint32_t* trees,
+				  uint32_t node, int sorted)
+{
+	struct ciheap_node* n = heap->arena->nodes;
+	uint32_t other;
+	unsigned int d = n[node].degree;
+	while ((other = trees[d]) != CIHEAP_NIL) {
+		trees[d] = CIHEAP_NIL;
+		/* If the input is sorted, the earlier tree always wins. */
+		if (!sorted && __ciheap_less(heap, node, other))
+			__ciheap_link(n, node, other);
+		else {
+			__ciheap_link(n, other, node);
+			node = other;
+		}
+		__HEAP_STAT(heap, links, 1);
+		d++;
+	}
+	trees[d] = node;
+}
+
+/* turn the first limit slots of an array of trees into a root list,
+ * ordered by degree
+ */
+static inline uint32_t __ciheap_collect(struct ciheap_node* n,
+					uint32_t* trees, unsigned int limit)
+{
+	uint32_t head = CIHEAP_NIL;
+	unsigned int d = limit;
+	while (d--)
+		if (trees[d] != CIHEAP_NIL) {
+			n[trees[d]].next = head;
+			head = trees[d];
+		}
+	return head;
+}
+
+/* link roots of equal degree until all degrees are unique (lazy mode) */
+static inline void __ciheap_consolidate(struct ciheap* heap)
+{
+	struct ciheap_node* n = heap->arena->nodes;
+	uint32_t trees[HEAP_MAX_DEGREE];
+	uint32_t pos, next;
+	unsigned int d, limit, max = 0;
+	unsigned long roots = 0;
+	int ordered = 1;
+	for (pos = heap->head; pos != CIHEAP_NIL; pos = n[pos].next) {
+		next = n[pos].next;
+		if (next != CIHEAP_NIL && n[pos].degree >= n[next].degree)
+			ordered = 0;
+		if (n[pos].degree > max)
+			max = n[pos].degree;
+		roots++;
+	}
+	/* nothing to do if the degrees are already unique and ordered */
+	if (ordered)
+		return;
+	/* no resulting tree can have a degree beyond max + log2(roots) */
+	limit = max + 1;
+	while (roots >>= 1)
+		limit++;
+	if (limit > HEAP_MAX_DEGREE)
+		limit = HEAP_MAX_DEGREE;
+	for (d = 0; d < limit; d++)
+		trees[d] = CIHEAP_NIL;
+	for (pos = heap->head; pos != CIHEAP_NIL; pos = next) {
+		next = n[pos].next;
+		__ciheap_carry(heap, trees, pos, 0);
+	}
+	__ciheap_set_roots(heap, __ciheap_collect(n, trees, limit));
+}
+
+/* prepend the roots from h2 to t2 without linking (lazy mode) */
+static inline void __ciheap_splice(struct ciheap* heap, uint32_t h2,
+				   uint32_t t2)
+{
+	if (h2 == CIHEAP_NIL)
+		return;
+	heap->arena->nodes[t2].next = heap->head;
+	if (heap->head == CIHEAP_NIL)
+		heap->tail = t2;
+	heap->head = h2;
+}
+
+/* h2 is a single tree or the pieces of one, i.e., O(log n) roots */
+static inline void __ciheap_add_roots(struct ciheap* heap, uint32_t h2)
+{
+	struct ciheap_node* n = heap->arena->nodes;
+	uint32_t t2;
+	if (heap->lazy) {
+		for (t2 = h2; t2 != CIHEAP_NIL && n[t2].next != CIHEAP_NIL;
+		     t2 = n[t2].next)
+			;
+		__ciheap_splice(heap, h2, t2);
+	} else
+		__ciheap_union(heap, h2);
+}
+
+static inline uint32_t __ciheap_extract_min(struct ciheap* heap)
+{
+	struct ciheap_node* n = heap->arena->nodes;
+	uint32_t prev, node;
+	if (heap->lazy)
+		__ciheap_consolidate(heap);
+	__ciheap_min(heap, &prev, &node);
+	if (node == CIHEAP_NIL)
+		return CIHEAP_NIL;
+	__ciheap_remove_root(heap, prev, node);
+	__ciheap_union(heap, __ciheap_reverse(n, n[node].child));
+	return node;
+}
+
+static inline void __ciheap_reset(struct ciheap_node* n, uint32_t node)
+{
+	n[node].child  = CIHEAP_NIL;
+	n[node].parent = CIHEAP_NIL;
+	n[node].next   = CIHEAP_NIL;
+	n[node].degree = 0;
+}
+
+/* insert (and reinitialize) a node into the heap */
+static inline void ciheap_insert(struct ciheap* heap, uint32_t node)
+{
+	struct ciheap_node* n = heap->arena->nodes;
+	uint32_t min;
+	__ciheap_reset(n, node);
+	if (heap->min != CIHEAP_NIL && __ciheap_less(heap, node, heap->min)) {
+		/* swap min cache */
+		min = heap->min;
+		__ciheap_reset(n, min);
+		__ciheap_add_roots(heap, min);
+		heap->min = node;
+	} else
+		__ciheap_add_roots(heap, node);
+}
+
+static inline void __ciheap_uncache_min(struct ciheap* heap)
+{
+	uint32_t min;
+	if (heap->min != CIHEAP_NIL) {
+		min = heap->min;
+		heap->min = CIHEAP_NIL;
+		ciheap_insert(heap, min);
+	}
+}
+
+/* merge addition into target; both must share an arena */
+static inline void ciheap_union(struct ciheap* target,
+				struct ciheap* addition)
+{
+	/* first insert any cached minima, if necessary */
+	__ciheap_uncache_min(target);
+	__ciheap_uncache_min(addition);
+	/* an eager heap expects its roots to have unique degrees */
+	if (target->lazy)
+		__ciheap_splice(target, addition->head, addition->tail);
+	else {
+		if (addition->lazy)
+			__ciheap_consolidate(addition);
+		__ciheap_union(target, addition->head);
+	}
+	/* this is a destructive merge */
+	addition->head = CIHEAP_NIL;
+	addition->tail = CIHEAP_NIL;
+}
+
+static inline void __ciheap_build(struct ciheap* heap,
+				  const uint32_t* nodes, size_t n, int sorted)
+{
+	uint32_t trees[HEAP_MAX_DEGREE];
+	size_t i;
+	for (i = 0; i < HEAP_MAX_DEGREE; i++)
+		trees[i] = CIHEAP_NIL;
+	for (i = 0; i < n; i++) {
+		__ciheap_reset(heap->arena->nodes, nodes[i]);
+		__ciheap_carry(heap, trees, nodes[i], sorted);
+	}
+	/* the cached minimum might not be the minimum anymore */
+	__ciheap_uncache_min(heap);
+	__ciheap_add_roots(heap, __ciheap_collect(heap->arena->nodes, trees,
+						  HEAP_MAX_DEGREE));
+}
+
+/* insert (and reinitialize) n nodes at once in O(n) time */
+static inline void ciheap_build(struct ciheap* heap,
+				const uint32_t* nodes, size_t n)
+{
+	__ciheap_build(heap, nodes, n, 0);
+}
+
+/* like ciheap_build(), but nodes must be sorted in order of increasing key;
+ * no comparisons are required in this case
+ */
+static inline void ciheap_build_sorted(struct ciheap* heap,
+				       const uint32_t* nodes, size_t n)
+{
+	__ciheap_build(heap, nodes, n, 1);
+}
+
+/* returns CIHEAP_NIL if the heap is empty */
+static inline uint32_t ciheap_peek(struct ciheap* heap)
+{
+	if (heap->min == CIHEAP_NIL) {
+		__HEAP_STAT(heap, min_misses, 1);
+		heap->min = __ciheap_extract_min(heap);
+	} else
+		__HEAP_STAT(heap, min_hits, 1);
+	return heap->min;
+}
+
+/* The node is removed from the heap, but stays allocated until the caller
+ * hands it to ciheap_node_free(). Returns CIHEAP_NIL if the heap is empty.
+ */
+static inline uint32_t ciheap_take(struct ciheap* heap)
+{
+	uint32_t node;
+	if (heap->min == CIHEAP_NIL) {
+		__HEAP_STAT(heap, min_misses, 1);
+		heap->min = __ciheap_extract_min(heap);
+	} else
+		__HEAP_STAT(heap, min_hits, 1);
+	node = heap->min;
+	heap->min = CIHEAP_NIL;
+	if (node != CIHEAP_NIL)
+		heap->arena->nodes[node].degree = NOT_IN_HEAP;
+	return node;
+}
+
+/* take node's tree apart and remove node; see __iheap_cut() */
+static inline uint32_t __ciheap_cut(struct ciheap* heap, uint32_t node)
+{
+	struct ciheap_node* n = heap->arena->nodes;
+	uint32_t path[HEAP_MAX_DEGREE];
+	uint32_t head = CIHEAP_NIL, root, down, pos, next, prev;
+	unsigned int depth = 0;
+
+	for (root = node; n[root].parent != CIHEAP_NIL; root = n[root].parent)
+		path[depth++] = root;
+	__HEAP_STAT(heap, bubble_depth, depth);
+	prev = CIHEAP_NIL;
+	for (pos = heap->head; pos != root; pos = n[pos].next)
+		prev = pos;
+	__ciheap_remove_root(heap, prev, root);
+	while (depth--) {
+		down = path[depth];
+		/* children are ordered by decreasing degree */
+		for (pos = n[root].child; pos != down; pos = next) {
+			next          = n[pos].next;
+			n[pos].parent = CIHEAP_NIL;
+			n[pos].next   = head;
+			head          = pos;
+		}
+		n[root].child  = n[down].next;
+		n[root].degree = n[down].degree;
+		n[root].next   = head;
+		head           = root;
+		n[down].parent = CIHEAP_NIL;
+		root           = down;
+	}
+	for (pos = n[node].child; pos != CIHEAP_NIL; pos = next) {
+		next          = n[pos].next;
+		n[pos].parent = CIHEAP_NIL;
+		n[pos].next   = head;
+		head          = pos;
+	}
+	return head;
+}
+
+/* see __iheap_cut_out() */
+static inline void __ciheap_cut_out(struct ciheap* heap, uint32_t node)
+{
+	if (heap->lazy)
+		__ciheap_consolidate(heap);
+	__ciheap_add_roots(heap, __ciheap_cut(heap, node));
+}
+
+/* see iheap_decrease_relink() */
+static inline void ciheap_decrease(struct ciheap* heap, uint32_t node,
+				   int new_key)
+{
+	struct ciheap_node* n = heap->arena->nodes;
+
+	if (new_key >= n[node].key)
+		return;
+	n[node].key = new_key;
+	if (heap->min == node)
+		return;
+	if (n[node].parent != CIHEAP_NIL &&
+	    __ciheap_less(heap, node, n[node].parent)) {
+		__ciheap_cut_out(heap, node);
+		/* swaps the min cache if necessary */
+		ciheap_insert(heap, node);
+	} else if (heap->min != CIHEAP_NIL &&
+		   __ciheap_less(heap, node, heap->min))
+		__ciheap_uncache_min(heap);
+}
+
+/* The node stays allocated, as with ciheap_take(). */
+static inline void ciheap_delete(struct ciheap* heap, uint32_t node)
+{
+	if (heap->min != node)
+		__ciheap_cut_out(heap, node);
+	else
+		heap->min = CIHEAP_NIL;
+	heap->arena->nodes[node].degree = NOT_IN_HEAP;
+}
+
+#endif /* CIHEAP_H */
@@ -0,0 +1,167 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+
+#include "ciheap.h"
+
+/* Two heaps share an arena. Random inserts, takes, decreases, deletes, and
+ * unions run against a table of the keys that should be in each heap. Node
+ * indices must stay valid while the arena grows, freed slots must be handed
+ * out again before the arena grows, and a deleted node must be reusable
+ * after ciheap_node_init().
+ */
+
+#define N	2000
+#define STEPS	40000
+
+/* the payload of each node is its slot number */
+struct slot {
+	uint32_t	idx;
+	int		key;
+	/* 0 or 1, or -1 if the slot has no node */
+	int		heap;
+};
+
+static struct slot slots[N];
+static struct ciheap_arena arena;
+static struct ciheap heaps[2];
+/* nodes allocated now, and at most so far */
+static uint32_t live, peak;
+
+static int min_key(int h)
+{
+	int i, min = INT_MAX;
+	for (i = 0; i < N; i++)
+		if (slots[i].heap == h && slots[i].key < min)
+			min = slots[i].key;
+	return min;
+}
+
+/* random slot in heap h (-1: without a node), or -1 if there is none */
+static int pick(int h)
+{
+	int i, start = rand() % N;
+	for (i = 0; i < N; i++)
+		if (slots[(start + i) % N].heap == h)
+			return (start + i) % N;
+	return -1;
+}
+
+static int add(int s, int h)
+{
+	slots[s].key  = rand() % N;
+	slots[s].idx  = ciheap_node_alloc(&arena, slots[s].key, (uint32_t) s);
+	slots[s].heap = h;
+	if (slots[s].idx == CIHEAP_NIL) {
+		fprintf(stderr, "citest: arena full\n");
+		return 1;
+	}
+	ciheap_insert(heaps + h, slots[s].idx);
+	if (++live > peak)
+		peak = live;
+	return 0;
+}
+
+static void drop(int s)
+{
+	ciheap_node_free(&arena, slots[s].idx);
+	slots[s].heap = -1;
+	live--;
+}
+
+static int take(int h)
+{
+	uint32_t hn, s;
+	int expected = min_key(h);
+
+	hn = ciheap_take(heaps + h);
+	if (hn == CIHEAP_NIL)
+		return expected != INT_MAX;
+	s = ciheap_node_value(&arena, hn);
+	if (s >= N || slots[s].idx != hn || slots[s].heap != h ||
+	    ciheap_node_key(&arena, hn) != expected ||
+	    ciheap_node_in_heap(&arena, hn)) {
+		fprintf(stderr, "citest: took %d from heap %d, expected %d\n",
+			ciheap_node_key(&arena, hn), h, expected);
+		return 1;
+	}
+	drop((int) s);
+	return 0;
+}
+
+static int test_random(int lazy)
+{
+	int i, h, s, dice, err = 0;
+
+	ciheap_arena_init(&arena);
+	for (h = 0; h < 2; h++)
+		if (lazy)
+			ciheap_init_lazy(heaps + h, &arena);
+		else
+			ciheap_init(heaps + h, &arena);
+	for (i = 0; i < N; i++)
+		slots[i].heap = -1;
+	live = peak = 0;
+
+	for (i = 0; i < STEPS && !err; i++) {
+		h    = rand() % 2;
+		dice = rand() % 16;
+		if (dice < 6) {
+			if ((s = pick(-1)) >= 0)
+				err = add(s, h);
+		} else if (dice == 6) {
+			/* cache the minimum for the operations that follow */
+			ciheap_peek(heaps + h);
+		} else if (dice < 9) {
+			err = take(h);
+		} else if (dice < 11) {
+			if ((s = pick(h)) < 0)
+				continue;
+			slots[s].key -= rand() % N;
+			ciheap_decrease(heaps + h, slots[s].idx, slots[s].key);
+		} else if (dice < 13) {
+			if ((s = pick(h)) < 0)
+				continue;
+			ciheap_delete(heaps + h, slots[s].idx);
+			drop(s);
+		} else if (dice < 15) {
+			/* move the node to the other heap under a new key */
+			if ((s = pick(h)) < 0)
+				continue;
+			ciheap_delete(heaps + h, slots[s].idx);
+			slots[s].key  = rand() % N;
+			slots[s].heap = !h;
+			ciheap_node_init(&arena, slots[s].idx, slots[s].key,
+					 (uint32_t) s);
+			ciheap_insert(heaps + !h, slots[s].idx);
+		} else if (rand() % 4 == 0) {
+			ciheap_union(heaps, heaps + 1);
+			for (s = 0; s < N; s++)
+				if (slots[s].heap == 1)
+					slots[s].heap = 0;
+		}
+	}
+	for (h = 0; h < 2 && !err; h++)
+		while (!err && !ciheap_empty(heaps + h))
+			err = take(h);
+	if (!err && (pick(0) >= 0 || pick(1) >= 0)) {
+		fprintf(stderr, "citest: heap ran empty too early\n");
+		err = 1;
+	}
+	/* every node was allocated from a freed slot while there was one */
+	if (!err && arena.size != peak) {
+		fprintf(stderr, "citest: arena has %u slots for at most %u "
+			"nodes\n", (unsigned) arena.size, (unsigned) peak);
+		err = 1;
+	}
+	ciheap_arena_destroy(&arena);
+	return err;
+}
+
+int main(int argc __attribute__((unused)), char** argv __attribute__((unused)))
+{
+	srand(1);
+	if (test_random(0) || test_random(1))
+		return 1;
+	return 0;
+}
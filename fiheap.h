@@ -0,0 +1,332 @@
+/* fiheap.h -- Fibonacci Heaps with integer keys
+ *
+ * Copyright (c) 2008, Bjoern B. Brandenburg <bbb [at] cs.unc.edu>
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University of North Carolina nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY  COPYRIGHT OWNER AND CONTRIBUTERS ``AS IS'' AND
+ * ANY  EXPRESS OR  IMPLIED  WARRANTIES,  INCLUDING, BUT  NOT  LIMITED TO,  THE
+ * IMPLIED WARRANTIES  OF MERCHANTABILITY AND FITNESS FOR  A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO  EVENT SHALL THE  COPYRIGHT OWNER OR  CONTRIBUTERS BE
+ * LIABLE  FOR  ANY  DIRECT,   INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT  OF
+ * SUBSTITUTE GOODS  OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+ * INTERRUPTION)  HOWEVER CAUSED  AND ON  ANY THEORY  OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR  TORT (INCLUDING  NEGLIGENCE OR  OTHERWISE)
+ * ARISING IN ANY WAY  OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef FIHEAP_H
+#define FIHEAP_H
+
+#define NOT_IN_HEAP UINT_MAX
+
+/* Upper bound on the degree of any node; requires <limits.h>. A node of
+ * degree d has at least F(d + 2) >= phi^d descendants, so no degree exceeds
+ * log_phi(n) < 1.5 * log2(n).
+ */
+#define FIHEAP_MAX_DEGREE (sizeof(size_t) * CHAR_BIT * 3 / 2)
+
+#ifdef HEAP_STATS
+#include "heap_stats.h"
+#define __HEAP_STAT(heap, field, n)	((heap)->stats.field += (n))
+#else
+#define __HEAP_STAT(heap, field, n)	((void) (heap))
+#endif
+
+/* A Fibonacci heap keeps its roots, and the children of every node, in
+ * circular doubly-linked lists. Insert and union only splice lists. Take
+ * links roots of equal degree until all degrees are unique, much like
+ * iheap.h in lazy mode. Decrease cuts the node from its parent and makes it
+ * a root; a parent that loses a second child is cut as well (cascading
+ * cut), which keeps trees bushy enough for the degree bound. Hence,
+ * decrease is O(1) amortized instead of O(log n), and nodes never exchange
+ * keys or values, so no refs are needed.
+ */
+struct fiheap_node {
+	struct fiheap_node*	parent;
+	struct fiheap_node*	child;
+	struct fiheap_node*	prev;
+	struct fiheap_node*	next;
+
+	unsigned int		degree;
+	/* lost a child since it became a child itself */
+	int			marked;
+	int			key;
+	const void*		value;
+};
+
+struct fiheap {
+	/* the root with the smallest key, NULL iff the heap is empty */
+	struct fiheap_node*	min;
+#ifdef HEAP_STATS
+	struct heap_stats	stats;
+#endif
+};
+
+static inline void fiheap_init(struct fiheap* heap)
+{
+	heap->min = NULL;
+#ifdef HEAP_STATS
+	heap_stats_reset(&heap->stats);
+#endif
+}
+
+static inline void fiheap_node_init(struct fiheap_node* h, int key,
+				    const void* value)
+{
+	h->parent = NULL;
+	h->child  = NULL;
+	h->prev   = h;
+	h->next   = h;
+	h->degree = NOT_IN_HEAP;
+	h->marked = 0;
+	h->key    = key;
+	h->value  = value;
+}
+
+static inline const void* fiheap_node_value(struct fiheap_node* h)
+{
+	return h->value;
+}
+
+static inline int fiheap_node_in_heap(struct fiheap_node* h)
+{
+	return h->degree != NOT_IN_HEAP;
+}
+
+static inline int fiheap_empty(struct fiheap* heap)
+{
+	return heap->min == NULL;
+}
+
+/* all key comparisons go through here so that they can be counted */
+static inline int __fiheap_less(struct fiheap* heap,
+				struct fiheap_node* a, struct fiheap_node* b)
+{
+	__HEAP_STAT(heap, compares, 1);
+	return a->key < b->key;
+}
+
+/* join two circular lists; b's list follows a */
+static inline void __fiheap_splice(struct fiheap_node* a,
+				   struct fiheap_node* b)
+{
+	struct fiheap_node* a_next = a->next;
+	struct fiheap_node* b_prev = b->prev;
+	a->next      = b;
+	b->prev      = a;
+	b_prev->next = a_next;
+	a_next->prev = b_prev;
+}
+
+/* remove node from its circular list */
+static inline void __fiheap_unlink(struct fiheap_node* node)
+{
+	node->prev->next = node->next;
+	node->next->prev = node->prev;
+	node->prev = node;
+	node->next = node;
+}
+
+/* make child a subtree of root */
+static inline void __fiheap_link(struct fiheap_node* root,
+				 struct fiheap_node* child)
+{
+	child->parent = root;
+	child->marked = 0;
+	child->prev   = child;
+	child->next   = child;
+	if (root->child)
+		__fiheap_splice(root->child, child);
+	else
+		root->child = child;
+	root->degree++;
+}
+
+/* add a detached node (or list of nodes) to the root list */
+static inline void __fiheap_add_roots(struct fiheap* heap,
+				      struct fiheap_node* node)
+{
+	if (heap->min)
+		__fiheap_splice(heap->min, node);
+	else
+		heap->min = node;
+}
+
+/* move node from its parent's child list to the root list */
+static inline void __fiheap_cut(struct fiheap* heap, struct fiheap_node* node)
+{
+	struct fiheap_node* parent = node->parent;
+	if (node->next == node)
+		parent->child = NULL;
+	else if (parent->child == node)
+		parent->child = node->next;
+	__fiheap_unlink(node);
+	parent->degree--;
+	node->parent = NULL;
+	node->marked = 0;
+	__fiheap_add_roots(heap, node);
+	__HEAP_STAT(heap, bubble_depth, 1);
+}
+
+/* node just lost a child: mark it, or cut it if it already was marked */
+static inline void __fiheap_cascade(struct fiheap* heap,
+				    struct fiheap_node* node)
+{
+	struct fiheap_node* parent;
+	while ((parent = node->parent)) {
+		if (!node->marked) {
+			node->marked = 1;
+			return;
+		}
+		__fiheap_cut(heap, node);
+		node = parent;
+	}
+}
+
+/* link roots of equal degree until all degrees are unique */
+static inline void __fiheap_consolidate(struct fiheap* heap)
+{
+	struct fiheap_node* trees[FIHEAP_MAX_DEGREE];
+	struct fiheap_node *pos, *next, *other;
+	unsigned int d, limit = 0;
+
+	for (d = 0; d < FIHEAP_MAX_DEGREE; d++)
+		trees[d] = NULL;
+	__HEAP_STAT(heap, min_scans, 1);
+	/* open the root list; the trees are collected into a new one */
+	pos = heap->min;
+	pos->prev->next = NULL;
+	for (; pos; pos = next) {
+		next = pos->next;
+		__HEAP_STAT(heap, roots_scanned, 1);
+		d = pos->degree;
+		while ((other = trees[d])) {
+			trees[d] = NULL;
+			if (__fiheap_less(heap, other, pos)) {
+				__fiheap_link(other, pos);
+				pos = other;
+			} else
+				__fiheap_link(pos, other);
+			__HEAP_STAT(heap, links, 1);
+			d++;
+		}
+		trees[d] = pos;
+		if (d >= limit)
+			limit = d + 1;
+	}
+	heap->min = NULL;
+	for (d = 0; d < limit; d++)
+		if ((pos = trees[d])) {
+			pos->prev = pos;
+			pos->next = pos;
+			if (heap->min) {
+				__fiheap_splice(heap->min, pos);
+				if (__fiheap_less(heap, pos, heap->min))
+					heap->min = pos;
+			} else
+				heap->min = pos;
+		}
+}
+
+/* insert (and reinitialize) a node into the heap in O(1) */
+static inline void fiheap_insert(struct fiheap* heap, struct fiheap_node* node)
+{
+	node->parent = NULL;
+	node->child  = NULL;
+	node->prev   = node;
+	node->next   = node;
+	node->degree = 0;
+	node->marked = 0;
+	__fiheap_add_roots(heap, node);
+	if (__fiheap_less(heap, node, heap->min))
+		heap->min = node;
+}
+
+/* merge addition into target in O(1) */
+static inline void fiheap_union(struct fiheap* target,
+				struct fiheap* addition)
+{
+	struct fiheap_node* min = addition->min;
+	if (!min)
+		return;
+	__fiheap_add_roots(target, min);
+	if (__fiheap_less(target, min, target->min))
+		target->min = min;
+	/* this is a destructive merge */
+	addition->min = NULL;
+}
+
+static inline struct fiheap_node* fiheap_peek(struct fiheap* heap)
+{
+	return heap->min;
+}
+
+static inline struct fiheap_node* fiheap_take(struct fiheap* heap)
+{
+	struct fiheap_node *node = heap->min, *pos;
+	if (!node)
+		return NULL;
+	/* the children become roots */
+	if ((pos = node->child)) {
+		do {
+			pos->parent = NULL;
+			pos = pos->next;
+		} while (pos != node->child);
+		__fiheap_splice(node, node->child);
+		node->child = NULL;
+	}
+	if (node->next == node)
+		heap->min = NULL;
+	else {
+		heap->min = node->next;
+		__fiheap_unlink(node);
+		__fiheap_consolidate(heap);
+	}
+	node->degree = NOT_IN_HEAP;
+	return node;
+}
+
+/* lower node's key to new_key in O(1) amortized */
+static inline void fiheap_decrease(struct fiheap* heap,
+				   struct fiheap_node* node, int new_key)
+{
+	struct fiheap_node* parent;
+	if (new_key >= node->key)
+		return;
+	node->key = new_key;
+	parent = node->parent;
+	if (parent && __fiheap_less(heap, node, parent)) {
+		__fiheap_cut(heap, node);
+		__fiheap_cascade(heap, parent);
+	}
+	if (__fiheap_less(heap, node, heap->min))
+		heap->min = node;
+}
+
+/* remove node as if its key had been decreased below all others */
+static inline void fiheap_delete(struct fiheap* heap, struct fiheap_node* node)
+{
+	struct fiheap_node* parent = node->parent;
+	if (parent) {
+		__fiheap_cut(heap, node);
+		__fiheap_cascade(heap, parent);
+	}
+	heap->min = node;
+	fiheap_take(heap);
+}
+
+#endif /* FIHEAP_H */
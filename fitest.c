@@ -0,0 +1,213 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+
+#include "fiheap.h"
+
+/* Check the cascading cuts on a tree of known shape, and then insert, take,
+ * decrease, delete, and merge at random against a table of the keys that
+ * should be in each heap.
+ */
+
+#define N	17
+
+static struct fiheap_node nodes[N];
+
+/* the child of node with the given degree, or NULL */
+static struct fiheap_node* child(struct fiheap_node* node, unsigned int degree)
+{
+	struct fiheap_node* pos = node->child;
+	if (pos)
+		do {
+			if (pos->degree == degree)
+				return pos;
+			pos = pos->next;
+		} while (pos != node->child);
+	return NULL;
+}
+
+static int check_node(const char* what, struct fiheap_node* node,
+		      struct fiheap_node* parent, int marked)
+{
+	if (node->parent != parent || node->marked != marked) {
+		fprintf(stderr, "fitest: %s: parent %d, marked %d\n", what,
+			node->parent ? node->parent->key : INT_MIN,
+			node->marked);
+		return 1;
+	}
+	return 0;
+}
+
+/* After taking the smallest of 17 keys, the other 16 are consolidated into a
+ * single binomial tree of degree 4 below a root r. Let g be r's child of
+ * degree 3, and p be g's child of degree 2. Cutting the first child of p
+ * marks p, and cutting the second one cuts p as well and marks g. Cutting
+ * another child of g then cuts g, but the root r stays unmarked.
+ */
+static int test_cascade(void)
+{
+	struct fiheap heap;
+	struct fiheap_node *hn, *r, *g, *p;
+	int i, key = -1, last = INT_MIN;
+
+	fiheap_init(&heap);
+	for (i = 0; i < N; i++) {
+		fiheap_node_init(nodes + i, i, NULL);
+		fiheap_insert(&heap, nodes + i);
+	}
+	fiheap_take(&heap);
+	r = fiheap_peek(&heap);
+	if (r->degree != 4 || r->next != r || !(g = child(r, 3)) ||
+	    !(p = child(g, 2))) {
+		fprintf(stderr, "fitest: no binomial tree to cut into\n");
+		return 1;
+	}
+
+	fiheap_decrease(&heap, child(p, 1), key--);
+	if (check_node("p after one cut", p, g, 1) ||
+	    check_node("g after one cut", g, r, 0))
+		return 1;
+	fiheap_decrease(&heap, child(p, 0), key--);
+	if (check_node("p after two cuts", p, NULL, 0) ||
+	    check_node("g after two cuts", g, r, 1))
+		return 1;
+	fiheap_decrease(&heap, child(g, 0), key--);
+	if (check_node("g after three cuts", g, NULL, 0) ||
+	    check_node("r after three cuts", r, NULL, 0) || r->degree != 3)
+		return 1;
+
+	for (i = 1; (hn = fiheap_take(&heap)); i++) {
+		if (hn->key < last) {
+			fprintf(stderr, "fitest: took %d after %d\n", hn->key,
+				last);
+			return 1;
+		}
+		last = hn->key;
+	}
+	if (i != N) {
+		fprintf(stderr, "fitest: took %d of %d keys\n", i - 1, N - 1);
+		return 1;
+	}
+	return 0;
+}
+
+#define M	1000
+#define STEPS	40000
+
+/* the value of each node is its slot */
+struct slot {
+	/* 0 or 1, or -1 if not in a heap */
+	int			heap;
+	struct fiheap_node	node;
+};
+
+static struct slot slots[M];
+static struct fiheap heaps[2];
+
+static int min_key(int h)
+{
+	int i, min = INT_MAX;
+	for (i = 0; i < M; i++)
+		if (slots[i].heap == h && slots[i].node.key < min)
+			min = slots[i].node.key;
+	return min;
+}
+
+/* random slot in heap h (-1: not in a heap), or NULL */
+static struct slot* pick(int h)
+{
+	int i, start = rand() % M;
+	for (i = 0; i < M; i++)
+		if (slots[(start + i) % M].heap == h)
+			return &slots[(start + i) % M];
+	return NULL;
+}
+
+static int check_min(int h)
+{
+	struct fiheap_node* hn = fiheap_peek(heaps + h);
+	int expected = min_key(h);
+
+	if (hn ? hn->key != expected || hn->parent : expected != INT_MAX) {
+		fprintf(stderr, "fitest: heap %d: minimum %d, expected a root "
+			"with %d\n", h, hn ? hn->key : INT_MAX, expected);
+		return 1;
+	}
+	return 0;
+}
+
+static int take(int h)
+{
+	struct fiheap_node* hn;
+	struct slot* s;
+	int expected = min_key(h);
+
+	hn = fiheap_take(heaps + h);
+	if (!hn)
+		return expected != INT_MAX;
+	s = (struct slot*) fiheap_node_value(hn);
+	if (&s->node != hn || s->heap != h || hn->key != expected ||
+	    fiheap_node_in_heap(hn)) {
+		fprintf(stderr, "fitest: took %d from heap %d, expected %d\n",
+			hn->key, h, expected);
+		return 1;
+	}
+	s->heap = -1;
+	return 0;
+}
+
+static int test_random(void)
+{
+	struct slot* s;
+	int i, h, dice, err = 0;
+
+	for (h = 0; h < 2; h++)
+		fiheap_init(heaps + h);
+	for (i = 0; i < M; i++)
+		slots[i].heap = -1;
+	for (i = 0; i < STEPS && !err; i++) {
+		h    = rand() % 2;
+		dice = rand() % 16;
+		if (dice < 6) {
+			if (!(s = pick(-1)))
+				continue;
+			fiheap_node_init(&s->node, rand() % M, s);
+			fiheap_insert(heaps + h, &s->node);
+			s->heap = h;
+		} else if (dice < 9) {
+			err = take(h);
+		} else if (dice < 13) {
+			if (!(s = pick(h)))
+				continue;
+			fiheap_decrease(heaps + h, &s->node,
+					s->node.key - rand() % M);
+		} else if (dice < 15) {
+			if (!(s = pick(h)))
+				continue;
+			fiheap_delete(heaps + h, &s->node);
+			s->heap = -1;
+		} else if (rand() % 4 == 0) {
+			fiheap_union(heaps + h, heaps + !h);
+			for (s = slots; s < slots + M; s++)
+				if (s->heap == !h)
+					s->heap = h;
+		}
+		err = err || check_min(0) || check_min(1);
+	}
+	for (h = 0; h < 2 && !err; h++)
+		while (!err && !fiheap_empty(heaps + h))
+			err = take(h);
+	if (!err && (pick(0) || pick(1))) {
+		fprintf(stderr, "fitest: heap ran empty too early\n");
+		err = 1;
+	}
+	return err;
+}
+
+int main(int argc __attribute__((unused)), char** argv __attribute__((unused)))
+{
+	srand(1);
+	if (test_cascade() || test_random())
+		return 1;
+	return 0;
+}
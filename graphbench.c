@@ -0,0 +1,720 @@
+/* graphbench.c -- Dijkstra and Prim on the heaps with decrease-key
+ *
+ * Usage: graphbench [-n vertices] [-d degree] [-w max weight] [-k sources]
+ *                   [-s seed] [-f file.gr]...
+ *
+ * Runs Dijkstra's shortest paths and Prim's minimum spanning tree, from k
+ * random sources, over
+ *   - grid:     a square grid with four neighbours per vertex,
+ *   - random:   a uniform random graph with average degree d, and
+ *   - powerlaw: a preferential-attachment graph with average degree d,
+ * all undirected with uniform random weights in [1, w]. With -f, the given
+ * DIMACS shortest-path files ("p sp n m" and "a u v w" lines) are used
+ * instead. Prim treats arcs as undirected edges; this is exact for files
+ * that list both directions of every road, as the DIMACS road networks do.
+ *
+ * Each vertex owns one queue node, which is inserted when the vertex is
+ * first reached and decreased on every later improvement. The queues are
+ *   - iheap:  iheap.h (decrease relinks, since nodes have no refs),
+ *   - heap:   heap.h with a comparator on the vertices' keys,
+ *   - riheap: riheap.h,
+ *   - fiheap: fiheap.h (decrease cuts the node instead of moving it up),
+ *   - rheap:  rheap.h, a radix heap (Dijkstra only: Prim's keys are not
+ *             monotone), and
+ *   - binary: an indexed binary heap, the usual textbook choice.
+ * Reports edge relaxations (arcs scanned) per second and the share of queue
+ * operations that are decreases. Denser graphs (-d) have more decreases per
+ * take, which is where fiheap's O(1) amortized decrease has to pay for its
+ * costlier take. All queues must agree on the sum of the
+ * distances (Dijkstra) and on the tree weight (Prim).
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "iheap.h"
+#include "heap.h"
+#include "riheap.h"
+#include "fiheap.h"
+#include "rheap.h"
+
+struct graph {
+	const char*	name;
+	uint32_t	n;
+	/* arcs of vertex v are off[v] .. off[v + 1] - 1 */
+	uint32_t*	off;
+	uint32_t*	dst;
+	int*		weight;
+};
+
+struct edge {
+	uint32_t	u;
+	uint32_t	v;
+	int		w;
+};
+
+struct edges {
+	struct edge*	e;
+	size_t		n;
+	size_t		capacity;
+};
+
+enum { UNSEEN, QUEUED, DONE };
+
+struct search {
+	uint32_t		n;
+	/* tentative distance (Dijkstra) or edge weight (Prim) */
+	int*			key;
+	unsigned char*		state;
+	struct iheap		iheap;
+	struct iheap_node*	inodes;
+	struct heap		heap;
+	struct heap_node*	hnodes;
+	struct riheap		riheap;
+	struct fiheap		fiheap;
+	struct fiheap_node*	fnodes;
+	struct rheap		rheap;
+	struct rheap_node*	rnodes;
+	/* binary heap of vertices, and each vertex's index in it */
+	uint32_t*		bheap;
+	uint32_t*		bpos;
+	uint32_t		bsize;
+
+	unsigned long		relaxations;
+	unsigned long		inserts;
+	unsigned long		decreases;
+	unsigned long		takes;
+};
+
+/* a queue of vertices, ordered by their keys in struct search */
+struct queue_ops {
+	const char*	name;
+	void		(*init)(struct search* s);
+	void		(*insert)(struct search* s, uint32_t v);
+	/* key[v] has already been lowered */
+	void		(*decrease)(struct search* s, uint32_t v);
+	/* UINT32_MAX if empty */
+	uint32_t	(*take)(struct search* s);
+	/* keys must not drop below the last one taken, which rules out Prim */
+	int		monotone;
+};
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+}
+
+static void out_of_memory(void)
+{
+	fprintf(stderr, "out of memory\n");
+	exit(1);
+}
+
+static void* xmalloc(size_t size)
+{
+	void* p = malloc(size ? size : 1);
+	if (!p)
+		out_of_memory();
+	return p;
+}
+
+/* xorshift; seed must not be zero */
+static unsigned int rnd(unsigned int* seed)
+{
+	unsigned int x = *seed;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return *seed = x;
+}
+
+/* iheap.h */
+
+static void iheap_q_init(struct search* s)
+{
+	iheap_init(&s->iheap);
+}
+
+static void iheap_q_insert(struct search* s, uint32_t v)
+{
+	iheap_node_init(s->inodes + v, s->key[v], NULL);
+	iheap_insert(&s->iheap, s->inodes + v);
+}
+
+static void iheap_q_decrease(struct search* s, uint32_t v)
+{
+	iheap_decrease(&s->iheap, s->inodes + v, s->key[v]);
+}
+
+static uint32_t iheap_q_take(struct search* s)
+{
+	struct iheap_node* node = iheap_take(&s->iheap);
+	return node ? (uint32_t) (node - s->inodes) : UINT32_MAX;
+}
+
+/* heap.h; each node's value points to its vertex's key */
+
+static int key_cmp(struct heap_node* a, struct heap_node* b)
+{
+	return *((int*) heap_node_value(a)) < *((int*) heap_node_value(b));
+}
+
+static void heap_q_init(struct search* s)
+{
+	heap_init(&s->heap);
+}
+
+static void heap_q_insert(struct search* s, uint32_t v)
+{
+	heap_node_init(s->hnodes + v, s->key + v);
+	heap_insert(key_cmp, &s->heap, s->hnodes + v);
+}
+
+static void heap_q_decrease(struct search* s, uint32_t v)
+{
+	heap_decrease(key_cmp, &s->heap, s->hnodes + v);
+}
+
+static uint32_t heap_q_take(struct search* s)
+{
+	struct heap_node* node = heap_take(key_cmp, &s->heap);
+	return node ? (uint32_t) ((int*) heap_node_value(node) - s->key)
+		: UINT32_MAX;
+}
+
+/* riheap.h; shares the nodes with iheap.h */
+
+static void riheap_q_init(struct search* s)
+{
+	riheap_init(&s->riheap);
+}
+
+static void riheap_q_insert(struct search* s, uint32_t v)
+{
+	iheap_node_init(s->inodes + v, s->key[v], NULL);
+	riheap_insert(&s->riheap, s->inodes + v);
+}
+
+static void riheap_q_decrease(struct search* s, uint32_t v)
+{
+	riheap_decrease(&s->riheap, s->inodes + v, s->key[v]);
+}
+
+static uint32_t riheap_q_take(struct search* s)
+{
+	struct iheap_node* node = riheap_take(&s->riheap);
+	return node ? (uint32_t) (node - s->inodes) : UINT32_MAX;
+}
+
+/* fiheap.h */
+
+static void fiheap_q_init(struct search* s)
+{
+	fiheap_init(&s->fiheap);
+}
+
+static void fiheap_q_insert(struct search* s, uint32_t v)
+{
+	fiheap_node_init(s->fnodes + v, s->key[v], NULL);
+	fiheap_insert(&s->fiheap, s->fnodes + v);
+}
+
+static void fiheap_q_decrease(struct search* s, uint32_t v)
+{
+	fiheap_decrease(&s->fiheap, s->fnodes + v, s->key[v]);
+}
+
+static uint32_t fiheap_q_take(struct search* s)
+{
+	struct fiheap_node* node = fiheap_take(&s->fiheap);
+	return node ? (uint32_t) (node - s->fnodes) : UINT32_MAX;
+}
+
+/* rheap.h */
+
+static void rheap_q_init(struct search* s)
+{
+	rheap_init(&s->rheap);
+}
+
+static void rheap_q_insert(struct search* s, uint32_t v)
+{
+	rheap_node_init(s->rnodes + v, s->key[v], NULL);
+	rheap_insert(&s->rheap, s->rnodes + v);
+}
+
+static void rheap_q_decrease(struct search* s, uint32_t v)
+{
+	rheap_decrease(&s->rheap, s->rnodes + v, s->key[v]);
+}
+
+static uint32_t rheap_q_take(struct search* s)
+{
+	struct rheap_node* node = rheap_take(&s->rheap);
+	return node ? (uint32_t) (node - s->rnodes) : UINT32_MAX;
+}
+
+/* indexed binary heap */
+
+static void binary_q_init(struct search* s)
+{
+	s->bsize = 0;
+}
+
+static void binary_up(struct search* s, uint32_t i)
+{
+	uint32_t v = s->bheap[i], parent;
+	while (i) {
+		parent = (i - 1) / 2;
+		if (s->key[s->bheap[parent]] <= s->key[v])
+			break;
+		s->bheap[i] = s->bheap[parent];
+		s->bpos[s->bheap[i]] = i;
+		i = parent;
+	}
+	s->bheap[i] = v;
+	s->bpos[v]  = i;
+}
+
+static void binary_down(struct search* s, uint32_t i)
+{
+	uint32_t v = s->bheap[i], child;
+	while ((child = 2 * i + 1) < s->bsize) {
+		if (child + 1 < s->bsize &&
+		    s->key[s->bheap[child + 1]] < s->key[s->bheap[child]])
+			child++;
+		if (s->key[v] <= s->key[s->bheap[child]])
+			break;
+		s->bheap[i] = s->bheap[child];
+		s->bpos[s->bheap[i]] = i;
+		i = child;
+	}
+	s->bheap[i] = v;
+	s->bpos[v]  = i;
+}
+
+static void binary_q_insert(struct search* s, uint32_t v)
+{
+	s->bheap[s->bsize] = v;
+	binary_up(s, s->bsize++);
+}
+
+static void binary_q_decrease(struct search* s, uint32_t v)
+{
+	binary_up(s, s->bpos[v]);
+}
+
+static uint32_t binary_q_take(struct search* s)
+{
+	uint32_t v;
+	if (!s->bsize)
+		return UINT32_MAX;
+	v = s->bheap[0];
+	if (--s->bsize) {
+		s->bheap[0] = s->bheap[s->bsize];
+		binary_down(s, 0);
+	}
+	return v;
+}
+
+static const struct queue_ops queues[] = {
+	{"iheap", iheap_q_init, iheap_q_insert, iheap_q_decrease, iheap_q_take,
+	 0},
+	{"heap", heap_q_init, heap_q_insert, heap_q_decrease, heap_q_take, 0},
+	{"riheap", riheap_q_init, riheap_q_insert, riheap_q_decrease,
+	 riheap_q_take, 0},
+	{"fiheap", fiheap_q_init, fiheap_q_insert, fiheap_q_decrease,
+	 fiheap_q_take, 0},
+	{"rheap", rheap_q_init, rheap_q_insert, rheap_q_decrease,
+	 rheap_q_take, 1},
+	{"binary", binary_q_init, binary_q_insert, binary_q_decrease,
+	 binary_q_take, 0},
+};
+
+#define LENGTH(a) (sizeof(a) / sizeof(a[0]))
+
+static void search_init(struct search* s, uint32_t n)
+{
+	memset(s, 0, sizeof(*s));
+	s->n      = n;
+	s->key    = xmalloc(sizeof(int) * n);
+	s->state  = xmalloc(n);
+	s->inodes = xmalloc(sizeof(struct iheap_node) * n);
+	s->hnodes = xmalloc(sizeof(struct heap_node) * n);
+	s->fnodes = xmalloc(sizeof(struct fiheap_node) * n);
+	s->rnodes = xmalloc(sizeof(struct rheap_node) * n);
+	s->bheap  = xmalloc(sizeof(uint32_t) * n);
+	s->bpos   = xmalloc(sizeof(uint32_t) * n);
+}
+
+static void search_destroy(struct search* s)
+{
+	free(s->key);
+	free(s->state);
+	free(s->inodes);
+	free(s->hnodes);
+	free(s->fnodes);
+	free(s->rnodes);
+	free(s->bheap);
+	free(s->bpos);
+}
+
+/* Dijkstra if !prim. Returns the sum of the distances or the tree weight,
+ * over the vertices that src reaches. The queue operations are constant in
+ * each caller, so they are inlined after all.
+ */
+static inline __attribute__((always_inline))
+long search(const struct graph* g, struct search* s,
+	    const struct queue_ops* q, uint32_t src, int prim)
+{
+	uint32_t u, v, a;
+	long sum = 0, key;
+
+	memset(s->state, UNSEEN, g->n);
+	q->init(s);
+	s->key[src]   = 0;
+	s->state[src] = QUEUED;
+	q->insert(s, src);
+	s->inserts++;
+	while ((u = q->take(s)) != UINT32_MAX) {
+		s->takes++;
+		s->state[u] = DONE;
+		sum += s->key[u];
+		for (a = g->off[u]; a < g->off[u + 1]; a++) {
+			v = g->dst[a];
+			s->relaxations++;
+			if (s->state[v] == DONE)
+				continue;
+			key = g->weight[a];
+			if (!prim)
+				key += s->key[u];
+			if (key > INT_MAX) {
+				fprintf(stderr, "%s: distances overflow\n",
+					g->name);
+				exit(1);
+			}
+			if (s->state[v] == UNSEEN) {
+				s->key[v]   = (int) key;
+				s->state[v] = QUEUED;
+				q->insert(s, v);
+				s->inserts++;
+			} else if (key < s->key[v]) {
+				s->key[v] = (int) key;
+				q->decrease(s, v);
+				s->decreases++;
+			}
+		}
+	}
+	return sum;
+}
+
+static long search_iheap(const struct graph* g, struct search* s,
+			 uint32_t src, int prim)
+{
+	return search(g, s, queues + 0, src, prim);
+}
+
+static long search_heap(const struct graph* g, struct search* s,
+			uint32_t src, int prim)
+{
+	return search(g, s, queues + 1, src, prim);
+}
+
+static long search_riheap(const struct graph* g, struct search* s,
+			  uint32_t src, int prim)
+{
+	return search(g, s, queues + 2, src, prim);
+}
+
+static long search_fiheap(const struct graph* g, struct search* s,
+			  uint32_t src, int prim)
+{
+	return search(g, s, queues + 3, src, prim);
+}
+
+static long search_rheap(const struct graph* g, struct search* s,
+			 uint32_t src, int prim)
+{
+	return search(g, s, queues + 4, src, prim);
+}
+
+static long search_binary(const struct graph* g, struct search* s,
+			  uint32_t src, int prim)
+{
+	return search(g, s, queues + 5, src, prim);
+}
+
+static long (* const searches[])(const struct graph*, struct search*,
+				 uint32_t, int) = {
+	search_iheap, search_heap, search_riheap, search_fiheap,
+	search_rheap, search_binary
+};
+
+/* graph construction */
+
+static void add_edge(struct edges* es, uint32_t u, uint32_t v, int w)
+{
+	if (es->n == es->capacity) {
+		es->capacity = es->capacity ? es->capacity * 2 : 1024;
+		es->e = realloc(es->e, sizeof(struct edge) * es->capacity);
+		if (!es->e)
+			out_of_memory();
+	}
+	es->e[es->n].u = u;
+	es->e[es->n].v = v;
+	es->e[es->n].w = w;
+	es->n++;
+}
+
+/* CSR form of es; every edge becomes two arcs unless directed */
+static void make_graph(struct graph* g, const char* name, uint32_t n,
+		       struct edges* es, int directed)
+{
+	size_t i, m = directed ? es->n : 2 * es->n;
+	uint32_t* fill;
+	uint32_t v;
+
+	g->name   = name;
+	g->n      = n;
+	g->off    = calloc((size_t) n + 1, sizeof(uint32_t));
+	g->dst    = xmalloc(sizeof(uint32_t) * m);
+	g->weight = xmalloc(sizeof(int) * m);
+	fill      = xmalloc(sizeof(uint32_t) * n);
+	if (!g->off || m > UINT32_MAX)
+		out_of_memory();
+	for (i = 0; i < es->n; i++) {
+		g->off[es->e[i].u + 1]++;
+		if (!directed)
+			g->off[es->e[i].v + 1]++;
+	}
+	for (v = 0; v < n; v++) {
+		g->off[v + 1] += g->off[v];
+		fill[v] = g->off[v];
+	}
+	for (i = 0; i < es->n; i++) {
+		g->dst[fill[es->e[i].u]]      = es->e[i].v;
+		g->weight[fill[es->e[i].u]++] = es->e[i].w;
+		if (directed)
+			continue;
+		g->dst[fill[es->e[i].v]]      = es->e[i].u;
+		g->weight[fill[es->e[i].v]++] = es->e[i].w;
+	}
+	free(fill);
+	free(es->e);
+	es->e = NULL;
+	es->n = es->capacity = 0;
+}
+
+static void destroy_graph(struct graph* g)
+{
+	free(g->off);
+	free(g->dst);
+	free(g->weight);
+}
+
+static int weight(unsigned int* seed, int max)
+{
+	return 1 + (int) (rnd(seed) % (unsigned int) max);
+}
+
+static void make_grid(struct graph* g, uint32_t n, int max,
+		      unsigned int* seed)
+{
+	struct edges es = {NULL, 0, 0};
+	uint32_t side = 1, r, c;
+
+	while ((side + 1) * (side + 1) <= n)
+		side++;
+	for (r = 0; r < side; r++)
+		for (c = 0; c < side; c++) {
+			if (c + 1 < side)
+				add_edge(&es, r * side + c, r * side + c + 1,
+					 weight(seed, max));
+			if (r + 1 < side)
+				add_edge(&es, r * side + c, (r + 1) * side + c,
+					 weight(seed, max));
+		}
+	make_graph(g, "grid", side * side, &es, 0);
+}
+
+static void make_random(struct graph* g, uint32_t n, unsigned int degree,
+			int max, unsigned int* seed)
+{
+	struct edges es = {NULL, 0, 0};
+	size_t i, m = (size_t) n * degree / 2;
+
+	for (i = 0; i < m; i++)
+		add_edge(&es, rnd(seed) % n, rnd(seed) % n, weight(seed, max));
+	make_graph(g, "random", n, &es, 0);
+}
+
+/* Barabasi-Albert: each new vertex attaches to degree / 2 vertices, picked
+ * with probability proportional to their degrees, i.e., uniformly among
+ * the endpoints of the edges so far.
+ */
+static void make_powerlaw(struct graph* g, uint32_t n, unsigned int degree,
+			  int max, unsigned int* seed)
+{
+	struct edges es = {NULL, 0, 0};
+	uint32_t k = degree / 2 ? degree / 2 : 1, u, v, i;
+	size_t e;
+
+	for (u = 1; u <= k && u < n; u++)
+		for (v = 0; v < u; v++)
+			add_edge(&es, u, v, weight(seed, max));
+	for (; u < n; u++)
+		for (i = 0; i < k; i++) {
+			e = rnd(seed) % es.n;
+			v = rnd(seed) & 1 ? es.e[e].u : es.e[e].v;
+			add_edge(&es, u, v, weight(seed, max));
+		}
+	make_graph(g, "powerlaw", n, &es, 0);
+}
+
+/* returns 0 if path cannot be read as a DIMACS shortest-path file */
+static int read_dimacs(struct graph* g, const char* path)
+{
+	struct edges es = {NULL, 0, 0};
+	char line[256];
+	unsigned long n = 0, m, u, v;
+	long w;
+	FILE* f = fopen(path, "r");
+
+	if (!f)
+		return 0;
+	while (fgets(line, sizeof(line), f)) {
+		if (line[0] == 'p') {
+			if (sscanf(line, "p sp %lu %lu", &n, &m) != 2 ||
+			    n > UINT32_MAX)
+				break;
+		} else if (line[0] == 'a') {
+			if (sscanf(line, "a %lu %lu %ld", &u, &v, &w) != 3 ||
+			    !u || !v || u > n || v > n || w < 0 || w > INT_MAX)
+				break;
+			add_edge(&es, (uint32_t) u - 1, (uint32_t) v - 1,
+				 (int) w);
+		} else if (line[0] != 'c' && line[0] != '\n')
+			break;
+	}
+	if (!feof(f) || !n) {
+		fclose(f);
+		free(es.e);
+		return 0;
+	}
+	fclose(f);
+	make_graph(g, path, (uint32_t) n, &es, 1);
+	return 1;
+}
+
+static void run(const struct graph* g, unsigned int sources,
+		unsigned int seed)
+{
+	struct search s;
+	uint32_t* src = xmalloc(sizeof(uint32_t) * sources);
+	unsigned int i, j;
+	unsigned long ops;
+	long sum, ref = 0;
+	uint64_t t0, ns;
+	int prim;
+
+	search_init(&s, g->n);
+	for (i = 0; i < sources; i++)
+		src[i] = rnd(&seed) % g->n;
+	for (prim = 0; prim < 2; prim++)
+		for (j = 0; j < LENGTH(queues); j++) {
+			if (prim && queues[j].monotone)
+				continue;
+			s.relaxations = s.inserts = s.decreases = s.takes = 0;
+			sum = 0;
+			t0  = now_ns();
+			for (i = 0; i < sources; i++)
+				sum += searches[j](g, &s, src[i], prim);
+			ns  = now_ns() - t0;
+			ops = s.inserts + s.decreases + s.takes;
+			if (!j)
+				ref = sum;
+			printf("%-10s %-8s %-7s %10.2f %10.1f %10.1f %s\n",
+			       g->name, prim ? "prim" : "dijkstra",
+			       queues[j].name,
+			       (double) s.relaxations * 1000.0 / (double) ns,
+			       100.0 * (double) s.decreases / (double) ops,
+			       (double) s.takes / sources,
+			       sum == ref ? "ok" : "MISMATCH");
+			fflush(stdout);
+		}
+	search_destroy(&s);
+	free(src);
+}
+
+static void usage(const char* prog)
+{
+	fprintf(stderr,
+		"usage: %s [-n vertices] [-d degree] [-w max weight] "
+		"[-k sources] [-s seed] [-f file.gr]...\n", prog);
+	exit(1);
+}
+
+int main(int argc, char** argv)
+{
+	struct graph g;
+	unsigned long n = 250000;
+	unsigned int degree = 8, sources = 2, seed = 42;
+	int max = 1000, i, files = 0;
+
+	for (i = 1; i < argc; i++) {
+		if (i + 1 == argc)
+			usage(argv[0]);
+		if (!strcmp(argv[i], "-n"))
+			n = (unsigned long) atof(argv[++i]);
+		else if (!strcmp(argv[i], "-d"))
+			degree = (unsigned int) atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-w"))
+			max = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-k"))
+			sources = (unsigned int) atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-s"))
+			seed = (unsigned int) strtoul(argv[++i], NULL, 0);
+		else if (!strcmp(argv[i], "-f")) {
+			i++;
+			files++;
+		} else
+			usage(argv[0]);
+	}
+	if (n < 2 || n > UINT32_MAX / 2 || !degree || max < 1 || !sources ||
+	    !seed)
+		usage(argv[0]);
+
+	printf("%-10s %-8s %-7s %10s %10s %10s %s\n", "graph", "algo",
+	       "queue", "Mrelax/s", "decrease%", "reached", "check");
+	if (files) {
+		for (i = 1; i < argc; i++)
+			if (!strcmp(argv[i], "-f")) {
+				if (!read_dimacs(&g, argv[++i])) {
+					fprintf(stderr, "%s: cannot read\n",
+						argv[i]);
+					return 1;
+				}
+				run(&g, sources, seed);
+				destroy_graph(&g);
+			}
+		return 0;
+	}
+	make_grid(&g, (uint32_t) n, max, &seed);
+	run(&g, sources, seed);
+	destroy_graph(&g);
+	make_random(&g, (uint32_t) n, degree, max, &seed);
+	run(&g, sources, seed);
+	destroy_graph(&g);
+	make_powerlaw(&g, (uint32_t) n, degree, max, &seed);
+	run(&g, sources, seed);
+	destroy_graph(&g);
+	return 0;
+}
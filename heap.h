@@ -31,24 +31,66 @@
 #ifndef HEAP_H
 #define HEAP_H
 
+/* with HEAP_PAIRING, the same interface is backed by pairing heaps */
+#ifdef HEAP_PAIRING
+#include "pheap.h"
+#else
+
+#include <stddef.h>
+
 #define NOT_IN_HEAP UINT_MAX
 
+/* upper bound on the degree of any node; requires <limits.h> */
+#define HEAP_MAX_DEGREE (sizeof(size_t) * CHAR_BIT)
+
+#ifdef HEAP_STATS
+#include "heap_stats.h"
+#define __HEAP_STAT(heap, field, n)	((heap)->stats.field += (n))
+#else
+#define __HEAP_STAT(heap, field, n)	((void) (heap))
+#endif
+
 struct heap_node {
 	struct heap_node* 	parent;
 	struct heap_node* 	next;
 	struct heap_node* 	child;
 
 	unsigned int 		degree;
+#ifndef HEAP_INTRUSIVE
 	void*			value;
 	struct heap_node**	ref;
+#endif
 };
 
+/* With HEAP_INTRUSIVE, a node has neither a value nor a ref. It is embedded
+ * in the object that it orders, and comparators get from the node to the
+ * object with heap_entry(), which is pointer arithmetic instead of a load.
+ * Without values, nothing can be exchanged between nodes, so decrease,
+ * increase and delete always relink; a node stays where it is allocated.
+ */
+#define heap_entry(node, type, member) \
+	((type*) ((char*) (node) - offsetof(type, member)))
+
 struct heap {
 	struct heap_node* 	head;
+	/* The last root, so that the roots of one heap can be spliced into
+	 * another one in O(1).
+	 */
+	struct heap_node*	tail;
 	/* We cache the minimum of the heap.
 	 * This speeds up repeated peek operations.
 	 */
 	struct heap_node*	min;
+	/* In lazy mode, insertions and unions only splice root lists in O(1).
+	 * Consolidation is deferred until the minimum is needed, or until a
+	 * node is removed from within its tree (delete, and decrease or
+	 * increase by relinking): finding that node's root in the root list
+	 * would take O(n) otherwise. Either way, it costs amortized O(log n).
+	 */
+	int			lazy;
+#ifdef HEAP_STATS
+	struct heap_stats	stats;
+#endif
 };
 
 /* item comparison function:
@@ -59,9 +101,33 @@ typedef int (*heap_prio_t)(struct heap_node* a, struct heap_node* b);
 static inline void heap_init(struct heap* heap)
 {
 	heap->head = NULL;
+	heap->tail = NULL;
 	heap->min  = NULL;
+#ifdef HEAP_LAZY
+	heap->lazy = 1;
+#else
+	heap->lazy = 0;
+#endif
+#ifdef HEAP_STATS
+	heap_stats_reset(&heap->stats);
+#endif
+}
+
+static inline void heap_init_lazy(struct heap* heap)
+{
+	heap_init(heap);
+	heap->lazy = 1;
 }
 
+#ifdef HEAP_INTRUSIVE
+static inline void heap_node_init(struct heap_node* h)
+{
+	h->parent = NULL;
+	h->next   = NULL;
+	h->child  = NULL;
+	h->degree = NOT_IN_HEAP;
+}
+#else
 static inline void heap_node_init_ref(struct heap_node** _h, void* value)
 {
 	struct heap_node* h = *_h;
@@ -87,6 +153,7 @@ static inline void* heap_node_value(struct heap_node* h)
 {
 	return h->value;
 }
+#endif
 
 static inline int heap_node_in_heap(struct heap_node* h)
 {
@@ -98,6 +165,14 @@ static inline int heap_empty(struct heap* heap)
 	return heap->head == NULL && heap->min == NULL;
 }
 
+/* all priority comparisons go through here so that they can be counted */
+static inline int __heap_higher(heap_prio_t higher_prio, struct heap* heap,
+				struct heap_node* a, struct heap_node* b)
+{
+	__HEAP_STAT(heap, compares, 1);
+	return higher_prio(a, b);
+}
+
 /* make child a subtree of root */
 static inline void __heap_link(struct heap_node* root,
 			       struct heap_node* child)
@@ -153,6 +228,28 @@ static inline struct heap_node* __heap_reverse(struct heap_node* h)
 	return h;
 }
 
+/* replace the root list; the tail is searched, so only for short lists */
+static inline void __heap_set_roots(struct heap* heap, struct heap_node* head)
+{
+	heap->head = head;
+	heap->tail = head;
+	if (head)
+		while (heap->tail->next)
+			heap->tail = heap->tail->next;
+}
+
+/* unlink a root, given the root before it (or NULL) */
+static inline void __heap_remove_root(struct heap* heap, struct heap_node* prev,
+				      struct heap_node* node)
+{
+	if (prev)
+		prev->next = node->next;
+	else
+		heap->head = node->next;
+	if (heap->tail == node)
+		heap->tail = prev;
+}
+
 static inline void __heap_min(heap_prio_t higher_prio, struct heap* heap,
 			      struct heap_node** prev, struct heap_node** node)
 {
@@ -164,11 +261,14 @@ static inline void __heap_min(heap_prio_t higher_prio, struct heap* heap,
 		return;
 	}
 
+	__HEAP_STAT(heap, min_scans, 1);
+	__HEAP_STAT(heap, roots_scanned, 1);
 	*node = heap->head;
 	_prev = heap->head;
 	cur   = heap->head->next;
 	while (cur) {
-		if (higher_prio(cur, *node)) {
+		__HEAP_STAT(heap, roots_scanned, 1);
+		if (__heap_higher(higher_prio, heap, cur, *node)) {
 			*node = cur;
 			*prev = _prev;
 		}
@@ -186,7 +286,7 @@ static inline void __heap_union(heap_prio_t higher_prio, struct heap* heap,
 		return;
 	h1 = heap->head;
 	if (!h1) {
-		heap->head = h2;
+		__heap_set_roots(heap, h2);
 		return;
 	}
 	h1 = __heap_merge(h1, h2);
@@ -199,10 +299,11 @@ static inline void __heap_union(heap_prio_t higher_prio, struct heap* heap,
 			/* nothing to do, advance */
 			prev = x;
 			x    = next;
-		} else if (higher_prio(x, next)) {
+		} else if (__heap_higher(higher_prio, heap, x, next)) {
 			/* x becomes the root of next */
 			x->next = next->next;
 			__heap_link(x, next);
+			__HEAP_STAT(heap, links, 1);
 		} else {
 			/* next becomes the root of x */
 			if (prev)
@@ -210,24 +311,125 @@ static inline void __heap_union(heap_prio_t higher_prio, struct heap* heap,
 			else
 				h1 = next;
 			__heap_link(next, x);
+			__HEAP_STAT(heap, links, 1);
 			x = next;
 		}
 		next = x->next;
 	}
 	heap->head = h1;
+	heap->tail = x;
+}
+
+/* Linking trees into a degree-indexed array works like incrementing a binary
+ * counter: trees[d] holds the tree of degree d, if any, and a new tree carries
+ * through the occupied slots.
+ */
+static inline void __heap_carry(heap_prio_t higher_prio, struct heap* heap,
+				struct heap_node** trees,
+				struct heap_node* node, int sorted)
+{
+	struct heap_node* other;
+	unsigned int d = node->degree;
+	while ((other = trees[d])) {
+		trees[d] = NULL;
+		/* If the input is sorted, the earlier tree always wins. */
+		if (!sorted && __heap_higher(higher_prio, heap, node, other))
+			__heap_link(node, other);
+		else {
+			__heap_link(other, node);
+			node = other;
+		}
+		__HEAP_STAT(heap, links, 1);
+		d++;
+	}
+	trees[d] = node;
+}
+
+/* turn the first limit slots of an array of trees into a root list,
+ * ordered by degree
+ */
+static inline struct heap_node* __heap_collect(struct heap_node** trees,
+					       unsigned int limit)
+{
+	struct heap_node* head = NULL;
+	unsigned int d = limit;
+	while (d--)
+		if (trees[d]) {
+			trees[d]->next = head;
+			head = trees[d];
+		}
+	return head;
+}
+
+/* link roots of equal degree until all degrees are unique (lazy mode) */
+static inline void __heap_consolidate(heap_prio_t higher_prio,
+				      struct heap* heap)
+{
+	struct heap_node* trees[HEAP_MAX_DEGREE];
+	struct heap_node *pos, *next;
+	unsigned int d, limit, max = 0;
+	unsigned long roots = 0;
+	int ordered = 1;
+	for (pos = heap->head; pos; pos = pos->next) {
+		if (pos->next && pos->degree >= pos->next->degree)
+			ordered = 0;
+		if (pos->degree > max)
+			max = pos->degree;
+		roots++;
+	}
+	/* nothing to do if the degrees are already unique and ordered */
+	if (ordered)
+		return;
+	/* no resulting tree can have a degree beyond max + log2(roots) */
+	limit = max + 1;
+	while (roots >>= 1)
+		limit++;
+	if (limit > HEAP_MAX_DEGREE)
+		limit = HEAP_MAX_DEGREE;
+	for (d = 0; d < limit; d++)
+		trees[d] = NULL;
+	for (pos = heap->head; pos; pos = next) {
+		next = pos->next;
+		__heap_carry(higher_prio, heap, trees, pos, 0);
+	}
+	__heap_set_roots(heap, __heap_collect(trees, limit));
+}
+
+/* prepend the roots from h2 to t2 without linking (lazy mode) */
+static inline void __heap_splice(struct heap* heap, struct heap_node* h2,
+				 struct heap_node* t2)
+{
+	if (!h2)
+		return;
+	t2->next = heap->head;
+	if (!heap->head)
+		heap->tail = t2;
+	heap->head = h2;
+}
+
+/* h2 is a single tree or the pieces of one, i.e., O(log n) roots */
+static inline void __heap_add_roots(heap_prio_t higher_prio, struct heap* heap,
+				    struct heap_node* h2)
+{
+	struct heap_node* t2;
+	if (heap->lazy) {
+		for (t2 = h2; t2 && t2->next; t2 = t2->next)
+			;
+		__heap_splice(heap, h2, t2);
+	} else
+		__heap_union(higher_prio, heap, h2);
 }
 
 static inline struct heap_node* __heap_extract_min(heap_prio_t higher_prio,
 						   struct heap* heap)
 {
 	struct heap_node *prev, *node;
+	if (heap->lazy)
+		__heap_consolidate(higher_prio, heap);
 	__heap_min(higher_prio, heap, &prev, &node);
 	if (!node)
 		return NULL;
-	if (prev)
-		prev->next = node->next;
-	else
-		heap->head = node->next;
+	__heap_remove_root(heap, prev, node);
 	__heap_union(higher_prio, heap, __heap_reverse(node->child));
 	return node;
 }
@@ -241,17 +443,17 @@ static inline void heap_insert(heap_prio_t higher_prio, struct heap* heap,
 	node->parent = NULL;
 	node->next   = NULL;
 	node->degree = 0;
-	if (heap->min && higher_prio(node, heap->min)) {
+	if (heap->min && __heap_higher(higher_prio, heap, node, heap->min)) {
 		/* swap min cache */
 		min = heap->min;
 		min->child  = NULL;
 		min->parent = NULL;
 		min->next   = NULL;
 		min->degree = 0;
-		__heap_union(higher_prio, heap, min);
+		__heap_add_roots(higher_prio, heap, min);
 		heap->min   = node;
 	} else
-		__heap_union(higher_prio, heap, node);
+		__heap_add_roots(higher_prio, heap, node);
 }
 
 static inline void __uncache_min(heap_prio_t higher_prio, struct heap* heap)
@@ -271,16 +473,69 @@ static inline void heap_union(heap_prio_t higher_prio,
 	/* first insert any cached minima, if necessary */
 	__uncache_min(higher_prio, target);
 	__uncache_min(higher_prio, addition);
-	__heap_union(higher_prio, target, addition->head);
+	/* an eager heap expects its roots to have unique degrees */
+	if (target->lazy)
+		__heap_splice(target, addition->head, addition->tail);
+	else {
+		if (addition->lazy)
+			__heap_consolidate(higher_prio, addition);
+		__heap_union(higher_prio, target, addition->head);
+	}
 	/* this is a destructive merge */
 	addition->head = NULL;
+	addition->tail = NULL;
+}
+
+static inline void __heap_build_add(heap_prio_t higher_prio,
+				    struct heap* heap,
+				    struct heap_node** trees,
+				    struct heap_node* node, int sorted)
+{
+	node->child  = NULL;
+	node->parent = NULL;
+	node->next   = NULL;
+	node->degree = 0;
+	__heap_carry(higher_prio, heap, trees, node, sorted);
+}
+
+static inline void __heap_build(heap_prio_t higher_prio, struct heap* heap,
+				struct heap_node** nodes, size_t n, int sorted)
+{
+	struct heap_node* trees[HEAP_MAX_DEGREE];
+	size_t i;
+	for (i = 0; i < HEAP_MAX_DEGREE; i++)
+		trees[i] = NULL;
+	for (i = 0; i < n; i++)
+		__heap_build_add(higher_prio, heap, trees, nodes[i], sorted);
+	/* the cached minimum might not be the minimum anymore */
+	__uncache_min(higher_prio, heap);
+	__heap_add_roots(higher_prio, heap, __heap_collect(trees, HEAP_MAX_DEGREE));
+}
+
+/* insert (and reinitialize) n nodes at once in O(n) time */
+static inline void heap_build(heap_prio_t higher_prio, struct heap* heap,
+			      struct heap_node** nodes, size_t n)
+{
+	__heap_build(higher_prio, heap, nodes, n, 0);
+}
+
+/* like heap_build(), but nodes must be sorted highest priority first;
+ * no comparisons are required in this case
+ */
+static inline void heap_build_sorted(heap_prio_t higher_prio, struct heap* heap,
+				     struct heap_node** nodes, size_t n)
+{
+	__heap_build(higher_prio, heap, nodes, n, 1);
 }
 
 static inline struct heap_node* heap_peek(heap_prio_t higher_prio,
 					  struct heap* heap)
 {
-	if (!heap->min)
+	if (!heap->min) {
+		__HEAP_STAT(heap, min_misses, 1);
 		heap->min = __heap_extract_min(higher_prio, heap);
+	} else
+		__HEAP_STAT(heap, min_hits, 1);
 	return heap->min;
 }
 
@@ -288,8 +543,11 @@ static inline struct heap_node* heap_take(heap_prio_t higher_prio,
 					  struct heap* heap)
 {
 	struct heap_node *node;
-	if (!heap->min)
+	if (!heap->min) {
+		__HEAP_STAT(heap, min_misses, 1);
 		heap->min = __heap_extract_min(higher_prio, heap);
+	} else
+		__HEAP_STAT(heap, min_hits, 1);
 	node = heap->min;
 	heap->min = NULL;
 	if (node)
@@ -297,6 +555,232 @@ static inline struct heap_node* heap_take(heap_prio_t higher_prio,
 	return node;
 }
 
+/* Batches taken by heap_take_many() keep their candidates on the stack. */
+#define HEAP_TAKE_MANY_BATCH 256
+/* Smaller batches do not pay for building the candidate heap. */
+#define HEAP_TAKE_MANY_MIN 8
+
+/* The frontier compares through here. Iterators pass no heap: looking at a
+ * heap must not change its statistics.
+ */
+static inline int __heap_frontier_higher(heap_prio_t higher_prio,
+					 struct heap* heap,
+					 struct heap_node* a,
+					 struct heap_node* b)
+{
+	if (heap)
+		__HEAP_STAT(heap, compares, 1);
+	return higher_prio(a, b);
+}
+
+/* binary heap of candidate roots, highest priority first */
+static inline void __heap_frontier_push(heap_prio_t higher_prio,
+					struct heap* heap,
+					struct heap_node** front,
+					size_t* n, struct heap_node* node)
+{
+	size_t i = (*n)++, up;
+	while (i) {
+		up = (i - 1) / 2;
+		if (!__heap_frontier_higher(higher_prio, heap, node, front[up]))
+			break;
+		front[i] = front[up];
+		i = up;
+	}
+	front[i] = node;
+}
+
+static inline struct heap_node* __heap_frontier_pop(heap_prio_t higher_prio,
+						    struct heap* heap,
+						    struct heap_node** front,
+						    size_t* n)
+{
+	struct heap_node *top = front[0], *last = front[--*n];
+	size_t i = 0, c;
+	while ((c = 2 * i + 1) < *n) {
+		if (c + 1 < *n &&
+		    __heap_frontier_higher(higher_prio, heap,
+					   front[c + 1], front[c]))
+			c++;
+		if (!__heap_frontier_higher(higher_prio, heap, front[c], last))
+			break;
+		front[i] = front[c];
+		i = c;
+	}
+	front[i] = last;
+	return top;
+}
+
+/* Take up to k nodes in priority order and store them in nodes. Returns the
+ * number of nodes taken, which is less than k only if the heap ran empty.
+ *
+ * Instead of a root scan and a union per node, the roots are kept in a small
+ * binary heap: a taken root is replaced by its children, and the remaining
+ * trees are linked only once per batch of up to HEAP_TAKE_MANY_BATCH
+ * candidates.
+ */
+static inline size_t heap_take_many(heap_prio_t higher_prio, struct heap* heap,
+				    struct heap_node** nodes, size_t k)
+{
+	struct heap_node* frontier[HEAP_TAKE_MANY_BATCH];
+	struct heap_node* trees[HEAP_MAX_DEGREE];
+	struct heap_node *pos, *next, *node;
+	size_t n, i;
+	size_t taken = 0;
+
+	if (k < HEAP_TAKE_MANY_MIN) {
+		while (taken < k &&
+		       (nodes[taken] = heap_take(higher_prio, heap)))
+			taken++;
+		return taken;
+	}
+	if (heap->min) {
+		__HEAP_STAT(heap, min_hits, 1);
+		nodes[taken++] = heap->min;
+		heap->min->degree = NOT_IN_HEAP;
+		heap->min = NULL;
+	}
+	while (taken < k && heap->head) {
+		__HEAP_STAT(heap, min_misses, 1);
+		if (heap->lazy)
+			__heap_consolidate(higher_prio, heap);
+		n = 0;
+		for (pos = heap->head; pos; pos = pos->next)
+			__heap_frontier_push(higher_prio, heap,
+					     frontier, &n, pos);
+		/* stop early if the children of the next node do not fit */
+		while (taken < k && n &&
+		       n - 1 + frontier[0]->degree <= HEAP_TAKE_MANY_BATCH) {
+			node = __heap_frontier_pop(higher_prio, heap,
+						   frontier, &n);
+			for (pos = node->child; pos; pos = next) {
+				next = pos->next;
+				pos->parent = NULL;
+				__heap_frontier_push(higher_prio, heap,
+						     frontier, &n, pos);
+			}
+			node->degree = NOT_IN_HEAP;
+			nodes[taken++] = node;
+		}
+		/* every candidate is the root of an intact tree */
+		for (i = 0; i < HEAP_MAX_DEGREE; i++)
+			trees[i] = NULL;
+		for (i = 0; i < n; i++)
+			__heap_carry(higher_prio, heap, trees, frontier[i], 0);
+		__heap_set_roots(heap, __heap_collect(trees, HEAP_MAX_DEGREE));
+	}
+	return taken;
+}
+
+/* Remove node from the heap without moving any other node. Each ancestor of
+ * node keeps only its children of lower degree than the next node on the path
+ * down to node; its other children become roots. The pieces are binomial
+ * trees of distinct degrees, returned as a root list ordered by degree.
+ *
+ * The root list is scanned for node's root, so a lazy heap must be
+ * consolidated first; see __heap_cut_out().
+ */
+static inline struct heap_node* __heap_cut(struct heap* heap,
+					   struct heap_node* node)
+{
+	struct heap_node* path[HEAP_MAX_DEGREE];
+	struct heap_node *head = NULL, *root, *down, *pos, *next, *prev;
+	unsigned int depth = 0;
+
+	for (root = node; root->parent; root = root->parent)
+		path[depth++] = root;
+	__HEAP_STAT(heap, bubble_depth, depth);
+	prev = NULL;
+	for (pos = heap->head; pos != root; pos = pos->next)
+		prev = pos;
+	__heap_remove_root(heap, prev, root);
+	while (depth--) {
+		down = path[depth];
+		/* children are ordered by decreasing degree */
+		for (pos = root->child; pos != down; pos = next) {
+			next        = pos->next;
+			pos->parent = NULL;
+			pos->next   = head;
+			head        = pos;
+		}
+		root->child  = down->next;
+		root->degree = down->degree;
+		root->next   = head;
+		head         = root;
+		down->parent = NULL;
+		root         = down;
+	}
+	for (pos = node->child; pos; pos = next) {
+		next        = pos->next;
+		pos->parent = NULL;
+		pos->next   = head;
+		head        = pos;
+	}
+	return head;
+}
+
+/* remove node and put the remaining pieces of its tree back */
+static inline void __heap_cut_out(heap_prio_t higher_prio, struct heap* heap,
+				  struct heap_node* node)
+{
+	if (heap->lazy)
+		__heap_consolidate(higher_prio, heap);
+	__heap_add_roots(higher_prio, heap, __heap_cut(heap, node));
+}
+
+/* Like heap_decrease(), but instead of exchanging values with its ancestors,
+ * node is cut out of its tree and inserted again; its subtrees and the rest
+ * of the tree are added to the root list. Hence, node does not need a ref and
+ * the caller's pointer to it remains valid. The cut writes O(log n) pointers
+ * in total, and only if node actually has to move.
+ *
+ * Values only stay put if every decrease, increase and delete on the heap
+ * relinks; heap_decrease(), heap_increase() and heap_delete() do so for
+ * nodes without a ref.
+ */
+static inline void heap_decrease_relink(heap_prio_t higher_prio,
+					struct heap* heap,
+					struct heap_node* node)
+{
+	if (heap->min == node)
+		return;
+	if (node->parent &&
+	    __heap_higher(higher_prio, heap, node, node->parent)) {
+		__heap_cut_out(higher_prio, heap, node);
+		/* swaps the min cache if necessary */
+		heap_insert(higher_prio, heap, node);
+	} else if (heap->min &&
+		   __heap_higher(higher_prio, heap, node, heap->min))
+		__uncache_min(higher_prio, heap);
+}
+
+/* Like heap_delete(), but node's tree is taken apart instead of bubbling node
+ * up to the root.
+ */
+static inline void heap_delete_relink(heap_prio_t higher_prio,
+				      struct heap* heap,
+				      struct heap_node* node)
+{
+	if (heap->min != node)
+		__heap_cut_out(higher_prio, heap, node);
+	else
+		heap->min = NULL;
+	node->degree = NOT_IN_HEAP;
+}
+
+#ifdef HEAP_INTRUSIVE
+static inline void heap_decrease(heap_prio_t higher_prio, struct heap* heap,
+				 struct heap_node* node)
+{
+	heap_decrease_relink(higher_prio, heap, node);
+}
+
+static inline void heap_delete(heap_prio_t higher_prio, struct heap* heap,
+			       struct heap_node* node)
+{
+	heap_delete_relink(higher_prio, heap, node);
+}
+#else
 static inline void heap_decrease(heap_prio_t higher_prio, struct heap* heap,
 				 struct heap_node* node)
 {
@@ -305,14 +789,18 @@ static inline void heap_decrease(heap_prio_t higher_prio, struct heap* heap,
 	void* tmp;
 
 	/* node's priority was decreased, we need to update its position */
-	if (!node->ref)
+	if (!node->ref) {
+		heap_decrease_relink(higher_prio, heap, node);
 		return;
+	}
 	if (heap->min != node) {
-		if (heap->min && higher_prio(node, heap->min))
+		if (heap->min &&
+		    __heap_higher(higher_prio, heap, node, heap->min))
 			__uncache_min(higher_prio, heap);
 		/* bubble up */
 		parent = node->parent;
-		while (parent && higher_prio(node, parent)) {
+		while (parent &&
+		       __heap_higher(higher_prio, heap, node, parent)) {
 			/* swap parent and node */
 			tmp           = parent->value;
 			parent->value = node->value;
@@ -327,6 +815,7 @@ static inline void heap_decrease(heap_prio_t higher_prio, struct heap* heap,
 			/* step up */
 			node   = parent;
 			parent = node->parent;
+			__HEAP_STAT(heap, bubble_depth, 1);
 		}
 	}
 }
@@ -338,9 +827,15 @@ static inline void heap_delete(heap_prio_t higher_prio, struct heap* heap,
 	struct heap_node** tmp_ref;
 	void* tmp;
 
-	if (!node->ref) /* can only delete if we have a reference */
+	/* without a reference, node itself has to move */
+	if (!node->ref) {
+		heap_delete_relink(higher_prio, heap, node);
 		return;
+	}
 	if (heap->min != node) {
+		/* finding node's root below needs a short root list */
+		if (heap->lazy)
+			__heap_consolidate(higher_prio, heap);
 		/* bubble up */
 		parent = node->parent;
 		while (parent) {
@@ -358,6 +853,7 @@ static inline void heap_delete(heap_prio_t higher_prio, struct heap* heap,
 			/* step up */
 			node   = parent;
 			parent = node->parent;
+			__HEAP_STAT(heap, bubble_depth, 1);
 		}
 		/* now delete:
 		 * first find prev */
@@ -368,14 +864,98 @@ static inline void heap_delete(heap_prio_t higher_prio, struct heap* heap,
 			pos  = pos->next;
 		}
 		/* we have prev, now remove node */
-		if (prev)
-			prev->next = node->next;
-		else
-			heap->head = node->next;
-		__heap_union(higher_prio, heap, __heap_reverse(node->child));
+		__heap_remove_root(heap, prev, node);
+		__heap_add_roots(higher_prio, heap, __heap_reverse(node->child));
 	} else
 		heap->min = NULL;
 	node->degree = NOT_IN_HEAP;
 }
+#endif /* HEAP_INTRUSIVE */
+
+/* child of node with the highest priority, or NULL */
+static inline struct heap_node* __heap_max_child(heap_prio_t higher_prio,
+						 struct heap* heap,
+						 struct heap_node* node)
+{
+	struct heap_node *max = node->child, *pos;
+	if (max)
+		for (pos = max->next; pos; pos = pos->next)
+			if (__heap_higher(higher_prio, heap, pos, max))
+				max = pos;
+	return max;
+}
+
+/* Like heap_increase(), but instead of exchanging values with its
+ * descendants, node is cut out of its tree and inserted again, as in
+ * heap_decrease_relink().
+ */
+static inline void heap_increase_relink(heap_prio_t higher_prio,
+					struct heap* heap,
+					struct heap_node* node)
+{
+	struct heap_node* child;
+
+	if (heap->min == node) {
+		/* the cached minimum has no children; just insert it again */
+		__uncache_min(higher_prio, heap);
+		return;
+	}
+	child = __heap_max_child(higher_prio, heap, node);
+	if (child && __heap_higher(higher_prio, heap, child, node)) {
+		__heap_cut_out(higher_prio, heap, node);
+		heap_insert(higher_prio, heap, node);
+	}
+}
+
+/* node's priority was lowered, we need to update its position: node sinks
+ * within its tree, trading places with its highest-priority child as long
+ * as that child has a higher priority. Each level scans the children, so
+ * this costs O(log^2 n) comparisons in the worst case, but most nodes sit
+ * near the bottom of their trees and only move a few levels.
+ */
+#ifdef HEAP_INTRUSIVE
+static inline void heap_increase(heap_prio_t higher_prio, struct heap* heap,
+				 struct heap_node* node)
+{
+	heap_increase_relink(higher_prio, heap, node);
+}
+#else
+static inline void heap_increase(heap_prio_t higher_prio, struct heap* heap,
+				 struct heap_node* node)
+{
+	struct heap_node *child;
+	struct heap_node** tmp_ref;
+	void* tmp;
+
+	if (!node->ref) {
+		heap_increase_relink(higher_prio, heap, node);
+		return;
+	}
+	if (heap->min == node) {
+		__uncache_min(higher_prio, heap);
+		return;
+	}
+	/* sift down */
+	while ((child = __heap_max_child(higher_prio, heap, node)) &&
+	       __heap_higher(higher_prio, heap, child, node)) {
+		/* swap child and node */
+		tmp          = child->value;
+		child->value = node->value;
+		node->value  = tmp;
+		/* swap references */
+		if (child->ref)
+			*(child->ref) = node;
+		*(node->ref)  = child;
+		tmp_ref       = child->ref;
+		child->ref    = node->ref;
+		node->ref     = tmp_ref;
+		/* step down */
+		node = child;
+		__HEAP_STAT(heap, bubble_depth, 1);
+	}
+}
+#endif /* HEAP_INTRUSIVE */
+
+#endif /* HEAP_PAIRING */
 
 #endif /* HEAP_H */
@@ -0,0 +1,178 @@
+/* heap_inbox.h -- Lock-free insertion buffers for heaps
+ *
+ * Copyright (c) 2008, Bjoern B. Brandenburg <bbb [at] cs.unc.edu>
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University of North Carolina nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY  COPYRIGHT OWNER AND CONTRIBUTERS ``AS IS'' AND
+ * ANY  EXPRESS OR  IMPLIED  WARRANTIES,  INCLUDING, BUT  NOT  LIMITED TO,  THE
+ * IMPLIED WARRANTIES  OF MERCHANTABILITY AND FITNESS FOR  A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO  EVENT SHALL THE  COPYRIGHT OWNER OR  CONTRIBUTERS BE
+ * LIABLE  FOR  ANY  DIRECT,   INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT  OF
+ * SUBSTITUTE GOODS  OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+ * INTERRUPTION)  HOWEVER CAUSED  AND ON  ANY THEORY  OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR  TORT (INCLUDING  NEGLIGENCE OR  OTHERWISE)
+ * ARISING IN ANY WAY  OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef HEAP_INBOX_H
+#define HEAP_INBOX_H
+
+#include "heap.h"
+#include "iheap.h"
+
+/* An inbox lets any number of threads queue nodes for a heap that is owned
+ * by a single consumer, without taking the consumer's lock. Producers push
+ * nodes onto a lock-free stack, linked through the nodes' next fields. The
+ * consumer detaches the whole stack at once, builds a binomial forest from
+ * it as heap_build() does, and merges it into the heap with one union.
+ *
+ * The consumer must drain the inbox before it looks at the heap; the
+ * heap_inbox_peek()/heap_inbox_take() wrappers do so. Only the consumer may
+ * drain, and posted nodes must not be touched by the producer anymore.
+ */
+struct heap_inbox {
+	struct heap_node*	top;
+};
+
+struct iheap_inbox {
+	struct iheap_node*	top;
+};
+
+static inline void heap_inbox_init(struct heap_inbox* inbox)
+{
+	inbox->top = NULL;
+}
+
+static inline void iheap_inbox_init(struct iheap_inbox* inbox)
+{
+	inbox->top = NULL;
+}
+
+/* may be called by any thread */
+static inline void heap_inbox_post(struct heap_inbox* inbox,
+				   struct heap_node* node)
+{
+	struct heap_node* top = __atomic_load_n(&inbox->top, __ATOMIC_RELAXED);
+	do {
+		node->next = top;
+	} while (!__atomic_compare_exchange_n(&inbox->top, &top, node, 1,
+					      __ATOMIC_RELEASE,
+					      __ATOMIC_RELAXED));
+}
+
+static inline void iheap_inbox_post(struct iheap_inbox* inbox,
+				    struct iheap_node* node)
+{
+	struct iheap_node* top = __atomic_load_n(&inbox->top, __ATOMIC_RELAXED);
+	do {
+		node->next = top;
+	} while (!__atomic_compare_exchange_n(&inbox->top, &top, node, 1,
+					      __ATOMIC_RELEASE,
+					      __ATOMIC_RELAXED));
+}
+
+/* Move all posted nodes into heap. Returns the number of nodes moved. */
+static inline size_t heap_inbox_drain(heap_prio_t higher_prio,
+				      struct heap_inbox* inbox,
+				      struct heap* heap)
+{
+#ifndef HEAP_PAIRING
+	struct heap_node* trees[HEAP_MAX_DEGREE];
+	struct heap batch;
+	size_t i;
+#endif
+	struct heap_node *pos, *next;
+	size_t n = 0;
+
+	/* cheap check first, so that an empty inbox costs no atomic write */
+	if (!__atomic_load_n(&inbox->top, __ATOMIC_RELAXED))
+		return 0;
+	pos = __atomic_exchange_n(&inbox->top, NULL, __ATOMIC_ACQUIRE);
+#ifdef HEAP_PAIRING
+	/* insertion into a pairing heap is a single link anyway */
+	for (; pos; pos = next, n++) {
+		next = pos->next;
+		heap_insert(higher_prio, heap, pos);
+	}
+#else
+	for (i = 0; i < HEAP_MAX_DEGREE; i++)
+		trees[i] = NULL;
+	for (; pos; pos = next, n++) {
+		next = pos->next;
+		__heap_build_add(higher_prio, heap, trees, pos, 0);
+	}
+	heap_init(&batch);
+	__heap_set_roots(&batch, __heap_collect(trees, HEAP_MAX_DEGREE));
+	heap_union(higher_prio, heap, &batch);
+#endif
+	return n;
+}
+
+static inline size_t iheap_inbox_drain(struct iheap_inbox* inbox,
+				       struct iheap* heap)
+{
+	struct iheap_node* trees[HEAP_MAX_DEGREE];
+	struct iheap_node *pos, *next;
+	struct iheap batch;
+	size_t i, n = 0;
+
+	if (!__atomic_load_n(&inbox->top, __ATOMIC_RELAXED))
+		return 0;
+	pos = __atomic_exchange_n(&inbox->top, NULL, __ATOMIC_ACQUIRE);
+	for (i = 0; i < HEAP_MAX_DEGREE; i++)
+		trees[i] = NULL;
+	for (; pos; pos = next, n++) {
+		next = pos->next;
+		__iheap_build_add(heap, trees, pos, 0);
+	}
+	iheap_init(&batch);
+	__iheap_set_roots(&batch, __iheap_collect(trees, HEAP_MAX_DEGREE));
+	iheap_union(heap, &batch);
+	return n;
+}
+
+static inline struct heap_node* heap_inbox_peek(heap_prio_t higher_prio,
+						struct heap_inbox* inbox,
+						struct heap* heap)
+{
+	heap_inbox_drain(higher_prio, inbox, heap);
+	return heap_peek(higher_prio, heap);
+}
+
+static inline struct heap_node* heap_inbox_take(heap_prio_t higher_prio,
+						struct heap_inbox* inbox,
+						struct heap* heap)
+{
+	heap_inbox_drain(higher_prio, inbox, heap);
+	return heap_take(higher_prio, heap);
+}
+
+static inline struct iheap_node* iheap_inbox_peek(struct iheap_inbox* inbox,
+						  struct iheap* heap)
+{
+	iheap_inbox_drain(inbox, heap);
+	return iheap_peek(heap);
+}
+
+static inline struct iheap_node* iheap_inbox_take(struct iheap_inbox* inbox,
+						  struct iheap* heap)
+{
+	iheap_inbox_drain(inbox, heap);
+	return iheap_take(heap);
+}
+
+#endif /* HEAP_INBOX_H */
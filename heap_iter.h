@@ -0,0 +1,245 @@
+/* heap_iter.h -- Non-destructive ordered iteration over heaps
+ *
+ * Copyright (c) 2008, Bjoern B. Brandenburg <bbb [at] cs.unc.edu>
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University of North Carolina nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY  COPYRIGHT OWNER AND CONTRIBUTERS ``AS IS'' AND
+ * ANY  EXPRESS OR  IMPLIED  WARRANTIES,  INCLUDING, BUT  NOT  LIMITED TO,  THE
+ * IMPLIED WARRANTIES  OF MERCHANTABILITY AND FITNESS FOR  A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO  EVENT SHALL THE  COPYRIGHT OWNER OR  CONTRIBUTERS BE
+ * LIABLE  FOR  ANY  DIRECT,   INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT  OF
+ * SUBSTITUTE GOODS  OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+ * INTERRUPTION)  HOWEVER CAUSED  AND ON  ANY THEORY  OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR  TORT (INCLUDING  NEGLIGENCE OR  OTHERWISE)
+ * ARISING IN ANY WAY  OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef HEAP_ITER_H
+#define HEAP_ITER_H
+
+#include <limits.h>
+#include <stdlib.h>
+
+#include "heap.h"
+#include "iheap.h"
+
+/* An iterator yields the nodes of a heap in priority order without changing
+ * the heap. It keeps a binary heap (the frontier) of nodes whose parents have
+ * already been yielded; yielding a node adds its children. The first k nodes
+ * thus cost O(k log k) time and O(k log n) space.
+ *
+ * Iterating does not count towards the compares of a heap built with
+ * HEAP_STATS.
+ *
+ * The heap must not be changed while an iterator is in use. Since they walk
+ * binomial trees, heap iterators are not available with HEAP_PAIRING.
+ */
+#ifndef HEAP_PAIRING
+struct heap_iter {
+	heap_prio_t		higher_prio;
+	/* the cached minimum is not part of any tree and comes first */
+	struct heap_node*	min;
+	struct heap_node**	front;
+	size_t			n;
+	size_t			capacity;
+	/* set if the frontier could not grow */
+	int			error;
+};
+#endif
+
+struct iheap_iter {
+	struct iheap_node*	min;
+	struct iheap_node**	front;
+	size_t			n;
+	size_t			capacity;
+	int			error;
+};
+
+/* Make room for at least size nodes in the frontier. Returns the (possibly
+ * moved) frontier, or NULL if out of memory.
+ */
+static inline void* __heap_iter_reserve(void* front, size_t* capacity,
+					size_t size)
+{
+	size_t cap = *capacity ? *capacity : HEAP_MAX_DEGREE;
+	while (cap < size)
+		cap *= 2;
+	if (cap != *capacity) {
+		front = realloc(front, cap * sizeof(void*));
+		if (front)
+			*capacity = cap;
+	}
+	return front;
+}
+
+#ifndef HEAP_PAIRING
+/* returns 0 on success and -1 if out of memory */
+static inline int heap_iter_init(struct heap_iter* iter,
+				 heap_prio_t higher_prio, struct heap* heap)
+{
+	struct heap_node *pos, **front;
+	size_t roots = 0;
+
+	iter->higher_prio = higher_prio;
+	iter->min         = heap->min;
+	iter->front       = NULL;
+	iter->n           = 0;
+	iter->capacity    = 0;
+	iter->error       = 0;
+	/* a lazy heap can have many roots */
+	for (pos = heap->head; pos; pos = pos->next)
+		roots++;
+	front = __heap_iter_reserve(NULL, &iter->capacity, roots);
+	if (!front) {
+		iter->error = 1;
+		return -1;
+	}
+	iter->front = front;
+	for (pos = heap->head; pos; pos = pos->next)
+		__heap_frontier_push(higher_prio, NULL, iter->front,
+				     &iter->n, pos);
+	return 0;
+}
+
+static inline void heap_iter_destroy(struct heap_iter* iter)
+{
+	free(iter->front);
+	iter->front    = NULL;
+	iter->n        = 0;
+	iter->capacity = 0;
+}
+
+/* Returns the next node in priority order, or NULL at the end or if the
+ * frontier could not grow (iter->error is set in that case).
+ */
+static inline struct heap_node* heap_iter_next(struct heap_iter* iter)
+{
+	struct heap_node *node, *pos, **front;
+
+	if (iter->min) {
+		node = iter->min;
+		iter->min = NULL;
+		return node;
+	}
+	if (!iter->n || iter->error)
+		return NULL;
+	node = iter->front[0];
+	front = __heap_iter_reserve(iter->front, &iter->capacity,
+				    iter->n - 1 + node->degree);
+	if (!front) {
+		iter->error = 1;
+		return NULL;
+	}
+	iter->front = front;
+	__heap_frontier_pop(iter->higher_prio, NULL, iter->front, &iter->n);
+	for (pos = node->child; pos; pos = pos->next)
+		__heap_frontier_push(iter->higher_prio, NULL,
+				     iter->front, &iter->n, pos);
+	return node;
+}
+
+/* Store the (up to) k highest-priority nodes in nodes, in order, without
+ * removing them. Returns the number of nodes stored, or 0 if out of memory.
+ */
+static inline size_t heap_peek_many(heap_prio_t higher_prio, struct heap* heap,
+				    struct heap_node** nodes, size_t k)
+{
+	struct heap_iter iter;
+	size_t found = 0;
+
+	if (!heap_iter_init(&iter, higher_prio, heap))
+		while (found < k && (nodes[found] = heap_iter_next(&iter)))
+			found++;
+	if (iter.error)
+		found = 0;
+	heap_iter_destroy(&iter);
+	return found;
+}
+#endif /* HEAP_PAIRING */
+
+static inline int iheap_iter_init(struct iheap_iter* iter, struct iheap* heap)
+{
+	struct iheap_node *pos, **front;
+	size_t roots = 0;
+
+	iter->min      = heap->min;
+	iter->front    = NULL;
+	iter->n        = 0;
+	iter->capacity = 0;
+	iter->error    = 0;
+	for (pos = heap->head; pos; pos = pos->next)
+		roots++;
+	front = __heap_iter_reserve(NULL, &iter->capacity, roots);
+	if (!front) {
+		iter->error = 1;
+		return -1;
+	}
+	iter->front = front;
+	for (pos = heap->head; pos; pos = pos->next)
+		__iheap_frontier_push(NULL, iter->front, &iter->n, pos);
+	return 0;
+}
+
+static inline void iheap_iter_destroy(struct iheap_iter* iter)
+{
+	free(iter->front);
+	iter->front    = NULL;
+	iter->n        = 0;
+	iter->capacity = 0;
+}
+
+static inline struct iheap_node* iheap_iter_next(struct iheap_iter* iter)
+{
+	struct iheap_node *node, *pos, **front;
+
+	if (iter->min) {
+		node = iter->min;
+		iter->min = NULL;
+		return node;
+	}
+	if (!iter->n || iter->error)
+		return NULL;
+	node = iter->front[0];
+	front = __heap_iter_reserve(iter->front, &iter->capacity,
+				    iter->n - 1 + node->degree);
+	if (!front) {
+		iter->error = 1;
+		return NULL;
+	}
+	iter->front = front;
+	__iheap_frontier_pop(NULL, iter->front, &iter->n);
+	for (pos = node->child; pos; pos = pos->next)
+		__iheap_frontier_push(NULL, iter->front, &iter->n, pos);
+	return node;
+}
+
+static inline size_t iheap_peek_many(struct iheap* heap,
+				     struct iheap_node** nodes, size_t k)
+{
+	struct iheap_iter iter;
+	size_t found = 0;
+
+	if (!iheap_iter_init(&iter, heap))
+		while (found < k && (nodes[found] = iheap_iter_next(&iter)))
+			found++;
+	if (iter.error)
+		found = 0;
+	iheap_iter_destroy(&iter);
+	return found;
+}
+
+#endif /* HEAP_ITER_H */
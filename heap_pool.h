@@ -0,0 +1,212 @@
+/* heap_pool.h -- Slab allocator for heap nodes
+ *
+ * Copyright (c) 2008, Bjoern B. Brandenburg <bbb [at] cs.unc.edu>
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University of North Carolina nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY  COPYRIGHT OWNER AND CONTRIBUTERS ``AS IS'' AND
+ * ANY  EXPRESS OR  IMPLIED  WARRANTIES,  INCLUDING, BUT  NOT  LIMITED TO,  THE
+ * IMPLIED WARRANTIES  OF MERCHANTABILITY AND FITNESS FOR  A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO  EVENT SHALL THE  COPYRIGHT OWNER OR  CONTRIBUTERS BE
+ * LIABLE  FOR  ANY  DIRECT,   INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT  OF
+ * SUBSTITUTE GOODS  OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+ * INTERRUPTION)  HOWEVER CAUSED  AND ON  ANY THEORY  OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR  TORT (INCLUDING  NEGLIGENCE OR  OTHERWISE)
+ * ARISING IN ANY WAY  OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef HEAP_POOL_H
+#define HEAP_POOL_H
+
+#include <limits.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "heap.h"
+#include "iheap.h"
+
+#define HEAP_POOL_CACHE_LINE	64
+#define HEAP_POOL_SLAB_SIZE	(64 * 1024)
+
+/* Slabs are never returned to malloc() before heap_pool_destroy(). Instead,
+ * heap_pool_reset() rewinds the pool to the first slab, so a pool that backs
+ * a single heap can be recycled as a whole in O(1).
+ */
+struct heap_pool_slab {
+	struct heap_pool_slab*	next;
+	/* as returned by malloc() */
+	void*			mem;
+	/* cache-line aligned start of the objects */
+	char*			objs;
+};
+
+struct heap_pool {
+	size_t			size;
+	size_t			per_slab;
+	struct heap_pool_slab*	slabs;
+	/* slab that is currently being carved up */
+	struct heap_pool_slab*	cur;
+	char*			pos;
+	char*			end;
+	/* recycled objects, linked through their first word */
+	void*			free;
+};
+
+static inline void heap_pool_init(struct heap_pool* pool, size_t size)
+{
+	/* we need room for the free list link */
+	if (size < sizeof(void*))
+		size = sizeof(void*);
+	size = (size + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+	pool->size     = size;
+	/* objects larger than a slab get a slab of their own */
+	pool->per_slab = size < HEAP_POOL_SLAB_SIZE ?
+		HEAP_POOL_SLAB_SIZE / size : 1;
+	pool->slabs    = NULL;
+	pool->cur      = NULL;
+	pool->pos      = NULL;
+	pool->end      = NULL;
+	pool->free     = NULL;
+}
+
+static inline void __heap_pool_carve(struct heap_pool* pool,
+				     struct heap_pool_slab* slab)
+{
+	pool->cur = slab;
+	pool->pos = slab->objs;
+	pool->end = slab->objs + pool->size * pool->per_slab;
+}
+
+static inline struct heap_pool_slab* __heap_pool_grow(struct heap_pool* pool)
+{
+	struct heap_pool_slab* slab;
+	void* mem;
+	uintptr_t objs;
+
+	mem = malloc(sizeof(struct heap_pool_slab) + HEAP_POOL_CACHE_LINE +
+		     pool->size * pool->per_slab);
+	if (!mem)
+		return NULL;
+	slab = (struct heap_pool_slab*) mem;
+	objs = (uintptr_t) (slab + 1);
+	objs = (objs + HEAP_POOL_CACHE_LINE - 1) &
+		~((uintptr_t) HEAP_POOL_CACHE_LINE - 1);
+	slab->next = NULL;
+	slab->mem  = mem;
+	slab->objs = (char*) objs;
+	if (pool->cur)
+		pool->cur->next = slab;
+	else
+		pool->slabs = slab;
+	return slab;
+}
+
+/* returns NULL if the pool cannot grow */
+static inline void* heap_pool_alloc(struct heap_pool* pool)
+{
+	void* obj;
+	struct heap_pool_slab* slab;
+
+	if (pool->free) {
+		obj = pool->free;
+		pool->free = *((void**) obj);
+		return obj;
+	}
+	if (pool->pos == pool->end) {
+		/* reuse slabs left over from before the last reset */
+		slab = pool->cur ? pool->cur->next : pool->slabs;
+		if (!slab)
+			slab = __heap_pool_grow(pool);
+		if (!slab)
+			return NULL;
+		__heap_pool_carve(pool, slab);
+	}
+	obj = pool->pos;
+	pool->pos += pool->size;
+	return obj;
+}
+
+static inline void heap_pool_free(struct heap_pool* pool, void* obj)
+{
+	*((void**) obj) = pool->free;
+	pool->free = obj;
+}
+
+/* Return every object to the pool at once. Outstanding objects become
+ * invalid. Slabs are kept for reuse.
+ */
+static inline void heap_pool_reset(struct heap_pool* pool)
+{
+	pool->free = NULL;
+	if (pool->slabs)
+		__heap_pool_carve(pool, pool->slabs);
+}
+
+static inline void heap_pool_destroy(struct heap_pool* pool)
+{
+	struct heap_pool_slab *slab, *next;
+	for (slab = pool->slabs; slab; slab = next) {
+		next = slab->next;
+		free(slab->mem);
+	}
+	heap_pool_init(pool, pool->size);
+}
+
+static inline struct heap_node* heap_node_alloc(struct heap_pool* pool)
+{
+	return (struct heap_node*) heap_pool_alloc(pool);
+}
+
+static inline void heap_node_free(struct heap_pool* pool,
+				  struct heap_node* node)
+{
+	heap_pool_free(pool, node);
+}
+
+static inline struct iheap_node* iheap_node_alloc(struct heap_pool* pool)
+{
+	return (struct iheap_node*) heap_pool_alloc(pool);
+}
+
+static inline void iheap_node_free(struct heap_pool* pool,
+				   struct iheap_node* node)
+{
+	heap_pool_free(pool, node);
+}
+
+/* Empty heap and hand all of its nodes back to pool in O(1). The heap keeps
+ * its mode. Every node allocated from pool becomes invalid, so pool must not
+ * back any other heap.
+ */
+static inline void heap_clear(struct heap* heap, struct heap_pool* pool)
+{
+	heap->head = NULL;
+#ifndef HEAP_PAIRING
+	heap->tail = NULL;
+	heap->min  = NULL;
+#endif
+	heap_pool_reset(pool);
+}
+
+static inline void iheap_clear(struct iheap* heap, struct heap_pool* pool)
+{
+	heap->head = NULL;
+	heap->tail = NULL;
+	heap->min  = NULL;
+	heap_pool_reset(pool);
+}
+
+#endif /* HEAP_POOL_H */
@@ -0,0 +1,90 @@
+/* heap_stats.h -- Operation counters for heap.h and iheap.h
+ *
+ * Copyright (c) 2008, Bjoern B. Brandenburg <bbb [at] cs.unc.edu>
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University of North Carolina nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY  COPYRIGHT OWNER AND CONTRIBUTERS ``AS IS'' AND
+ * ANY  EXPRESS OR  IMPLIED  WARRANTIES,  INCLUDING, BUT  NOT  LIMITED TO,  THE
+ * IMPLIED WARRANTIES  OF MERCHANTABILITY AND FITNESS FOR  A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO  EVENT SHALL THE  COPYRIGHT OWNER OR  CONTRIBUTERS BE
+ * LIABLE  FOR  ANY  DIRECT,   INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT  OF
+ * SUBSTITUTE GOODS  OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+ * INTERRUPTION)  HOWEVER CAUSED  AND ON  ANY THEORY  OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR  TORT (INCLUDING  NEGLIGENCE OR  OTHERWISE)
+ * ARISING IN ANY WAY  OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef HEAP_STATS_H
+#define HEAP_STATS_H
+
+#include <stdio.h>
+
+/* Per-heap operation counters. They are only maintained if HEAP_STATS is
+ * defined before heap.h or iheap.h is included; otherwise, struct heap and
+ * struct iheap do not even contain them.
+ */
+struct heap_stats {
+	/* priority comparisons */
+	unsigned long	compares;
+	/* trees linked below another root */
+	unsigned long	links;
+	/* root list scans for the minimum, and the roots visited by them */
+	unsigned long	min_scans;
+	unsigned long	roots_scanned;
+	/* levels moved by decrease and delete operations */
+	unsigned long	bubble_depth;
+	/* peek and take operations that found the minimum cached or not */
+	unsigned long	min_hits;
+	unsigned long	min_misses;
+};
+
+static inline void heap_stats_reset(struct heap_stats* stats)
+{
+	stats->compares      = 0;
+	stats->links         = 0;
+	stats->min_scans     = 0;
+	stats->roots_scanned = 0;
+	stats->bubble_depth  = 0;
+	stats->min_hits      = 0;
+	stats->min_misses    = 0;
+}
+
+/* accumulate the counters of several heaps */
+static inline void heap_stats_add(struct heap_stats* sum,
+				  const struct heap_stats* stats)
+{
+	sum->compares      += stats->compares;
+	sum->links         += stats->links;
+	sum->min_scans     += stats->min_scans;
+	sum->roots_scanned += stats->roots_scanned;
+	sum->bubble_depth  += stats->bubble_depth;
+	sum->min_hits      += stats->min_hits;
+	sum->min_misses    += stats->min_misses;
+}
+
+static inline void heap_stats_dump(FILE* out, const char* label,
+				   const struct heap_stats* stats)
+{
+	fprintf(out, "%s: compares=%lu links=%lu min_scans=%lu "
+		"roots_scanned=%lu bubble_depth=%lu min_hits=%lu "
+		"min_misses=%lu\n",
+		label, stats->compares, stats->links, stats->min_scans,
+		stats->roots_scanned, stats->bubble_depth, stats->min_hits,
+		stats->min_misses);
+}
+
+#endif /* HEAP_STATS_H */
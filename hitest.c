@@ -0,0 +1,147 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+
+#define HEAP_INTRUSIVE
+#include "heap.h"
+
+/* Random inserts, takes, decreases, increases, deletes, and unions on two
+ * heaps of items that embed their nodes, against a table of the keys that
+ * should be in each heap. Nodes never move, so heap_entry() must always
+ * lead back to the item that was inserted.
+ */
+
+#ifdef HEAP_PAIRING
+#define NAME	"phitest"
+#else
+#define NAME	"hitest"
+#endif
+
+#define N	1000
+#define STEPS	40000
+
+/* the node lives inside the item; no value pointer to follow */
+struct item {
+	int			prio;
+	/* 0 or 1, or -1 if not in a heap */
+	int			heap;
+	struct heap_node	node;
+};
+
+static struct item items[N];
+static struct heap heaps[2];
+
+static int item_cmp(struct heap_node* _a, struct heap_node* _b)
+{
+	struct item *a, *b;
+	a = heap_entry(_a, struct item, node);
+	b = heap_entry(_b, struct item, node);
+	return a->prio < b->prio;
+}
+
+static int min_prio(int h)
+{
+	int i, min = INT_MAX;
+	for (i = 0; i < N; i++)
+		if (items[i].heap == h && items[i].prio < min)
+			min = items[i].prio;
+	return min;
+}
+
+/* random item in heap h (-1: not in a heap), or NULL */
+static struct item* pick(int h)
+{
+	int i, start = rand() % N;
+	for (i = 0; i < N; i++)
+		if (items[(start + i) % N].heap == h)
+			return &items[(start + i) % N];
+	return NULL;
+}
+
+static int take(int h)
+{
+	struct heap_node* hn;
+	struct item* it;
+	int expected = min_prio(h);
+
+	hn = heap_take(item_cmp, heaps + h);
+	if (!hn)
+		return expected != INT_MAX;
+	it = heap_entry(hn, struct item, node);
+	if (it < items || it >= items + N || it->heap != h ||
+	    it->prio != expected || heap_node_in_heap(hn)) {
+		fprintf(stderr, NAME ": took %d from heap %d, expected %d\n",
+			it->prio, h, expected);
+		return 1;
+	}
+	it->heap = -1;
+	return 0;
+}
+
+static int test_random(int lazy)
+{
+	struct item* it;
+	int i, h, dice, err = 0;
+
+	for (h = 0; h < 2; h++)
+		if (lazy)
+			heap_init_lazy(heaps + h);
+		else
+			heap_init(heaps + h);
+	for (i = 0; i < N; i++)
+		items[i].heap = -1;
+
+	for (i = 0; i < STEPS && !err; i++) {
+		h    = rand() % 2;
+		dice = rand() % 16;
+		if (dice < 5) {
+			if (!(it = pick(-1)))
+				continue;
+			it->prio = rand() % N;
+			it->heap = h;
+			heap_node_init(&it->node);
+			heap_insert(item_cmp, heaps + h, &it->node);
+		} else if (dice == 5) {
+			/* cache the minimum for the operations that follow */
+			heap_peek(item_cmp, heaps + h);
+		} else if (dice < 9) {
+			err = take(h);
+		} else if (dice < 11) {
+			if (!(it = pick(h)))
+				continue;
+			it->prio -= rand() % N;
+			heap_decrease(item_cmp, heaps + h, &it->node);
+		} else if (dice < 13) {
+			if (!(it = pick(h)))
+				continue;
+			it->prio += rand() % N;
+			heap_increase(item_cmp, heaps + h, &it->node);
+		} else if (dice < 15) {
+			if (!(it = pick(h)))
+				continue;
+			heap_delete(item_cmp, heaps + h, &it->node);
+			it->heap = -1;
+		} else if (rand() % 4 == 0) {
+			heap_union(item_cmp, heaps, heaps + 1);
+			for (it = items; it < items + N; it++)
+				if (it->heap == 1)
+					it->heap = 0;
+		}
+	}
+	for (h = 0; h < 2 && !err; h++)
+		while (!err && !heap_empty(heaps + h))
+			err = take(h);
+	if (!err && (pick(0) || pick(1))) {
+		fprintf(stderr, NAME ": heap ran empty too early\n");
+		err = 1;
+	}
+	return err;
+}
+
+int main(int argc __attribute__((unused)), char** argv __attribute__((unused)))
+{
+	srand(1);
+	if (test_random(0) || test_random(1))
+		return 1;
+	return 0;
+}
@@ -0,0 +1,244 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+
+#include <pthread.h>
+
+#include "heap_inbox.h"
+
+/* Several threads post nodes with random keys into an inbox while the
+ * consumer drains it and takes nodes from the heap. Every node must arrive
+ * exactly once, the drains must account for all of them, and once the
+ * producers are done, the rest must come out in order. heap_inbox_take()
+ * and heap_inbox_peek() must see nodes that were posted but not drained.
+ */
+
+#define PRODUCERS	4
+#define PER_PRODUCER	20000
+#define TOTAL		(PRODUCERS * PER_PRODUCER)
+
+struct item {
+	int key;
+	int taken;
+};
+
+static struct item items[TOTAL];
+static struct heap_node hnodes[TOTAL];
+static struct iheap_node inodes[TOTAL];
+
+static struct heap_inbox inbox;
+static struct iheap_inbox iinbox;
+static int producing;
+
+static int item_less(struct heap_node* a, struct heap_node* b)
+{
+	return ((struct item*) heap_node_value(a))->key <
+	       ((struct item*) heap_node_value(b))->key;
+}
+
+static void* produce(void* arg)
+{
+	int i, first = (int) (size_t) arg * PER_PRODUCER;
+
+	for (i = first; i < first + PER_PRODUCER; i++)
+		heap_inbox_post(&inbox, hnodes + i);
+	__atomic_sub_fetch(&producing, 1, __ATOMIC_RELEASE);
+	return NULL;
+}
+
+static void* iproduce(void* arg)
+{
+	int i, first = (int) (size_t) arg * PER_PRODUCER;
+
+	for (i = first; i < first + PER_PRODUCER; i++)
+		iheap_inbox_post(&iinbox, inodes + i);
+	__atomic_sub_fetch(&producing, 1, __ATOMIC_RELEASE);
+	return NULL;
+}
+
+static void make_items(void)
+{
+	int i;
+	for (i = 0; i < TOTAL; i++) {
+		items[i].key   = rand() % TOTAL;
+		items[i].taken = 0;
+	}
+}
+
+/* mark it as taken; unless the producers are still posting, its key must
+ * not be below the last one taken
+ */
+static int check_take(struct item* it, int* last, int ordered)
+{
+	if (it->taken) {
+		fprintf(stderr, "ibtest: key %d taken twice\n", it->key);
+		return 1;
+	}
+	if (ordered && it->key < *last) {
+		fprintf(stderr, "ibtest: took %d after %d\n", it->key, *last);
+		return 1;
+	}
+	it->taken = 1;
+	*last = it->key;
+	return 0;
+}
+
+static int start(pthread_t* threads, void* (*fn)(void*))
+{
+	size_t i;
+	producing = PRODUCERS;
+	for (i = 0; i < PRODUCERS; i++)
+		if (pthread_create(threads + i, NULL, fn, (void*) i)) {
+			perror("pthread_create");
+			return 1;
+		}
+	return 0;
+}
+
+static void join(pthread_t* threads)
+{
+	int i;
+	for (i = 0; i < PRODUCERS; i++)
+		pthread_join(threads[i], NULL);
+}
+
+static int test_heap(int lazy)
+{
+	pthread_t threads[PRODUCERS];
+	struct heap heap;
+	struct heap_node* hn;
+	size_t drained = 0, taken = 0;
+	int i, last = INT_MIN, err = 0;
+
+	make_items();
+	for (i = 0; i < TOTAL; i++)
+		heap_node_init(hnodes + i, items + i);
+	if (lazy)
+		heap_init_lazy(&heap);
+	else
+		heap_init(&heap);
+	heap_inbox_init(&inbox);
+	if (start(threads, produce))
+		return 1;
+	/* the consumer keeps draining and taking while the producers post */
+	while (!err && __atomic_load_n(&producing, __ATOMIC_ACQUIRE)) {
+		drained += heap_inbox_drain(item_less, &inbox, &heap);
+		if ((hn = heap_take(item_less, &heap))) {
+			err = check_take(heap_node_value(hn), &last, 0);
+			taken++;
+		}
+	}
+	join(threads);
+	drained += heap_inbox_drain(item_less, &inbox, &heap);
+	if (!err && drained != TOTAL) {
+		fprintf(stderr, "ibtest: drained %lu of %d nodes\n",
+			(unsigned long) drained, TOTAL);
+		return 1;
+	}
+	last = INT_MIN;
+	while (!err && (hn = heap_inbox_take(item_less, &inbox, &heap))) {
+		err = check_take(heap_node_value(hn), &last, 1);
+		taken++;
+	}
+	if (!err && taken != TOTAL) {
+		fprintf(stderr, "ibtest: took %lu of %d nodes\n",
+			(unsigned long) taken, TOTAL);
+		err = 1;
+	}
+	return err;
+}
+
+static int test_iheap(int lazy)
+{
+	pthread_t threads[PRODUCERS];
+	struct iheap heap;
+	struct iheap_node* hn;
+	size_t drained = 0, taken = 0;
+	int i, last = INT_MIN, err = 0;
+
+	make_items();
+	for (i = 0; i < TOTAL; i++)
+		iheap_node_init(inodes + i, items[i].key, items + i);
+	if (lazy)
+		iheap_init_lazy(&heap);
+	else
+		iheap_init(&heap);
+	iheap_inbox_init(&iinbox);
+	if (start(threads, iproduce))
+		return 1;
+	while (!err && __atomic_load_n(&producing, __ATOMIC_ACQUIRE)) {
+		drained += iheap_inbox_drain(&iinbox, &heap);
+		if ((hn = iheap_take(&heap))) {
+			err = check_take((struct item*) iheap_node_value(hn),
+					 &last, 0);
+			taken++;
+		}
+	}
+	join(threads);
+	drained += iheap_inbox_drain(&iinbox, &heap);
+	if (!err && drained != TOTAL) {
+		fprintf(stderr, "ibtest: drained %lu of %d inodes\n",
+			(unsigned long) drained, TOTAL);
+		return 1;
+	}
+	last = INT_MIN;
+	while (!err && (hn = iheap_inbox_take(&iinbox, &heap))) {
+		err = check_take((struct item*) iheap_node_value(hn), &last,
+				 1);
+		taken++;
+	}
+	if (!err && taken != TOTAL) {
+		fprintf(stderr, "ibtest: took %lu of %d inodes\n",
+			(unsigned long) taken, TOTAL);
+		err = 1;
+	}
+	return err;
+}
+
+/* the wrappers drain before they look at the heap */
+static int test_wrappers(void)
+{
+	struct heap heap;
+	struct iheap iheap;
+	int i;
+
+	make_items();
+	heap_init(&heap);
+	iheap_init(&iheap);
+	heap_inbox_init(&inbox);
+	iheap_inbox_init(&iinbox);
+	for (i = 0; i < 3; i++) {
+		items[i].key = 10 - i;
+		heap_node_init(hnodes + i, items + i);
+		iheap_node_init(inodes + i, items[i].key, items + i);
+	}
+	heap_insert(item_less, &heap, hnodes);
+	iheap_insert(&iheap, inodes);
+	heap_peek(item_less, &heap);
+	iheap_peek(&iheap);
+	heap_inbox_post(&inbox, hnodes + 1);
+	heap_inbox_post(&inbox, hnodes + 2);
+	iheap_inbox_post(&iinbox, inodes + 1);
+	iheap_inbox_post(&iinbox, inodes + 2);
+	if (heap_inbox_peek(item_less, &inbox, &heap) != hnodes + 2 ||
+	    heap_inbox_take(item_less, &inbox, &heap) != hnodes + 2 ||
+	    iheap_inbox_peek(&iinbox, &iheap) != inodes + 2 ||
+	    iheap_inbox_take(&iinbox, &iheap) != inodes + 2) {
+		fprintf(stderr, "ibtest: posted minimum not seen\n");
+		return 1;
+	}
+	return 0;
+}
+
+int main(int argc __attribute__((unused)), char** argv __attribute__((unused)))
+{
+	int lazy;
+
+	srand(1);
+	if (test_wrappers())
+		return 1;
+	for (lazy = 0; lazy < 2; lazy++)
+		if (test_heap(lazy) || test_iheap(lazy))
+			return 1;
+	return 0;
+}
@@ -33,6 +33,16 @@
 
 #define NOT_IN_HEAP UINT_MAX
 
+/* upper bound on the degree of any node; requires <limits.h> */
+#define HEAP_MAX_DEGREE (sizeof(size_t) * CHAR_BIT)
+
+#ifdef HEAP_STATS
+#include "heap_stats.h"
+#define __HEAP_STAT(heap, field, n)	((heap)->stats.field += (n))
+#else
+#define __HEAP_STAT(heap, field, n)	((void) (heap))
+#endif
+
 struct iheap_node {
 	struct iheap_node* 	parent;
 	struct iheap_node* 	next;
@@ -46,17 +56,42 @@ struct iheap_node {
 
 struct iheap {
 	struct iheap_node* 	head;
+	/* the last root; see struct heap */
+	struct iheap_node*	tail;
 	/* We cache the minimum of the heap.
 	 * This speeds up repeated peek operations.
 	 */
 	struct iheap_node*	min;
+	/* In lazy mode, insertions and unions only splice root lists in O(1).
+	 * Consolidation is deferred until the minimum is needed, or until a
+	 * node is removed from within its tree; see struct heap.
+	 */
+	int			lazy;
+#ifdef HEAP_STATS
+	struct heap_stats	stats;
+#endif
 };
 
 
 static inline void iheap_init(struct iheap* heap)
 {
 	heap->head = NULL;
+	heap->tail = NULL;
 	heap->min  = NULL;
+#ifdef HEAP_LAZY
+	heap->lazy = 1;
+#else
+	heap->lazy = 0;
+#endif
+#ifdef HEAP_STATS
+	heap_stats_reset(&heap->stats);
+#endif
+}
+
+static inline void iheap_init_lazy(struct iheap* heap)
+{
+	iheap_init(heap);
+	heap->lazy = 1;
 }
 
 static inline void iheap_node_init_ref(struct iheap_node** _h,
@@ -98,6 +133,14 @@ static inline int iheap_empty(struct iheap* heap)
 	return heap->head == NULL && heap->min == NULL;
 }
 
+/* all key comparisons go through here so that they can be counted */
+static inline int __iheap_less(struct iheap* heap,
+			       struct iheap_node* a, struct iheap_node* b)
+{
+	__HEAP_STAT(heap, compares, 1);
+	return a->key < b->key;
+}
+
 /* make child a subtree of root */
 static inline void __iheap_link(struct iheap_node* root,
 			       struct iheap_node* child)
@@ -153,6 +196,30 @@ static inline struct iheap_node* __iheap_reverse(struct iheap_node* h)
 	return h;
 }
 
+/* replace the root list; the tail is searched, so only for short lists */
+static inline void __iheap_set_roots(struct iheap* heap,
+				     struct iheap_node* head)
+{
+	heap->head = head;
+	heap->tail = head;
+	if (head)
+		while (heap->tail->next)
+			heap->tail = heap->tail->next;
+}
+
+/* unlink a root, given the root before it (or NULL) */
+static inline void __iheap_remove_root(struct iheap* heap,
+				       struct iheap_node* prev,
+				       struct iheap_node* node)
+{
+	if (prev)
+		prev->next = node->next;
+	else
+		heap->head = node->next;
+	if (heap->tail == node)
+		heap->tail = prev;
+}
+
 static inline void __iheap_min(struct iheap* heap,
 			      struct iheap_node** prev,
 			      struct iheap_node** node)
@@ -165,11 +232,14 @@ static inline void __iheap_min(struct iheap* heap,
 		return;
 	}
 
+	__HEAP_STAT(heap, min_scans, 1);
+	__HEAP_STAT(heap, roots_scanned, 1);
 	*node = heap->head;
 	_prev = heap->head;
 	cur   = heap->head->next;
 	while (cur) {
-		if (cur->key < (*node)->key) {
+		__HEAP_STAT(heap, roots_scanned, 1);
+		if (__iheap_less(heap, cur, *node)) {
 			*node = cur;
 			*prev = _prev;
 		}
@@ -186,7 +256,7 @@ static inline void __iheap_union(struct iheap* heap, struct iheap_node* h2)
 		return;
 	h1 = heap->head;
 	if (!h1) {
-		heap->head = h2;
+		__iheap_set_roots(heap, h2);
 		return;
 	}
 	h1 = __iheap_merge(h1, h2);
@@ -199,10 +269,11 @@ static inline void __iheap_union(struct iheap* heap, struct iheap_node* h2)
 			/* nothing to do, advance */
 			prev = x;
 			x    = next;
-		} else if (x->key < next->key) {
+		} else if (__iheap_less(heap, x, next)) {
 			/* x becomes the root of next */
 			x->next = next->next;
 			__iheap_link(x, next);
+			__HEAP_STAT(heap, links, 1);
 		} else {
 			/* next becomes the root of x */
 			if (prev)
@@ -210,23 +281,123 @@ static inline void __iheap_union(struct iheap* heap, struct iheap_node* h2)
 			else
 				h1 = next;
 			__iheap_link(next, x);
+			__HEAP_STAT(heap, links, 1);
 			x = next;
 		}
 		next = x->next;
 	}
 	heap->head = h1;
+	heap->tail = x;
+}
+
+/* Linking trees into a degree-indexed array works like incrementing a binary
+ * counter: trees[d] holds the tree of degree d, if any, and a new tree carries
+ * through the occupied slots.
+ */
+static inline void __iheap_carry(struct iheap* heap,
+				 struct iheap_node** trees,
+				 struct iheap_node* node, int sorted)
+{
+	struct iheap_node* other;
+	unsigned int d = node->degree;
+	while ((other = trees[d])) {
+		trees[d] = NULL;
+		/* If the input is sorted, the earlier tree always wins. */
+		if (!sorted && __iheap_less(heap, node, other))
+			__iheap_link(node, other);
+		else {
+			__iheap_link(other, node);
+			node = other;
+		}
+		__HEAP_STAT(heap, links, 1);
+		d++;
+	}
+	trees[d] = node;
+}
+
+/* turn the first limit slots of an array of trees into a root list,
+ * ordered by degree
+ */
+static inline struct iheap_node* __iheap_collect(struct iheap_node** trees,
+						 unsigned int limit)
+{
+	struct iheap_node* head = NULL;
+	unsigned int d = limit;
+	while (d--)
+		if (trees[d]) {
+			trees[d]->next = head;
+			head = trees[d];
+		}
+	return head;
+}
+
+/* link roots of equal degree until all degrees are unique (lazy mode) */
+static inline void __iheap_consolidate(struct iheap* heap)
+{
+	struct iheap_node* trees[HEAP_MAX_DEGREE];
+	struct iheap_node *pos, *next;
+	unsigned int d, limit, max = 0;
+	unsigned long roots = 0;
+	int ordered = 1;
+	for (pos = heap->head; pos; pos = pos->next) {
+		if (pos->next && pos->degree >= pos->next->degree)
+			ordered = 0;
+		if (pos->degree > max)
+			max = pos->degree;
+		roots++;
+	}
+	/* nothing to do if the degrees are already unique and ordered */
+	if (ordered)
+		return;
+	/* no resulting tree can have a degree beyond max + log2(roots) */
+	limit = max + 1;
+	while (roots >>= 1)
+		limit++;
+	if (limit > HEAP_MAX_DEGREE)
+		limit = HEAP_MAX_DEGREE;
+	for (d = 0; d < limit; d++)
+		trees[d] = NULL;
+	for (pos = heap->head; pos; pos = next) {
+		next = pos->next;
+		__iheap_carry(heap, trees, pos, 0);
+	}
+	__iheap_set_roots(heap, __iheap_collect(trees, limit));
+}
+
+/* prepend the roots from h2 to t2 without linking (lazy mode) */
+static inline void __iheap_splice(struct iheap* heap, struct iheap_node* h2,
+				  struct iheap_node* t2)
+{
+	if (!h2)
+		return;
+	t2->next = heap->head;
+	if (!heap->head)
+		heap->tail = t2;
+	heap->head = h2;
+}
+
+/* h2 is a single tree or the pieces of one, i.e., O(log n) roots */
+static inline void __iheap_add_roots(struct iheap* heap,
+				     struct iheap_node* h2)
+{
+	struct iheap_node* t2;
+	if (heap->lazy) {
+		for (t2 = h2; t2 && t2->next; t2 = t2->next)
+			;
+		__iheap_splice(heap, h2, t2);
+	} else
+		__iheap_union(heap, h2);
 }
 
 static inline struct iheap_node* __iheap_extract_min(struct iheap* heap)
 {
 	struct iheap_node *prev, *node;
+	if (heap->lazy)
+		__iheap_consolidate(heap);
 	__iheap_min(heap, &prev, &node);
 	if (!node)
 		return NULL;
-	if (prev)
-		prev->next = node->next;
-	else
-		heap->head = node->next;
+	__iheap_remove_root(heap, prev, node);
 	__iheap_union(heap, __iheap_reverse(node->child));
 	return node;
 }
@@ -239,17 +410,17 @@ static inline void iheap_insert(struct iheap* heap, struct iheap_node* node)
 	node->parent = NULL;
 	node->next   = NULL;
 	node->degree = 0;
-	if (heap->min && node->key < heap->min->key) {
+	if (heap->min && __iheap_less(heap, node, heap->min)) {
 		/* swap min cache */
 		min = heap->min;
 		min->child  = NULL;
 		min->parent = NULL;
 		min->next   = NULL;
 		min->degree = 0;
-		__iheap_union(heap, min);
+		__iheap_add_roots(heap, min);
 		heap->min   = node;
 	} else
-		__iheap_union(heap, node);
+		__iheap_add_roots(heap, node);
 }
 
 static inline void __iheap_uncache_min(struct iheap* heap)
@@ -268,23 +439,78 @@ static inline void iheap_union(struct iheap* target, struct iheap* addition)
 	/* first insert any cached minima, if necessary */
 	__iheap_uncache_min(target);
 	__iheap_uncache_min(addition);
-	__iheap_union(target, addition->head);
+	/* an eager heap expects its roots to have unique degrees */
+	if (target->lazy)
+		__iheap_splice(target, addition->head, addition->tail);
+	else {
+		if (addition->lazy)
+			__iheap_consolidate(addition);
+		__iheap_union(target, addition->head);
+	}
 	/* this is a destructive merge */
 	addition->head = NULL;
+	addition->tail = NULL;
+}
+
+static inline void __iheap_build_add(struct iheap* heap,
+				     struct iheap_node** trees,
+				     struct iheap_node* node, int sorted)
+{
+	node->child  = NULL;
+	node->parent = NULL;
+	node->next   = NULL;
+	node->degree = 0;
+	__iheap_carry(heap, trees, node, sorted);
+}
+
+static inline void __iheap_build(struct iheap* heap,
+				 struct iheap_node** nodes, size_t n, int sorted)
+{
+	struct iheap_node* trees[HEAP_MAX_DEGREE];
+	size_t i;
+	for (i = 0; i < HEAP_MAX_DEGREE; i++)
+		trees[i] = NULL;
+	for (i = 0; i < n; i++)
+		__iheap_build_add(heap, trees, nodes[i], sorted);
+	/* the cached minimum might not be the minimum anymore */
+	__iheap_uncache_min(heap);
+	__iheap_add_roots(heap, __iheap_collect(trees, HEAP_MAX_DEGREE));
+}
+
+/* insert (and reinitialize) n nodes at once in O(n) time */
+static inline void iheap_build(struct iheap* heap,
+			       struct iheap_node** nodes, size_t n)
+{
+	__iheap_build(heap, nodes, n, 0);
+}
+
+/* like iheap_build(), but nodes must be sorted in order of increasing key;
+ * no comparisons are required in this case
+ */
+static inline void iheap_build_sorted(struct iheap* heap,
+				      struct iheap_node** nodes, size_t n)
+{
+	__iheap_build(heap, nodes, n, 1);
 }
 
 static inline struct iheap_node* iheap_peek(struct iheap* heap)
 {
-	if (!heap->min)
+	if (!heap->min) {
+		__HEAP_STAT(heap, min_misses, 1);
 		heap->min = __iheap_extract_min(heap);
+	} else
+		__HEAP_STAT(heap, min_hits, 1);
 	return heap->min;
 }
 
 static inline struct iheap_node* iheap_take(struct iheap* heap)
 {
 	struct iheap_node *node;
-	if (!heap->min)
+	if (!heap->min) {
+		__HEAP_STAT(heap, min_misses, 1);
 		heap->min = __iheap_extract_min(heap);
+	} else
+		__HEAP_STAT(heap, min_hits, 1);
 	node = heap->min;
 	heap->min = NULL;
 	if (node)
@@ -292,6 +518,207 @@ static inline struct iheap_node* iheap_take(struct iheap* heap)
 	return node;
 }
 
+/* Batches taken by iheap_take_many() keep their candidates on the stack. */
+#define IHEAP_TAKE_MANY_BATCH 256
+/* Smaller batches do not pay for building the candidate heap. */
+#define IHEAP_TAKE_MANY_MIN 8
+
+/* as in heap.h, iterators pass no heap and their comparisons are not
+ * counted
+ */
+static inline int __iheap_frontier_less(struct iheap* heap,
+					struct iheap_node* a,
+					struct iheap_node* b)
+{
+	if (heap)
+		__HEAP_STAT(heap, compares, 1);
+	return a->key < b->key;
+}
+
+/* binary heap of candidate roots, smallest key first */
+static inline void __iheap_frontier_push(struct iheap* heap,
+					 struct iheap_node** front,
+					 size_t* n,
+					 struct iheap_node* node)
+{
+	size_t i = (*n)++, up;
+	while (i) {
+		up = (i - 1) / 2;
+		if (!__iheap_frontier_less(heap, node, front[up]))
+			break;
+		front[i] = front[up];
+		i = up;
+	}
+	front[i] = node;
+}
+
+static inline struct iheap_node* __iheap_frontier_pop(struct iheap* heap,
+						      struct iheap_node** front,
+						      size_t* n)
+{
+	struct iheap_node *top = front[0], *last = front[--*n];
+	size_t i = 0, c;
+	while ((c = 2 * i + 1) < *n) {
+		if (c + 1 < *n &&
+		    __iheap_frontier_less(heap, front[c + 1], front[c]))
+			c++;
+		if (!__iheap_frontier_less(heap, front[c], last))
+			break;
+		front[i] = front[c];
+		i = c;
+	}
+	front[i] = last;
+	return top;
+}
+
+/* Take up to k nodes in key order and store them in nodes. Returns the
+ * number of nodes taken, which is less than k only if the heap ran empty.
+ * See heap_take_many().
+ */
+static inline size_t iheap_take_many(struct iheap* heap,
+				     struct iheap_node** nodes, size_t k)
+{
+	struct iheap_node* frontier[IHEAP_TAKE_MANY_BATCH];
+	struct iheap_node* trees[HEAP_MAX_DEGREE];
+	struct iheap_node *pos, *next, *node;
+	size_t n, i;
+	size_t taken = 0;
+
+	if (k < IHEAP_TAKE_MANY_MIN) {
+		while (taken < k && (nodes[taken] = iheap_take(heap)))
+			taken++;
+		return taken;
+	}
+	if (heap->min) {
+		__HEAP_STAT(heap, min_hits, 1);
+		nodes[taken++] = heap->min;
+		heap->min->degree = NOT_IN_HEAP;
+		heap->min = NULL;
+	}
+	while (taken < k && heap->head) {
+		__HEAP_STAT(heap, min_misses, 1);
+		if (heap->lazy)
+			__iheap_consolidate(heap);
+		n = 0;
+		for (pos = heap->head; pos; pos = pos->next)
+			__iheap_frontier_push(heap, frontier, &n, pos);
+		/* stop early if the children of the next node do not fit */
+		while (taken < k && n &&
+		       n - 1 + frontier[0]->degree <= IHEAP_TAKE_MANY_BATCH) {
+			node = __iheap_frontier_pop(heap, frontier, &n);
+			for (pos = node->child; pos; pos = next) {
+				next = pos->next;
+				pos->parent = NULL;
+				__iheap_frontier_push(heap, frontier, &n, pos);
+			}
+			node->degree = NOT_IN_HEAP;
+			nodes[taken++] = node;
+		}
+		/* every candidate is the root of an intact tree */
+		for (i = 0; i < HEAP_MAX_DEGREE; i++)
+			trees[i] = NULL;
+		for (i = 0; i < n; i++)
+			__iheap_carry(heap, trees, frontier[i], 0);
+		__iheap_set_roots(heap,
+				  __iheap_collect(trees, HEAP_MAX_DEGREE));
+	}
+	return taken;
+}
+
+/* Remove node from the heap without moving any other node. Each ancestor of
+ * node keeps only its children of lower degree than the next node on the path
+ * down to node; its other children become roots. The pieces are binomial
+ * trees of distinct degrees, returned as a root list ordered by degree.
+ *
+ * The root list is scanned for node's root, so a lazy heap must be
+ * consolidated first; see __iheap_cut_out().
+ */
+static inline struct iheap_node* __iheap_cut(struct iheap* heap,
+					     struct iheap_node* node)
+{
+	struct iheap_node* path[HEAP_MAX_DEGREE];
+	struct iheap_node *head = NULL, *root, *down, *pos, *next, *prev;
+	unsigned int depth = 0;
+
+	for (root = node; root->parent; root = root->parent)
+		path[depth++] = root;
+	__HEAP_STAT(heap, bubble_depth, depth);
+	prev = NULL;
+	for (pos = heap->head; pos != root; pos = pos->next)
+		prev = pos;
+	__iheap_remove_root(heap, prev, root);
+	while (depth--) {
+		down = path[depth];
+		/* children are ordered by decreasing degree */
+		for (pos = root->child; pos != down; pos = next) {
+			next        = pos->next;
+			pos->parent = NULL;
+			pos->next   = head;
+			head        = pos;
+		}
+		root->child  = down->next;
+		root->degree = down->degree;
+		root->next   = head;
+		head         = root;
+		down->parent = NULL;
+		root         = down;
+	}
+	for (pos = node->child; pos; pos = next) {
+		next        = pos->next;
+		pos->parent = NULL;
+		pos->next   = head;
+		head        = pos;
+	}
+	return head;
+}
+
+/* remove node and put the remaining pieces of its tree back */
+static inline void __iheap_cut_out(struct iheap* heap, struct iheap_node* node)
+{
+	if (heap->lazy)
+		__iheap_consolidate(heap);
+	__iheap_add_roots(heap, __iheap_cut(heap, node));
+}
+
+/* Like iheap_decrease(), but instead of exchanging values with its ancestors,
+ * node is cut out of its tree and inserted again; its subtrees and the rest
+ * of the tree are added to the root list. Hence, node does not need a ref and
+ * the caller's pointer to it remains valid. The cut writes O(log n) pointers
+ * in total, and only if node actually has to move.
+ *
+ * Values only stay put if every decrease, increase and delete on the heap
+ * relinks; iheap_decrease(), iheap_increase() and iheap_delete() do so for
+ * nodes without a ref.
+ */
+static inline void iheap_decrease_relink(struct iheap* heap,
+					 struct iheap_node* node, int new_key)
+{
+	if (new_key >= node->key)
+		return;
+	node->key = new_key;
+	if (heap->min == node)
+		return;
+	if (node->parent && __iheap_less(heap, node, node->parent)) {
+		__iheap_cut_out(heap, node);
+		/* swaps the min cache if necessary */
+		iheap_insert(heap, node);
+	} else if (heap->min && __iheap_less(heap, node, heap->min))
+		__iheap_uncache_min(heap);
+}
+
+/* Like iheap_delete(), but node's tree is taken apart instead of bubbling node
+ * up to the root.
+ */
+static inline void iheap_delete_relink(struct iheap* heap,
+				       struct iheap_node* node)
+{
+	if (heap->min != node)
+		__iheap_cut_out(heap, node);
+	else
+		heap->min = NULL;
+	node->degree = NOT_IN_HEAP;
+}
+
 static inline void iheap_decrease(struct iheap* heap, struct iheap_node* node,
 				  int new_key)
 {
@@ -301,15 +728,19 @@ static inline void iheap_decrease(struct iheap* heap, struct iheap_node* node,
 	int   tmp_key;
 
 	/* node's priority was decreased, we need to update its position */
-	if (!node->ref || new_key >= node->key)
+	if (!node->ref) {
+		iheap_decrease_relink(heap, node, new_key);
+		return;
+	}
+	if (new_key >= node->key)
 		return;
 	node->key = new_key;
 	if (heap->min != node) {
-		if (heap->min && node->key < heap->min->key)
+		if (heap->min && __iheap_less(heap, node, heap->min))
 			__iheap_uncache_min(heap);
 		/* bubble up */
 		parent = node->parent;
-		while (parent && node->key < parent->key) {
+		while (parent && __iheap_less(heap, node, parent)) {
 			/* swap parent and node */
 			tmp           = parent->value;
 			tmp_key       = parent->key;
@@ -327,6 +758,7 @@ static inline void iheap_decrease(struct iheap* heap, struct iheap_node* node,
 			/* step up */
 			node   = parent;
 			parent = node->parent;
+			__HEAP_STAT(heap, bubble_depth, 1);
 		}
 	}
 }
@@ -338,9 +770,15 @@ static inline void iheap_delete(struct iheap* heap, struct iheap_node* node)
 	const void* tmp;
 	int tmp_key;
 
-	if (!node->ref) /* can only delete if we have a reference */
+	/* without a reference, node itself has to move */
+	if (!node->ref) {
+		iheap_delete_relink(heap, node);
 		return;
+	}
 	if (heap->min != node) {
+		/* finding node's root below needs a short root list */
+		if (heap->lazy)
+			__iheap_consolidate(heap);
 		/* bubble up */
 		parent = node->parent;
 		while (parent) {
@@ -361,6 +799,7 @@ static inline void iheap_delete(struct iheap* heap, struct iheap_node* node)
 			/* step up */
 			node   = parent;
 			parent = node->parent;
+			__HEAP_STAT(heap, bubble_depth, 1);
 		}
 		/* now delete:
 		 * first find prev */
@@ -371,14 +810,95 @@ static inline void iheap_delete(struct iheap* heap, struct iheap_node* node)
 			pos  = pos->next;
 		}
 		/* we have prev, now remove node */
-		if (prev)
-			prev->next = node->next;
-		else
-			heap->head = node->next;
-		__iheap_union(heap, __iheap_reverse(node->child));
+		__iheap_remove_root(heap, prev, node);
+		__iheap_add_roots(heap, __iheap_reverse(node->child));
 	} else
 		heap->min = NULL;
 	node->degree = NOT_IN_HEAP;
 }
 
+/* child of node with the smallest key, or NULL */
+static inline struct iheap_node* __iheap_min_child(struct iheap* heap,
+						   struct iheap_node* node)
+{
+	struct iheap_node *min = node->child, *pos;
+	if (min)
+		for (pos = min->next; pos; pos = pos->next)
+			if (__iheap_less(heap, pos, min))
+				min = pos;
+	return min;
+}
+
+/* Like iheap_increase(), but instead of exchanging values with its
+ * descendants, node is cut out of its tree and inserted again, as in
+ * iheap_decrease_relink().
+ */
+static inline void iheap_increase_relink(struct iheap* heap,
+					 struct iheap_node* node, int new_key)
+{
+	struct iheap_node* child;
+
+	if (new_key <= node->key)
+		return;
+	node->key = new_key;
+	if (heap->min == node) {
+		/* the cached minimum has no children; just insert it again */
+		__iheap_uncache_min(heap);
+		return;
+	}
+	child = __iheap_min_child(heap, node);
+	if (child && __iheap_less(heap, child, node)) {
+		__iheap_cut_out(heap, node);
+		iheap_insert(heap, node);
+	}
+}
+
+/* Raise node's key to new_key. Node sinks within its tree, trading places
+ * with its smallest child as long as that child is smaller. Each level scans
+ * the children, so this costs O(log^2 n) comparisons in the worst case, but
+ * most nodes sit near the bottom of their trees and only move a few levels,
+ * whereas iheap_delete() and iheap_insert() always go up to the root list.
+ */
+static inline void iheap_increase(struct iheap* heap, struct iheap_node* node,
+				  int new_key)
+{
+	struct iheap_node *child;
+	struct iheap_node** tmp_ref;
+	const void* tmp;
+	int   tmp_key;
+
+	if (!node->ref) {
+		iheap_increase_relink(heap, node, new_key);
+		return;
+	}
+	if (new_key <= node->key)
+		return;
+	node->key = new_key;
+	if (heap->min == node) {
+		__iheap_uncache_min(heap);
+		return;
+	}
+	/* sift down */
+	while ((child = __iheap_min_child(heap, node)) &&
+	       __iheap_less(heap, child, node)) {
+		/* swap child and node */
+		tmp          = child->value;
+		tmp_key      = child->key;
+		child->value = node->value;
+		child->key   = node->key;
+		node->value  = tmp;
+		node->key    = tmp_key;
+		/* swap references */
+		if (child->ref)
+			*(child->ref) = node;
+		*(node->ref)  = child;
+		tmp_ref       = child->ref;
+		child->ref    = node->ref;
+		node->ref     = tmp_ref;
+		/* step down */
+		node = child;
+		__HEAP_STAT(heap, bubble_depth, 1);
+	}
+}
+
 #endif /* HEAP_H */
@@ -0,0 +1,231 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+
+#include "heap.h"
+#include "iheap.h"
+
+/* Raise (and now and then lower) the keys of random nodes, take a node every
+ * few steps, and check that each taken key is the smallest one left. Runs
+ * with and without refs, i.e., on the value-exchange path and on the relink
+ * path, and on eager and lazy heaps.
+ */
+
+#define N	1000
+#define STEPS	4000
+
+struct item {
+	int key;
+	int in_heap;
+	struct heap_node* node;
+};
+
+static struct item items[N];
+
+static int item_less(struct heap_node* a, struct heap_node* b)
+{
+	return ((struct item*) heap_node_value(a))->key <
+	       ((struct item*) heap_node_value(b))->key;
+}
+
+static int min_key(void)
+{
+	int i, min = INT_MAX;
+	for (i = 0; i < N; i++)
+		if (items[i].in_heap && items[i].key < min)
+			min = items[i].key;
+	return min;
+}
+
+/* random item that is still in the heap, or NULL */
+static struct item* pick(void)
+{
+	int i, start = rand() % N;
+	for (i = 0; i < N; i++)
+		if (items[(start + i) % N].in_heap)
+			return &items[(start + i) % N];
+	return NULL;
+}
+
+static int check_take(struct item* it, int expected)
+{
+	if (!it || it->key != expected) {
+		fprintf(stderr, "inctest: took %d, expected %d\n",
+			it ? it->key : INT_MAX, expected);
+		return 1;
+	}
+	return 0;
+}
+
+static int test_heap(int lazy, int refs)
+{
+	struct heap heap;
+	struct heap_node* hn;
+	struct item* it;
+	int i, err = 0;
+
+	if (lazy)
+		heap_init_lazy(&heap);
+	else
+		heap_init(&heap);
+	for (i = 0; i < N; i++) {
+		it = &items[i];
+		it->key     = rand() % N;
+		it->in_heap = 1;
+		it->node    = malloc(sizeof(struct heap_node));
+		if (refs)
+			heap_node_init_ref(&it->node, it);
+		else
+			heap_node_init(it->node, it);
+		heap_insert(item_less, &heap, it->node);
+	}
+	for (i = 0; i < STEPS && !err; i++) {
+		/* every so often, raise the cached minimum */
+		if (i % 7 == 0)
+			it = heap_node_value(heap_peek(item_less, &heap));
+		else
+			it = pick();
+		if (i % 5 == 0) {
+			it->key -= rand() % N;
+			heap_decrease(item_less, &heap, it->node);
+		} else {
+			it->key += rand() % N;
+			if (refs)
+				heap_increase(item_less, &heap, it->node);
+			else
+				heap_increase_relink(item_less, &heap,
+						     it->node);
+		}
+		if (heap_node_value(it->node) != it) {
+			fprintf(stderr, "inctest: stale ref\n");
+			err = 1;
+		}
+		if (i % 10 == 9) {
+			hn = heap_take(item_less, &heap);
+			it = hn ? heap_node_value(hn) : NULL;
+			if (check_take(it, min_key()))
+				return 1;
+			it->in_heap = 0;
+		}
+	}
+	while (!err && (hn = heap_take(item_less, &heap))) {
+		it = heap_node_value(hn);
+		err = check_take(it, min_key());
+		it->in_heap = 0;
+	}
+	if (!err && pick()) {
+		fprintf(stderr, "inctest: heap ran empty too early\n");
+		err = 1;
+	}
+	for (i = 0; i < N; i++)
+		free(items[i].node);
+	return err;
+}
+
+struct slot {
+	int in_heap;
+	struct iheap_node* node;
+};
+
+static struct slot slots[N];
+
+static int min_ikey(void)
+{
+	int i, min = INT_MAX;
+	for (i = 0; i < N; i++)
+		if (slots[i].in_heap && slots[i].node->key < min)
+			min = slots[i].node->key;
+	return min;
+}
+
+static struct slot* pick_slot(void)
+{
+	int i, start = rand() % N;
+	for (i = 0; i < N; i++)
+		if (slots[(start + i) % N].in_heap)
+			return &slots[(start + i) % N];
+	return NULL;
+}
+
+static int check_itake(struct iheap_node* hn, int expected)
+{
+	if (!hn || hn->key != expected) {
+		fprintf(stderr, "inctest: took %d, expected %d\n",
+			hn ? hn->key : INT_MAX, expected);
+		return 1;
+	}
+	return 0;
+}
+
+static int test_iheap(int lazy, int refs)
+{
+	struct iheap heap;
+	struct iheap_node* hn;
+	struct slot* s;
+	int i, err = 0;
+
+	if (lazy)
+		iheap_init_lazy(&heap);
+	else
+		iheap_init(&heap);
+	for (i = 0; i < N; i++) {
+		s = &slots[i];
+		s->in_heap = 1;
+		s->node    = malloc(sizeof(struct iheap_node));
+		if (refs)
+			iheap_node_init_ref(&s->node, rand() % N, s);
+		else
+			iheap_node_init(s->node, rand() % N, s);
+		iheap_insert(&heap, s->node);
+	}
+	for (i = 0; i < STEPS && !err; i++) {
+		if (i % 7 == 0)
+			s = (struct slot*) iheap_node_value(iheap_peek(&heap));
+		else
+			s = pick_slot();
+		if (i % 5 == 0)
+			iheap_decrease(&heap, s->node,
+				       s->node->key - rand() % N);
+		else if (refs)
+			iheap_increase(&heap, s->node,
+				       s->node->key + rand() % N);
+		else
+			iheap_increase_relink(&heap, s->node,
+					      s->node->key + rand() % N);
+		if (iheap_node_value(s->node) != s) {
+			fprintf(stderr, "inctest: stale iheap ref\n");
+			err = 1;
+		}
+		if (i % 10 == 9) {
+			hn = iheap_take(&heap);
+			if (check_itake(hn, min_ikey()))
+				return 1;
+			s = (struct slot*) iheap_node_value(hn);
+			s->in_heap = 0;
+		}
+	}
+	while (!err && (hn = iheap_take(&heap))) {
+		err = check_itake(hn, min_ikey());
+		s = (struct slot*) iheap_node_value(hn);
+		s->in_heap = 0;
+	}
+	if (!err && pick_slot()) {
+		fprintf(stderr, "inctest: iheap ran empty too early\n");
+		err = 1;
+	}
+	for (i = 0; i < N; i++)
+		free(slots[i].node);
+	return err;
+}
+
+int main(int argc __attribute__((unused)), char** argv __attribute__((unused)))
+{
+	int lazy, refs;
+
+	srand(1);
+	for (lazy = 0; lazy < 2; lazy++)
+		for (refs = 0; refs < 2; refs++)
+			if (test_heap(lazy, refs) || test_iheap(lazy, refs))
+				return 1;
+	return 0;
+}
@@ -0,0 +1,254 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "heap_iter.h"
+
+/* Iterate over heaps with distinct random keys, lazy and eager, after some
+ * takes and with a cached minimum. Every node must come out exactly once
+ * and in key order, and the heap must not change: the nodes from
+ * peek_many() must be the nodes that the takes return afterwards. With
+ * HEAP_STATS, iterating must not count any comparisons.
+ */
+
+#ifdef HEAP_STATS
+#define NAME		"sittest"
+#define COMPARES(h)	((h).stats.compares)
+#else
+#define NAME		"ittest"
+#define COMPARES(h)	0UL
+#endif
+
+#define N	1000
+#define TAKEN	(N / 4)
+#define PEEKED	(N / 3)
+
+struct item {
+	int key;
+	int seen;
+};
+
+static struct item items[N];
+static struct heap_node hnodes[N];
+static struct iheap_node inodes[N];
+static struct heap_node* hpeeked[N];
+static struct iheap_node* ipeeked[N];
+static int keys[N];
+
+static int item_less(struct heap_node* a, struct heap_node* b)
+{
+	return ((struct item*) heap_node_value(a))->key <
+	       ((struct item*) heap_node_value(b))->key;
+}
+
+static int int_cmp(const void* a, const void* b)
+{
+	int x = *(const int*) a, y = *(const int*) b;
+	return (x > y) - (x < y);
+}
+
+/* Distinct random keys, sorted into keys[]. Without ties, the order of the
+ * nodes is unique.
+ */
+static void make_items(void)
+{
+	int i, j, tmp;
+	for (i = 0; i < N; i++)
+		keys[i] = 3 * i - N;
+	for (i = N - 1; i > 0; i--) {
+		j = rand() % (i + 1);
+		tmp = keys[i];
+		keys[i] = keys[j];
+		keys[j] = tmp;
+	}
+	for (i = 0; i < N; i++) {
+		items[i].key  = keys[i];
+		items[i].seen = 0;
+	}
+	qsort(keys, N, sizeof(int), int_cmp);
+}
+
+/* the i-th node yielded must be new and have the i-th smallest key left */
+static int check_next(struct item* it, int i)
+{
+	if (it->seen || it->key != keys[TAKEN + i]) {
+		fprintf(stderr, NAME ": yielded %d, expected %d\n",
+			it->key, keys[TAKEN + i]);
+		return 1;
+	}
+	it->seen = 1;
+	return 0;
+}
+
+static int test_heap(int lazy)
+{
+	struct heap heap;
+	struct heap_iter iter;
+	struct heap_node* hn;
+	struct item* it;
+	unsigned long compares;
+	int i;
+
+	make_items();
+	if (lazy)
+		heap_init_lazy(&heap);
+	else
+		heap_init(&heap);
+	for (i = 0; i < N; i++) {
+		heap_node_init(hnodes + i, items + i);
+		heap_insert(item_less, &heap, hnodes + i);
+	}
+	for (i = 0; i < TAKEN; i++)
+		heap_take(item_less, &heap);
+	/* the cached minimum is not part of the trees */
+	heap_peek(item_less, &heap);
+	compares = COMPARES(heap);
+
+	if (heap_iter_init(&iter, item_less, &heap))
+		return 1;
+	for (i = 0; (hn = heap_iter_next(&iter)); i++)
+		if (check_next(heap_node_value(hn), i))
+			return 1;
+	heap_iter_destroy(&iter);
+	if (iter.error || i != N - TAKEN) {
+		fprintf(stderr, NAME ": yielded %d of %d nodes\n",
+			i, N - TAKEN);
+		return 1;
+	}
+
+	/* iterating must not have changed the heap */
+	if (heap_peek_many(item_less, &heap, hpeeked, PEEKED) != PEEKED)
+		return 1;
+	if (COMPARES(heap) != compares) {
+		fprintf(stderr, NAME ": iterating counted compares\n");
+		return 1;
+	}
+	for (i = 0; i < N - TAKEN; i++) {
+		hn = heap_take(item_less, &heap);
+		it = hn ? heap_node_value(hn) : NULL;
+		if (!it || (i < PEEKED && hn != hpeeked[i]) ||
+		    it->key != keys[TAKEN + i]) {
+			fprintf(stderr, NAME ": heap changed at node %d\n",
+				i);
+			return 1;
+		}
+	}
+	if (!heap_empty(&heap)) {
+		fprintf(stderr, NAME ": heap not empty\n");
+		return 1;
+	}
+	return 0;
+}
+
+static int test_iheap(int lazy)
+{
+	struct iheap heap;
+	struct iheap_iter iter;
+	struct iheap_node* hn;
+	unsigned long compares;
+	int i;
+
+	make_items();
+	if (lazy)
+		iheap_init_lazy(&heap);
+	else
+		iheap_init(&heap);
+	for (i = 0; i < N; i++) {
+		iheap_node_init(inodes + i, items[i].key, items + i);
+		iheap_insert(&heap, inodes + i);
+	}
+	for (i = 0; i < TAKEN; i++)
+		iheap_take(&heap);
+	iheap_peek(&heap);
+	compares = COMPARES(heap);
+
+	if (iheap_iter_init(&iter, &heap))
+		return 1;
+	for (i = 0; (hn = iheap_iter_next(&iter)); i++)
+		if (check_next((struct item*) iheap_node_value(hn), i))
+			return 1;
+	iheap_iter_destroy(&iter);
+	if (iter.error || i != N - TAKEN) {
+		fprintf(stderr, NAME ": yielded %d of %d inodes\n",
+			i, N - TAKEN);
+		return 1;
+	}
+
+	if (iheap_peek_many(&heap, ipeeked, PEEKED) != PEEKED)
+		return 1;
+	if (COMPARES(heap) != compares) {
+		fprintf(stderr, NAME ": iterating counted compares\n");
+		return 1;
+	}
+	for (i = 0; i < N - TAKEN; i++) {
+		hn = iheap_take(&heap);
+		if (!hn || (i < PEEKED && hn != ipeeked[i]) ||
+		    hn->key != keys[TAKEN + i]) {
+			fprintf(stderr, NAME ": iheap changed at node %d\n",
+				i);
+			return 1;
+		}
+	}
+	if (!iheap_empty(&heap)) {
+		fprintf(stderr, NAME ": iheap not empty\n");
+		return 1;
+	}
+	return 0;
+}
+
+/* an empty heap yields nothing, and an iterator may stop early */
+static int test_edges(void)
+{
+	struct heap heap;
+	struct iheap iheap;
+	struct heap_iter iter;
+	struct iheap_iter iiter;
+	int i;
+
+	heap_init(&heap);
+	iheap_init(&iheap);
+	if (heap_iter_init(&iter, item_less, &heap) ||
+	    iheap_iter_init(&iiter, &iheap))
+		return 1;
+	if (heap_iter_next(&iter) || iheap_iter_next(&iiter) ||
+	    heap_peek_many(item_less, &heap, hpeeked, PEEKED) ||
+	    iheap_peek_many(&iheap, ipeeked, PEEKED)) {
+		fprintf(stderr, NAME ": empty heap yielded a node\n");
+		return 1;
+	}
+	heap_iter_destroy(&iter);
+	iheap_iter_destroy(&iiter);
+
+	make_items();
+	for (i = 0; i < N; i++) {
+		heap_node_init(hnodes + i, items + i);
+		heap_insert(item_less, &heap, hnodes + i);
+		iheap_node_init(inodes + i, items[i].key, items + i);
+		iheap_insert(&iheap, inodes + i);
+	}
+	if (heap_iter_init(&iter, item_less, &heap) ||
+	    iheap_iter_init(&iiter, &iheap))
+		return 1;
+	for (i = 0; i < 10; i++)
+		if (!heap_iter_next(&iter) || !iheap_iter_next(&iiter))
+			return 1;
+	heap_iter_destroy(&iter);
+	iheap_iter_destroy(&iiter);
+	if (iter.front || iiter.front || iter.n || iiter.n) {
+		fprintf(stderr, NAME ": iterator not destroyed\n");
+		return 1;
+	}
+	return 0;
+}
+
+int main(int argc __attribute__((unused)), char** argv __attribute__((unused)))
+{
+	int lazy;
+
+	srand(1);
+	if (test_edges())
+		return 1;
+	for (lazy = 0; lazy < 2; lazy++)
+		if (test_heap(lazy) || test_iheap(lazy))
+			return 1;
+	return 0;
+}
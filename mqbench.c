@@ -0,0 +1,347 @@
+/* mqbench.c -- scalability of multiqueue.h
+ *
+ * Usage: mqbench [-t threads] [-c shards per thread] [-n size] [-o ops]
+ *                [-r rank ops] [-b rebalance period] [-s seed]
+ *
+ * Runs the hold model (take the minimum, re-insert it with a slightly larger
+ * key) on a queue of n elements with 1, 2, 4, ... threads, up to the given
+ * number of threads (default: the number of online CPUs). For every thread
+ * count, it measures
+ *   - a single iheap behind one lock (a MultiQueue with a single shard), and
+ *   - a MultiQueue with c shards per thread.
+ *
+ * Each configuration runs twice. The first run reports throughput. The second
+ * run logs a timestamp for every operation, using fewer operations per thread
+ * (-r). The logs are then replayed in timestamp order to get the rank error
+ * of each take, i.e., the number of queued keys smaller than the key that
+ * was taken.
+ *
+ * With -b, every thread calls multiqueue_rebalance() after each period
+ * operations.
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "multiqueue.h"
+
+struct config {
+	unsigned int	threads;
+	unsigned int	shards;
+	unsigned long	n;
+	unsigned long	ops;
+	unsigned long	rank_ops;
+	unsigned long	period;
+	unsigned int	seed;
+};
+
+enum { EV_INSERT, EV_TAKE };
+
+struct event {
+	uint64_t	ts;
+	int		key;
+	int		kind;
+};
+
+struct worker {
+	pthread_t		thread;
+	struct multiqueue*	mq;
+	unsigned long		ops;
+	unsigned long		period;
+	unsigned int		seed;
+	/* NULL unless ranks are measured */
+	struct event*		log;
+	unsigned long		logged;
+	int*			start;
+	uint64_t		t0;
+	uint64_t		t1;
+	unsigned long		checksum;
+};
+
+static uint64_t now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+}
+
+static void record(struct worker* w, int kind, int key)
+{
+	struct event* ev = w->log + w->logged++;
+	ev->ts   = now();
+	ev->key  = key;
+	ev->kind = kind;
+}
+
+static void* hold(void* arg)
+{
+	struct worker* w = (struct worker*) arg;
+	struct iheap_node* node;
+	unsigned long i;
+	int key;
+
+	while (!__atomic_load_n(w->start, __ATOMIC_ACQUIRE))
+		;
+	w->t0 = now();
+	for (i = 0; i < w->ops; i++) {
+		node = multiqueue_take(w->mq, &w->seed);
+		if (!node)
+			break;
+		if (w->log)
+			record(w, EV_TAKE, node->key);
+		w->checksum += (unsigned long) node->key;
+		key = node->key + 1 + (int) (__mq_rand(&w->seed) % 64);
+		node->key = key;
+		/* another thread may take node as soon as it is queued */
+		multiqueue_insert(w->mq, node, &w->seed);
+		if (w->log)
+			record(w, EV_INSERT, key);
+		if (w->period && (i + 1) % w->period == 0)
+			multiqueue_rebalance(w->mq, &w->seed);
+	}
+	w->t1 = now();
+	return NULL;
+}
+
+static int event_cmp(const void* _a, const void* _b)
+{
+	const struct event *a = _a, *b = _b;
+	return a->ts < b->ts ? -1 : a->ts > b->ts;
+}
+
+static int int_cmp(const void* _a, const void* _b)
+{
+	const int *a = _a, *b = _b;
+	return *a < *b ? -1 : *a > *b;
+}
+
+/* index of key in the sorted array keys */
+static unsigned long key_index(const int* keys, unsigned long n, int key)
+{
+	unsigned long lo = 0, hi = n;
+	while (lo < hi) {
+		unsigned long mid = lo + (hi - lo) / 2;
+		if (keys[mid] < key)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+/* Fenwick tree of key counts, over indices 1..n */
+static void fenwick_add(long* tree, unsigned long n, unsigned long i, long d)
+{
+	for (i++; i <= n; i += i & -i)
+		tree[i] += d;
+}
+
+static long fenwick_sum(const long* tree, unsigned long i)
+{
+	long sum = 0;
+	for (; i; i -= i & -i)
+		sum += tree[i];
+	return sum;
+}
+
+/* Replay the logs in timestamp order. initial holds the prefilled keys. */
+static void rank_error(struct worker* w, unsigned int threads,
+		       const int* initial, unsigned long n,
+		       double* mean, long* max)
+{
+	struct event* all;
+	int* keys;
+	long* tree;
+	unsigned long total = 0, nkeys, takes = 0, i, j, idx;
+	long rank;
+	double sum = 0;
+
+	for (i = 0; i < threads; i++)
+		total += w[i].logged;
+	all  = malloc(sizeof(struct event) * (total ? total : 1));
+	keys = malloc(sizeof(int) * (total + n));
+	for (i = 0, j = 0; i < threads; i++) {
+		memcpy(all + j, w[i].log, sizeof(struct event) * w[i].logged);
+		j += w[i].logged;
+	}
+	qsort(all, total, sizeof(struct event), event_cmp);
+	/* compress the keys */
+	memcpy(keys, initial, sizeof(int) * n);
+	for (i = 0; i < total; i++)
+		keys[n + i] = all[i].key;
+	qsort(keys, total + n, sizeof(int), int_cmp);
+	for (i = 1, nkeys = 1; i < total + n; i++)
+		if (keys[i] != keys[nkeys - 1])
+			keys[nkeys++] = keys[i];
+	tree = calloc(nkeys + 1, sizeof(long));
+
+	for (i = 0; i < n; i++)
+		fenwick_add(tree, nkeys, key_index(keys, nkeys, initial[i]), 1);
+	*max = 0;
+	for (i = 0; i < total; i++) {
+		idx = key_index(keys, nkeys, all[i].key);
+		if (all[i].kind == EV_INSERT) {
+			fenwick_add(tree, nkeys, idx, 1);
+			continue;
+		}
+		/* queued keys that are smaller than the one taken */
+		rank = fenwick_sum(tree, idx);
+		fenwick_add(tree, nkeys, idx, -1);
+		sum += (double) rank;
+		if (rank > *max)
+			*max = rank;
+		takes++;
+	}
+	*mean = takes ? sum / (double) takes : 0;
+	free(tree);
+	free(keys);
+	free(all);
+}
+
+static unsigned long checksum;
+
+/* returns million operations per second (a take and an insert each) */
+static double run(const struct config* cfg, unsigned int threads,
+		  unsigned int shards, unsigned long ops, int ranks,
+		  double* mean, long* max)
+{
+	struct multiqueue mq;
+	struct iheap_node* nodes;
+	struct worker* w;
+	int* initial;
+	int start = 0;
+	unsigned int seed = cfg->seed, i;
+	unsigned long j, done = 0;
+	uint64_t t0 = UINT64_MAX, t1 = 0;
+
+	if (multiqueue_init(&mq, shards)) {
+		fprintf(stderr, "out of memory\n");
+		exit(1);
+	}
+	nodes   = malloc(sizeof(struct iheap_node) * cfg->n);
+	initial = malloc(sizeof(int) * cfg->n);
+	w       = calloc(threads, sizeof(struct worker));
+	if (!nodes || !initial || !w) {
+		fprintf(stderr, "out of memory\n");
+		exit(1);
+	}
+	for (j = 0; j < cfg->n; j++) {
+		initial[j] = (int) (__mq_rand(&seed) % (cfg->n * 4 + 1));
+		iheap_node_init(nodes + j, initial[j], NULL);
+		multiqueue_insert(&mq, nodes + j, &seed);
+	}
+	for (i = 0; i < threads; i++) {
+		w[i].mq     = &mq;
+		w[i].ops    = ops;
+		w[i].period = cfg->period;
+		w[i].seed   = cfg->seed + 1 + i;
+		w[i].start  = &start;
+		if (ranks) {
+			w[i].log = malloc(sizeof(struct event) * 2 * ops);
+			if (!w[i].log) {
+				fprintf(stderr, "out of memory\n");
+				exit(1);
+			}
+		}
+		pthread_create(&w[i].thread, NULL, hold, w + i);
+	}
+	__atomic_store_n(&start, 1, __ATOMIC_RELEASE);
+	for (i = 0; i < threads; i++) {
+		pthread_join(w[i].thread, NULL);
+		if (w[i].t0 < t0)
+			t0 = w[i].t0;
+		if (w[i].t1 > t1)
+			t1 = w[i].t1;
+		done     += ops;
+		checksum += w[i].checksum;
+	}
+	if (ranks)
+		rank_error(w, threads, initial, cfg->n, mean, max);
+	for (i = 0; i < threads; i++)
+		free(w[i].log);
+	free(w);
+	free(initial);
+	free(nodes);
+	multiqueue_destroy(&mq);
+	return (double) done * 1000.0 / (double) (t1 - t0);
+}
+
+static void report(const struct config* cfg, const char* name,
+		   unsigned int threads, unsigned int shards)
+{
+	double mops, mean;
+	long max;
+
+	mops = run(cfg, threads, shards, cfg->ops, 0, NULL, NULL);
+	run(cfg, threads, shards, cfg->rank_ops, 1, &mean, &max);
+	printf("%-8s %7u %7u %10.2f %11.1f %9ld\n",
+	       name, threads, shards, mops, mean, max);
+	fflush(stdout);
+}
+
+static void usage(const char* prog)
+{
+	fprintf(stderr,
+		"usage: %s [-t threads] [-c shards per thread] [-n size] "
+		"[-o ops] [-r rank ops] [-b rebalance period] [-s seed]\n",
+		prog);
+	exit(1);
+}
+
+int main(int argc, char** argv)
+{
+	struct config cfg;
+	unsigned int t;
+	long cpus;
+	int i;
+
+	cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	cfg.threads  = cpus > 0 ? (unsigned int) cpus : 1;
+	cfg.shards   = 2;
+	cfg.n        = 1000000;
+	cfg.ops      = 1000000;
+	cfg.rank_ops = 100000;
+	cfg.period   = 0;
+	cfg.seed     = 42;
+	for (i = 1; i < argc; i++) {
+		if (i + 1 == argc)
+			usage(argv[0]);
+		if (!strcmp(argv[i], "-t"))
+			cfg.threads = (unsigned int) atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-c"))
+			cfg.shards = (unsigned int) atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-n"))
+			cfg.n = (unsigned long) atof(argv[++i]);
+		else if (!strcmp(argv[i], "-o"))
+			cfg.ops = (unsigned long) atof(argv[++i]);
+		else if (!strcmp(argv[i], "-r"))
+			cfg.rank_ops = (unsigned long) atof(argv[++i]);
+		else if (!strcmp(argv[i], "-b"))
+			cfg.period = (unsigned long) atof(argv[++i]);
+		else if (!strcmp(argv[i], "-s"))
+			cfg.seed = (unsigned int) strtoul(argv[++i], NULL, 0);
+		else
+			usage(argv[0]);
+	}
+	if (!cfg.threads || !cfg.shards || !cfg.n || !cfg.seed)
+		usage(argv[0]);
+
+	printf("%-8s %7s %7s %10s %11s %9s\n",
+	       "queue", "threads", "shards", "Mops/s", "mean rank", "max rank");
+	for (t = 1; ; t *= 2) {
+		if (t > cfg.threads)
+			t = cfg.threads;
+		report(&cfg, "locked", t, 1);
+		report(&cfg, "mq", t, cfg.shards * t);
+		if (t == cfg.threads)
+			break;
+	}
+	fprintf(stderr, "checksum: %lu\n", checksum);
+	return 0;
+}
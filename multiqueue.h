@@ -0,0 +1,325 @@
+/* multiqueue.h -- Relaxed concurrent priority queue on top of iheap.h
+ *
+ * Copyright (c) 2008, Bjoern B. Brandenburg <bbb [at] cs.unc.edu>
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University of North Carolina nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY  COPYRIGHT OWNER AND CONTRIBUTERS ``AS IS'' AND
+ * ANY  EXPRESS OR  IMPLIED  WARRANTIES,  INCLUDING, BUT  NOT  LIMITED TO,  THE
+ * IMPLIED WARRANTIES  OF MERCHANTABILITY AND FITNESS FOR  A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO  EVENT SHALL THE  COPYRIGHT OWNER OR  CONTRIBUTERS BE
+ * LIABLE  FOR  ANY  DIRECT,   INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT  OF
+ * SUBSTITUTE GOODS  OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+ * INTERRUPTION)  HOWEVER CAUSED  AND ON  ANY THEORY  OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR  TORT (INCLUDING  NEGLIGENCE OR  OTHERWISE)
+ * ARISING IN ANY WAY  OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef MULTIQUEUE_H
+#define MULTIQUEUE_H
+
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "iheap.h"
+
+#define MQ_CACHE_LINE	64
+
+/* A MultiQueue: a priority queue for many threads made of several
+ * lock-protected iheaps (shards). Insertions go to a random shard; take()
+ * samples two shards and removes the minimum of the better one. Hence, take()
+ * does not necessarily return the global minimum, but one close to it. With
+ * c shards per thread, the expected rank of a taken key is O(c * threads).
+ *
+ * Each shard publishes the key of its minimum, so sampling needs no locks.
+ * INT_MAX marks an empty shard, so INT_MAX itself must not be used as a key.
+ *
+ * Callers pass a per-thread random state (any value but zero) to all
+ * operations that pick shards.
+ */
+struct mq_shard {
+	pthread_mutex_t		lock;
+	struct iheap		heap;
+	size_t			size;
+	/* key of heap's minimum, read without holding the lock */
+	int			min_key;
+};
+
+struct multiqueue {
+	/* shards are spaced to avoid false sharing */
+	char*			shards;
+	size_t			stride;
+	unsigned int		n;
+	/* as returned by malloc() */
+	void*			mem;
+};
+
+static inline struct mq_shard* mq_shard(struct multiqueue* mq,
+					unsigned int i)
+{
+	return (struct mq_shard*) (mq->shards + i * mq->stride);
+}
+
+/* xorshift32; *seed must not be zero */
+static inline unsigned int __mq_rand(unsigned int* seed)
+{
+	unsigned int x = *seed;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*seed = x;
+	return x;
+}
+
+static inline struct mq_shard* __mq_random(struct multiqueue* mq,
+					   unsigned int* seed)
+{
+	uint64_t r = (uint32_t) __mq_rand(seed);
+	return mq_shard(mq, (unsigned int) ((r * mq->n) >> 32));
+}
+
+static inline int __mq_min_key(struct mq_shard* shard)
+{
+	return __atomic_load_n(&shard->min_key, __ATOMIC_RELAXED);
+}
+
+/* republish the minimum; the shard must be locked */
+static inline void __mq_update(struct mq_shard* shard)
+{
+	struct iheap_node* min = iheap_peek(&shard->heap);
+	__atomic_store_n(&shard->min_key, min ? min->key : INT_MAX,
+			 __ATOMIC_RELAXED);
+}
+
+/* returns 0 on success */
+static inline int multiqueue_init(struct multiqueue* mq, unsigned int shards)
+{
+	struct mq_shard* shard;
+	uintptr_t start;
+	unsigned int i;
+
+	if (!shards)
+		return -1;
+	mq->stride = (sizeof(struct mq_shard) + MQ_CACHE_LINE - 1) &
+		~((size_t) MQ_CACHE_LINE - 1);
+	mq->mem = malloc(mq->stride * shards + MQ_CACHE_LINE);
+	if (!mq->mem)
+		return -1;
+	start = ((uintptr_t) mq->mem + MQ_CACHE_LINE - 1) &
+		~((uintptr_t) MQ_CACHE_LINE - 1);
+	mq->shards = (char*) start;
+	mq->n      = shards;
+	for (i = 0; i < shards; i++) {
+		shard = mq_shard(mq, i);
+		pthread_mutex_init(&shard->lock, NULL);
+		iheap_init(&shard->heap);
+		shard->size    = 0;
+		shard->min_key = INT_MAX;
+	}
+	return 0;
+}
+
+/* Nodes that are still queued are not touched; they belong to the caller. */
+static inline void multiqueue_destroy(struct multiqueue* mq)
+{
+	unsigned int i;
+	for (i = 0; i < mq->n; i++)
+		pthread_mutex_destroy(&mq_shard(mq, i)->lock);
+	free(mq->mem);
+	mq->mem    = NULL;
+	mq->shards = NULL;
+	mq->n      = 0;
+}
+
+static inline void __mq_insert(struct mq_shard* shard,
+			       struct iheap_node* node)
+{
+	iheap_insert(&shard->heap, node);
+	shard->size++;
+	if (node->key < shard->min_key)
+		__atomic_store_n(&shard->min_key, node->key,
+				 __ATOMIC_RELAXED);
+}
+
+static inline void multiqueue_insert(struct multiqueue* mq,
+				     struct iheap_node* node,
+				     unsigned int* seed)
+{
+	struct mq_shard* shard;
+	/* if the shard is busy, try another one */
+	do {
+		shard = __mq_random(mq, seed);
+	} while (pthread_mutex_trylock(&shard->lock));
+	__mq_insert(shard, node);
+	pthread_mutex_unlock(&shard->lock);
+}
+
+/* the shard must be locked */
+static inline struct iheap_node* __mq_take(struct mq_shard* shard)
+{
+	struct iheap_node* node = iheap_take(&shard->heap);
+	if (node) {
+		shard->size--;
+		__mq_update(shard);
+	}
+	return node;
+}
+
+/* visit every shard in turn; NULL if all of them are empty */
+static inline struct iheap_node* __mq_take_any(struct multiqueue* mq)
+{
+	struct mq_shard* shard;
+	struct iheap_node* node;
+	unsigned int i;
+	for (i = 0; i < mq->n; i++) {
+		shard = mq_shard(mq, i);
+		if (__mq_min_key(shard) == INT_MAX)
+			continue;
+		pthread_mutex_lock(&shard->lock);
+		node = __mq_take(shard);
+		pthread_mutex_unlock(&shard->lock);
+		if (node)
+			return node;
+	}
+	return NULL;
+}
+
+/* Returns NULL if the queue appears to be empty. */
+static inline struct iheap_node* multiqueue_take(struct multiqueue* mq,
+						 unsigned int* seed)
+{
+	struct mq_shard *a, *b;
+	struct iheap_node* node;
+	unsigned int misses = 0;
+
+	for (;;) {
+		a = __mq_random(mq, seed);
+		b = __mq_random(mq, seed);
+		if (__mq_min_key(b) < __mq_min_key(a))
+			a = b;
+		if (__mq_min_key(a) == INT_MAX) {
+			/* don't keep sampling a (nearly) empty queue */
+			if (++misses < mq->n)
+				continue;
+			return __mq_take_any(mq);
+		}
+		if (pthread_mutex_trylock(&a->lock))
+			continue;
+		node = __mq_take(a);
+		pthread_mutex_unlock(&a->lock);
+		if (node)
+			return node;
+	}
+}
+
+/* lock two distinct shards in a fixed order */
+static inline void __mq_lock2(struct mq_shard* a, struct mq_shard* b)
+{
+	if (a < b) {
+		pthread_mutex_lock(&a->lock);
+		pthread_mutex_lock(&b->lock);
+	} else {
+		pthread_mutex_lock(&b->lock);
+		pthread_mutex_lock(&a->lock);
+	}
+}
+
+/* move all nodes of shard src to shard dst in O(log n) */
+static inline void multiqueue_merge(struct multiqueue* mq,
+				    unsigned int dst, unsigned int src)
+{
+	struct mq_shard* to   = mq_shard(mq, dst);
+	struct mq_shard* from = mq_shard(mq, src);
+	if (dst == src)
+		return;
+	__mq_lock2(to, from);
+	iheap_union(&to->heap, &from->heap);
+	to->size  += from->size;
+	from->size = 0;
+	__mq_update(to);
+	__mq_update(from);
+	pthread_mutex_unlock(&to->lock);
+	pthread_mutex_unlock(&from->lock);
+}
+
+/* Move roughly half of the nodes of from to to: the largest tree, if there
+ * are others, or else the largest subtree of the only tree. Both shards must
+ * be locked, and from must hold at least two nodes.
+ */
+static inline void __mq_split(struct mq_shard* to, struct mq_shard* from)
+{
+	struct iheap tree;
+	struct iheap_node **pos, **max, *moved;
+
+	/* the cached minimum is not part of any tree */
+	__iheap_uncache_min(&from->heap);
+	max = &from->heap.head;
+	for (pos = max; *pos; pos = &(*pos)->next)
+		if ((*pos)->degree > (*max)->degree)
+			max = pos;
+	if (max == &from->heap.head && !(*max)->next) {
+		/* the first child is the largest subtree */
+		moved = (*max)->child;
+		(*max)->child = moved->next;
+		(*max)->degree--;
+		moved->parent = NULL;
+	} else {
+		moved = *max;
+		*max  = moved->next;
+		/* moved might have been the last root */
+		__iheap_set_roots(&from->heap, from->heap.head);
+	}
+	moved->next = NULL;
+	iheap_init(&tree);
+	__iheap_set_roots(&tree, moved);
+	from->size -= (size_t) 1 << tree.head->degree;
+	to->size   += (size_t) 1 << tree.head->degree;
+	iheap_union(&to->heap, &tree);
+	__mq_update(to);
+	__mq_update(from);
+}
+
+/* Compare two random shards and, if one holds more than twice as many nodes
+ * as the other, move half of its nodes over. Returns 1 if anything moved.
+ */
+static inline int multiqueue_rebalance(struct multiqueue* mq,
+				       unsigned int* seed)
+{
+	struct mq_shard *a, *b, *tmp;
+	int moved = 0;
+
+	a = __mq_random(mq, seed);
+	b = __mq_random(mq, seed);
+	if (a == b)
+		return 0;
+	__mq_lock2(a, b);
+	if (a->size < b->size) {
+		tmp = a;
+		a   = b;
+		b   = tmp;
+	}
+	if (a->size > 2 * b->size + 1) {
+		__mq_split(b, a);
+		moved = 1;
+	}
+	pthread_mutex_unlock(&a->lock);
+	pthread_mutex_unlock(&b->lock);
+	return moved;
+}
+
+#endif /* MULTIQUEUE_H */
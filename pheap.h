@@ -0,0 +1,402 @@
+/* pheap.h -- Pairing heaps behind the heap.h interface
+ *
+ * Copyright (c) 2008, Bjoern B. Brandenburg <bbb [at] cs.unc.edu>
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University of North Carolina nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY  COPYRIGHT OWNER AND CONTRIBUTERS ``AS IS'' AND
+ * ANY  EXPRESS OR  IMPLIED  WARRANTIES,  INCLUDING, BUT  NOT  LIMITED TO,  THE
+ * IMPLIED WARRANTIES  OF MERCHANTABILITY AND FITNESS FOR  A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO  EVENT SHALL THE  COPYRIGHT OWNER OR  CONTRIBUTERS BE
+ * LIABLE  FOR  ANY  DIRECT,   INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT  OF
+ * SUBSTITUTE GOODS  OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+ * INTERRUPTION)  HOWEVER CAUSED  AND ON  ANY THEORY  OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR  TORT (INCLUDING  NEGLIGENCE OR  OTHERWISE)
+ * ARISING IN ANY WAY  OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PHEAP_H
+#define PHEAP_H
+
+/* pheap.h replaces heap.h; only one of them can be used per translation
+ * unit. Define HEAP_PAIRING (e.g., -DHEAP_PAIRING) and include heap.h as
+ * usual to switch a translation unit to pairing heaps without changing any
+ * call site, or include pheap.h directly.
+ */
+#if defined(HEAP_H) && !defined(HEAP_PAIRING)
+#error "heap.h was already included without HEAP_PAIRING"
+#endif
+
+#ifndef HEAP_PAIRING
+#define HEAP_PAIRING
+#endif
+
+#ifndef HEAP_H
+#define HEAP_H
+#endif
+
+#include <stddef.h>
+
+#ifdef HEAP_STATS
+#include "heap_stats.h"
+#define __HEAP_STAT(heap, field, n)	((heap)->stats.field += (n))
+#else
+#define __HEAP_STAT(heap, field, n)	((void) (heap))
+#endif
+
+/* A pairing heap is a single heap-ordered tree in which each node keeps a
+ * list of its children. Insertion and union link two roots with a single
+ * comparison; removing the root pairs up its children from left to right
+ * and then links the pairs from right to left. A decreased node is cut out
+ * of its sibling list and linked with the root, so decrease is O(1) and
+ * nodes never exchange values: a ref always points to its own node.
+ */
+struct heap_node {
+	/* left sibling, or the parent if this is the leftmost child */
+	struct heap_node* 	prev;
+	struct heap_node* 	next;
+	struct heap_node* 	child;
+
+	int			in_heap;
+#ifndef HEAP_INTRUSIVE
+	void*			value;
+	struct heap_node**	ref;
+#endif
+};
+
+/* as in heap.h */
+#define heap_entry(node, type, member) \
+	((type*) ((char*) (node) - offsetof(type, member)))
+
+struct heap {
+	/* the root, which has the highest priority */
+	struct heap_node* 	head;
+#ifdef HEAP_STATS
+	struct heap_stats	stats;
+#endif
+};
+
+/* item comparison function:
+ * return 1 if a has higher prio than b, 0 otherwise
+ */
+typedef int (*heap_prio_t)(struct heap_node* a, struct heap_node* b);
+
+static inline void heap_init(struct heap* heap)
+{
+	heap->head = NULL;
+#ifdef HEAP_STATS
+	heap_stats_reset(&heap->stats);
+#endif
+}
+
+/* pairing heaps are always lazy */
+static inline void heap_init_lazy(struct heap* heap)
+{
+	heap_init(heap);
+}
+
+#ifdef HEAP_INTRUSIVE
+static inline void heap_node_init(struct heap_node* h)
+{
+	h->prev    = NULL;
+	h->next    = NULL;
+	h->child   = NULL;
+	h->in_heap = 0;
+}
+#else
+static inline void heap_node_init_ref(struct heap_node** _h, void* value)
+{
+	struct heap_node* h = *_h;
+	h->prev    = NULL;
+	h->next    = NULL;
+	h->child   = NULL;
+	h->in_heap = 0;
+	h->value   = value;
+	h->ref     = _h;
+}
+
+static inline void heap_node_init(struct heap_node* h, void* value)
+{
+	h->prev    = NULL;
+	h->next    = NULL;
+	h->child   = NULL;
+	h->in_heap = 0;
+	h->value   = value;
+	h->ref     = NULL;
+}
+
+static inline void* heap_node_value(struct heap_node* h)
+{
+	return h->value;
+}
+#endif
+
+static inline int heap_node_in_heap(struct heap_node* h)
+{
+	return h->in_heap;
+}
+
+static inline int heap_empty(struct heap* heap)
+{
+	return heap->head == NULL;
+}
+
+/* all priority comparisons go through here so that they can be counted */
+static inline int __heap_higher(heap_prio_t higher_prio, struct heap* heap,
+				struct heap_node* a, struct heap_node* b)
+{
+	__HEAP_STAT(heap, compares, 1);
+	return higher_prio(a, b);
+}
+
+/* link two roots; the loser becomes the leftmost child of the winner */
+static inline struct heap_node* __pheap_link(heap_prio_t higher_prio,
+					     struct heap* heap,
+					     struct heap_node* a,
+					     struct heap_node* b)
+{
+	struct heap_node* tmp;
+	if (__heap_higher(higher_prio, heap, b, a)) {
+		tmp = a;
+		a   = b;
+		b   = tmp;
+	}
+	b->prev = a;
+	b->next = a->child;
+	if (a->child)
+		a->child->prev = b;
+	a->child = b;
+	a->prev  = NULL;
+	a->next  = NULL;
+	__HEAP_STAT(heap, links, 1);
+	return a;
+}
+
+static inline struct heap_node* __pheap_meld(heap_prio_t higher_prio,
+					     struct heap* heap,
+					     struct heap_node* a,
+					     struct heap_node* b)
+{
+	if (!a)
+		return b;
+	if (!b)
+		return a;
+	return __pheap_link(higher_prio, heap, a, b);
+}
+
+/* combine a list of siblings into one tree (two-pass pairing) */
+static inline struct heap_node* __pheap_pair(heap_prio_t higher_prio,
+					     struct heap* heap,
+					     struct heap_node* first)
+{
+	struct heap_node *pairs = NULL, *root, *next;
+
+	/* link pairs from left to right, stacking the results... */
+	while (first && first->next) {
+		next  = first->next->next;
+		root  = __pheap_link(higher_prio, heap, first, first->next);
+		root->next = pairs;
+		pairs = root;
+		first = next;
+	}
+	/* ...and link them into one tree from right to left */
+	if (first) {
+		first->prev = NULL;
+		root = first;
+	} else {
+		root  = pairs;
+		pairs = pairs->next;
+		root->next = NULL;
+	}
+	while (pairs) {
+		next  = pairs->next;
+		root  = __pheap_link(higher_prio, heap, root, pairs);
+		pairs = next;
+	}
+	return root;
+}
+
+/* unlink a node that is not the root from its sibling list */
+static inline void __pheap_cut(struct heap_node* node)
+{
+	if (node->prev->child == node)
+		node->prev->child = node->next;
+	else
+		node->prev->next  = node->next;
+	if (node->next)
+		node->next->prev  = node->prev;
+	node->prev = NULL;
+	node->next = NULL;
+}
+
+/* insert (and reinitialize) a node into the heap */
+static inline void heap_insert(heap_prio_t higher_prio, struct heap* heap,
+			       struct heap_node* node)
+{
+	node->prev    = NULL;
+	node->next    = NULL;
+	node->child   = NULL;
+	node->in_heap = 1;
+	heap->head = __pheap_meld(higher_prio, heap, heap->head, node);
+}
+
+/* merge addition into target */
+static inline void heap_union(heap_prio_t higher_prio,
+			      struct heap* target, struct heap* addition)
+{
+	target->head = __pheap_meld(higher_prio, target, target->head,
+				    addition->head);
+	/* this is a destructive merge */
+	addition->head = NULL;
+}
+
+/* insert (and reinitialize) n nodes at once in O(n) time */
+static inline void heap_build(heap_prio_t higher_prio, struct heap* heap,
+			      struct heap_node** nodes, size_t n)
+{
+	size_t i;
+	if (!n)
+		return;
+	for (i = 0; i < n; i++) {
+		nodes[i]->prev    = i ? nodes[i - 1] : NULL;
+		nodes[i]->next    = i + 1 < n ? nodes[i + 1] : NULL;
+		nodes[i]->child   = NULL;
+		nodes[i]->in_heap = 1;
+	}
+	heap->head = __pheap_meld(higher_prio, heap, heap->head,
+				  __pheap_pair(higher_prio, heap, nodes[0]));
+}
+
+/* like heap_build(), but nodes must be sorted highest priority first;
+ * they form a path, so no comparisons are required except for the union
+ */
+static inline void heap_build_sorted(heap_prio_t higher_prio, struct heap* heap,
+				     struct heap_node** nodes, size_t n)
+{
+	size_t i;
+	if (!n)
+		return;
+	for (i = 0; i < n; i++) {
+		nodes[i]->prev    = i ? nodes[i - 1] : NULL;
+		nodes[i]->next    = NULL;
+		nodes[i]->child   = i + 1 < n ? nodes[i + 1] : NULL;
+		nodes[i]->in_heap = 1;
+	}
+	heap->head = __pheap_meld(higher_prio, heap, heap->head, nodes[0]);
+}
+
+static inline struct heap_node* heap_peek(heap_prio_t higher_prio
+					  __attribute__((unused)),
+					  struct heap* heap)
+{
+	return heap->head;
+}
+
+static inline struct heap_node* heap_take(heap_prio_t higher_prio,
+					  struct heap* heap)
+{
+	struct heap_node* node = heap->head;
+	if (node) {
+		heap->head = node->child ?
+			__pheap_pair(higher_prio, heap, node->child) : NULL;
+		node->child   = NULL;
+		node->in_heap = 0;
+	}
+	return node;
+}
+
+/* Take up to k nodes in priority order and store them in nodes. Returns the
+ * number of nodes taken, which is less than k only if the heap ran empty.
+ */
+static inline size_t heap_take_many(heap_prio_t higher_prio, struct heap* heap,
+				    struct heap_node** nodes, size_t k)
+{
+	size_t taken = 0;
+	while (taken < k && (nodes[taken] = heap_take(higher_prio, heap)))
+		taken++;
+	return taken;
+}
+
+/* node's priority was increased, so it is cut out of its sibling list (with
+ * its subtree) and linked with the root
+ */
+static inline void heap_decrease(heap_prio_t higher_prio, struct heap* heap,
+				 struct heap_node* node)
+{
+	if (heap->head == node)
+		return;
+	__pheap_cut(node);
+	__HEAP_STAT(heap, bubble_depth, 1);
+	heap->head = __pheap_link(higher_prio, heap, heap->head, node);
+}
+
+static inline void heap_delete(heap_prio_t higher_prio, struct heap* heap,
+			       struct heap_node* node)
+{
+	struct heap_node* sub;
+	if (heap->head == node) {
+		heap_take(higher_prio, heap);
+		return;
+	}
+	__pheap_cut(node);
+	sub = node->child ? __pheap_pair(higher_prio, heap, node->child) : NULL;
+	heap->head    = __pheap_meld(higher_prio, heap, heap->head, sub);
+	node->child   = NULL;
+	node->in_heap = 0;
+}
+
+/* node's priority was lowered: its children take its place, and node is
+ * linked with the root on its own
+ */
+static inline void heap_increase(heap_prio_t higher_prio, struct heap* heap,
+				 struct heap_node* node)
+{
+	struct heap_node* sub;
+	if (heap->head == node) {
+		heap_take(higher_prio, heap);
+		heap_insert(higher_prio, heap, node);
+		return;
+	}
+	__pheap_cut(node);
+	sub = node->child ? __pheap_pair(higher_prio, heap, node->child) : NULL;
+	node->child = NULL;
+	heap->head  = __pheap_meld(higher_prio, heap, heap->head, sub);
+	heap->head  = __pheap_link(higher_prio, heap, heap->head, node);
+}
+
+/* nodes never move, so relinking is all there is */
+static inline void heap_decrease_relink(heap_prio_t higher_prio,
+					struct heap* heap,
+					struct heap_node* node)
+{
+	heap_decrease(higher_prio, heap, node);
+}
+
+static inline void heap_increase_relink(heap_prio_t higher_prio,
+					struct heap* heap,
+					struct heap_node* node)
+{
+	heap_increase(higher_prio, heap, node);
+}
+
+static inline void heap_delete_relink(heap_prio_t higher_prio,
+				      struct heap* heap,
+				      struct heap_node* node)
+{
+	heap_delete(higher_prio, heap, node);
+}
+
+#endif /* PHEAP_H */
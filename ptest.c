@@ -0,0 +1,221 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <string.h>
+
+#include "heap_pool.h"
+
+/* Allocate nodes from a heap_pool: objects are carved from cache-line
+ * aligned slabs, freed objects are recycled first, and a reset (or a clear
+ * of the heap that the pool backs) rewinds the pool without allocating new
+ * slabs.
+ */
+
+#define N	1000
+
+static struct heap_pool pool;
+static struct iheap_node* nodes[N];
+static int keys[N];
+
+static int int_cmp(const void* a, const void* b)
+{
+	int x = *(const int*) a, y = *(const int*) b;
+	return (x > y) - (x < y);
+}
+
+static size_t slab_count(struct heap_pool* p)
+{
+	struct heap_pool_slab* slab;
+	size_t n = 0;
+	for (slab = p->slabs; slab; slab = slab->next)
+		n++;
+	return n;
+}
+
+/* n objects, spanning several slabs, that do not overlap */
+static int alloc_nodes(const char* what, size_t n)
+{
+	size_t i;
+	for (i = 0; i < n; i++) {
+		nodes[i] = iheap_node_alloc(&pool);
+		if (!nodes[i]) {
+			fprintf(stderr, "ptest: %s: out of memory\n", what);
+			return 1;
+		}
+		/* each slab starts on a cache line */
+		if (i % pool.per_slab == 0 &&
+		    (uintptr_t) nodes[i] % HEAP_POOL_CACHE_LINE) {
+			fprintf(stderr, "ptest: %s: slab not aligned\n", what);
+			return 1;
+		}
+		if (i % pool.per_slab && nodes[i] != nodes[i - 1] + 1) {
+			fprintf(stderr, "ptest: %s: node %lu not next to "
+				"its predecessor\n", what, (unsigned long) i);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/* freed objects come back first, the last one freed first */
+static int test_recycle(void)
+{
+	struct iheap_node* first;
+	size_t i, slabs;
+
+	heap_pool_init(&pool, sizeof(struct iheap_node));
+	if (alloc_nodes("recycle", N))
+		return 1;
+	slabs = slab_count(&pool);
+	if (slabs != (N + pool.per_slab - 1) / pool.per_slab) {
+		fprintf(stderr, "ptest: %lu slabs for %d nodes\n",
+			(unsigned long) slabs, N);
+		return 1;
+	}
+	for (i = 0; i < N; i += 2)
+		iheap_node_free(&pool, nodes[i]);
+	for (i = N; i >= 2; i -= 2)
+		if (iheap_node_alloc(&pool) != nodes[i - 2]) {
+			fprintf(stderr, "ptest: node %lu not recycled\n",
+				(unsigned long) (i - 2));
+			return 1;
+		}
+	/* with the free list empty, the pool carves new objects again */
+	first = iheap_node_alloc(&pool);
+	for (i = 0; i < N; i++)
+		if (!first || first == nodes[i]) {
+			fprintf(stderr, "ptest: node %lu handed out twice\n",
+				(unsigned long) i);
+			return 1;
+		}
+	heap_pool_destroy(&pool);
+	if (pool.slabs || pool.free) {
+		fprintf(stderr, "ptest: pool not empty after destroy\n");
+		return 1;
+	}
+	return 0;
+}
+
+/* Fill a heap from the pool, take some nodes, and clear the heap. The pool
+ * starts over at its first slab, the heap keeps its mode, and both work as
+ * before, without any new slab.
+ */
+static int test_clear(int lazy)
+{
+	struct iheap heap;
+	struct iheap_node* hn;
+	struct iheap_node* first;
+	size_t i, slabs;
+	int round;
+
+	heap_pool_init(&pool, sizeof(struct iheap_node));
+	if (lazy)
+		iheap_init_lazy(&heap);
+	else
+		iheap_init(&heap);
+	first = NULL;
+	slabs = 0;
+	for (round = 0; round < 2; round++) {
+		if (alloc_nodes("clear", N))
+			return 1;
+		if (round == 0) {
+			first = nodes[0];
+			slabs = slab_count(&pool);
+		} else if (nodes[0] != first || slab_count(&pool) != slabs) {
+			fprintf(stderr, "ptest: clear did not rewind the "
+				"pool\n");
+			return 1;
+		}
+		for (i = 0; i < N; i++) {
+			keys[i] = rand() % N;
+			iheap_node_init(nodes[i], keys[i], NULL);
+			iheap_insert(&heap, nodes[i]);
+		}
+		qsort(keys, N, sizeof(int), int_cmp);
+		for (i = 0; i < N / 2; i++) {
+			hn = iheap_take(&heap);
+			if (!hn || hn->key != keys[i]) {
+				fprintf(stderr, "ptest: took %d, expected %d\n",
+					hn ? hn->key : INT_MAX, keys[i]);
+				return 1;
+			}
+			/* taken nodes may go back to the pool, too */
+			if (i % 3 == 0)
+				iheap_node_free(&pool, hn);
+		}
+		iheap_clear(&heap, &pool);
+		if (!iheap_empty(&heap) || iheap_peek(&heap) ||
+		    heap.lazy != lazy) {
+			fprintf(stderr, "ptest: heap not cleared\n");
+			return 1;
+		}
+	}
+	heap_pool_destroy(&pool);
+	return 0;
+}
+
+static int key_less(struct heap_node* a, struct heap_node* b)
+{
+	return *(int*) heap_node_value(a) < *(int*) heap_node_value(b);
+}
+
+/* heap_clear() rewinds the pool just the same */
+static int test_heap_clear(void)
+{
+	struct heap heap;
+	struct heap_node *hn, *first;
+	int i;
+
+	heap_pool_init(&pool, sizeof(struct heap_node));
+	heap_init(&heap);
+	first = heap_node_alloc(&pool);
+	heap_node_free(&pool, first);
+	for (i = 0; i < N; i++) {
+		keys[i] = rand() % N;
+		hn = heap_node_alloc(&pool);
+		heap_node_init(hn, keys + i);
+		heap_insert(key_less, &heap, hn);
+		if (i == N / 2)
+			heap_clear(&heap, &pool);
+	}
+	heap_clear(&heap, &pool);
+	if (!heap_empty(&heap) || heap_node_alloc(&pool) != first) {
+		fprintf(stderr, "ptest: heap_clear() did not rewind\n");
+		return 1;
+	}
+	heap_pool_destroy(&pool);
+	return 0;
+}
+
+/* an object larger than a slab gets a slab of its own */
+static int test_large(void)
+{
+	struct heap_pool big;
+	size_t size = 2 * HEAP_POOL_SLAB_SIZE + sizeof(void*);
+	char *a, *b;
+
+	heap_pool_init(&big, size);
+	a = heap_pool_alloc(&big);
+	b = heap_pool_alloc(&big);
+	if (!a || !b || a == b || big.per_slab != 1) {
+		fprintf(stderr, "ptest: no room for large objects\n");
+		return 1;
+	}
+	memset(a, 1, size);
+	memset(b, 2, size);
+	if (a[size - 1] != 1 || b[0] != 2) {
+		fprintf(stderr, "ptest: large objects overlap\n");
+		return 1;
+	}
+	heap_pool_destroy(&big);
+	return 0;
+}
+
+int main(int argc __attribute__((unused)), char** argv __attribute__((unused)))
+{
+	srand(1);
+	if (test_recycle() || test_clear(0) || test_clear(1) ||
+	    test_heap_clear() || test_large())
+		return 1;
+	return 0;
+}
@@ -0,0 +1,282 @@
+/* rheap.h -- Radix Heaps for monotone integer keys
+ *
+ * Copyright (c) 2008, Bjoern B. Brandenburg <bbb [at] cs.unc.edu>
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University of North Carolina nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY  COPYRIGHT OWNER AND CONTRIBUTERS ``AS IS'' AND
+ * ANY  EXPRESS OR  IMPLIED  WARRANTIES,  INCLUDING, BUT  NOT  LIMITED TO,  THE
+ * IMPLIED WARRANTIES  OF MERCHANTABILITY AND FITNESS FOR  A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO  EVENT SHALL THE  COPYRIGHT OWNER OR  CONTRIBUTERS BE
+ * LIABLE  FOR  ANY  DIRECT,   INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT  OF
+ * SUBSTITUTE GOODS  OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+ * INTERRUPTION)  HOWEVER CAUSED  AND ON  ANY THEORY  OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR  TORT (INCLUDING  NEGLIGENCE OR  OTHERWISE)
+ * ARISING IN ANY WAY  OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RHEAP_H
+#define RHEAP_H
+
+#include <assert.h>
+#include <limits.h>
+#include <stdint.h>
+
+#define NOT_IN_HEAP UINT_MAX
+
+#ifdef HEAP_STATS
+#include "heap_stats.h"
+#define __HEAP_STAT(heap, field, n)	((heap)->stats.field += (n))
+#else
+#define __HEAP_STAT(heap, field, n)	((void) (heap))
+#endif
+
+/* Keys are ints, as in iheap.h, unless RHEAP_KEY64 is defined, in which
+ * case they are uint64_t (e.g., nanosecond deadlines).
+ */
+#ifdef RHEAP_KEY64
+typedef uint64_t	rheap_key_t;
+typedef uint64_t	__rheap_bits_t;
+#define RHEAP_KEY_MIN	0
+#else
+typedef int		rheap_key_t;
+typedef unsigned int	__rheap_bits_t;
+#define RHEAP_KEY_MIN	INT_MIN
+#endif
+
+#define RHEAP_KEY_BITS	(sizeof(rheap_key_t) * CHAR_BIT)
+
+/* A radix heap only works for monotone keys: no key may be smaller than the
+ * last minimum that was taken (or peeked at). Node n is kept in bucket b if
+ * the highest bit in which n->key differs from that minimum is bit b - 1;
+ * bucket 0 holds the keys equal to it. Taking from an empty bucket 0 finds
+ * the minimum of the first nonempty bucket, makes it the new last minimum
+ * and redistributes that bucket, each node to a lower one. A node moves
+ * down at most RHEAP_KEY_BITS times, so take is O(log C) amortized for keys
+ * spanning a range of C, and insert, decrease and delete are O(1). Nodes
+ * never move between memory locations, so no refs are needed.
+ *
+ * Keys below the last minimum are rejected by assert(), i.e., unless NDEBUG
+ * is defined. A heap that runs empty accepts any key again.
+ */
+struct rheap_node {
+	struct rheap_node*	prev;
+	struct rheap_node*	next;
+
+	unsigned int		bucket;
+	rheap_key_t		key;
+	const void*		value;
+};
+
+struct rheap {
+	struct rheap_node*	buckets[RHEAP_KEY_BITS + 1];
+	/* bit b - 1 is set iff bucket b (b > 0) is not empty */
+	uint64_t		occupied;
+	/* lower bound on all keys in the heap */
+	rheap_key_t		last;
+#ifdef HEAP_STATS
+	struct heap_stats	stats;
+#endif
+};
+
+static inline void rheap_init(struct rheap* heap)
+{
+	unsigned int b;
+	for (b = 0; b <= RHEAP_KEY_BITS; b++)
+		heap->buckets[b] = NULL;
+	heap->occupied = 0;
+	heap->last     = RHEAP_KEY_MIN;
+#ifdef HEAP_STATS
+	heap_stats_reset(&heap->stats);
+#endif
+}
+
+static inline void rheap_node_init(struct rheap_node* h, rheap_key_t key,
+				   const void* value)
+{
+	h->prev   = NULL;
+	h->next   = NULL;
+	h->bucket = NOT_IN_HEAP;
+	h->key    = key;
+	h->value  = value;
+}
+
+static inline const void* rheap_node_value(struct rheap_node* h)
+{
+	return h->value;
+}
+
+static inline int rheap_node_in_heap(struct rheap_node* h)
+{
+	return h->bucket != NOT_IN_HEAP;
+}
+
+static inline int rheap_empty(struct rheap* heap)
+{
+	return !heap->occupied && !heap->buckets[0];
+}
+
+/* all key comparisons go through here so that they can be counted */
+static inline int __rheap_less(struct rheap* heap,
+			       struct rheap_node* a, struct rheap_node* b)
+{
+	__HEAP_STAT(heap, compares, 1);
+	return a->key < b->key;
+}
+
+/* Bucket for key, relative to heap->last. Flipping the sign bit would map
+ * int keys to unsigned ones in the same order, but it cancels in the xor.
+ */
+static inline unsigned int __rheap_bucket(struct rheap* heap, rheap_key_t key)
+{
+	unsigned long long diff;
+	diff = (unsigned long long) ((__rheap_bits_t) key ^
+				     (__rheap_bits_t) heap->last);
+	if (!diff)
+		return 0;
+	return (unsigned int) (sizeof(diff) * CHAR_BIT) -
+		(unsigned int) __builtin_clzll(diff);
+}
+
+static inline void __rheap_add(struct rheap* heap, struct rheap_node* node)
+{
+	unsigned int b = __rheap_bucket(heap, node->key);
+	node->bucket = b;
+	node->prev   = NULL;
+	node->next   = heap->buckets[b];
+	if (node->next)
+		node->next->prev = node;
+	heap->buckets[b] = node;
+	if (b)
+		heap->occupied |= (uint64_t) 1 << (b - 1);
+}
+
+static inline void __rheap_remove(struct rheap* heap, struct rheap_node* node)
+{
+	unsigned int b = node->bucket;
+	if (node->prev)
+		node->prev->next = node->next;
+	else
+		heap->buckets[b] = node->next;
+	if (node->next)
+		node->next->prev = node->prev;
+	if (b && !heap->buckets[b])
+		heap->occupied &= ~((uint64_t) 1 << (b - 1));
+}
+
+/* Make sure that bucket 0 holds the minimum, if there is one. */
+static inline struct rheap_node* __rheap_pull(struct rheap* heap)
+{
+	struct rheap_node *list, *min, *pos, *next;
+	unsigned int b;
+
+	if (heap->buckets[0]) {
+		__HEAP_STAT(heap, min_hits, 1);
+		return heap->buckets[0];
+	}
+	if (!heap->occupied)
+		return NULL;
+	__HEAP_STAT(heap, min_misses, 1);
+	__HEAP_STAT(heap, min_scans, 1);
+	b    = (unsigned int) __builtin_ctzll(heap->occupied) + 1;
+	list = heap->buckets[b];
+	heap->buckets[b] = NULL;
+	heap->occupied  &= ~((uint64_t) 1 << (b - 1));
+	min = list;
+	for (pos = list->next; pos; pos = pos->next) {
+		__HEAP_STAT(heap, roots_scanned, 1);
+		if (__rheap_less(heap, pos, min))
+			min = pos;
+	}
+	/* every other bucket keeps its nodes relative to the new minimum */
+	heap->last = min->key;
+	for (pos = list; pos; pos = next) {
+		next = pos->next;
+		__rheap_add(heap, pos);
+	}
+	return heap->buckets[0];
+}
+
+/* insert (and reinitialize) a node into the heap */
+static inline void rheap_insert(struct rheap* heap, struct rheap_node* node)
+{
+	assert(node->key >= heap->last);
+	__rheap_add(heap, node);
+}
+
+/* merge addition into target; addition's keys must not be below
+ * target's last minimum. Takes time linear in the size of addition.
+ */
+static inline void rheap_union(struct rheap* target, struct rheap* addition)
+{
+	struct rheap_node *pos, *next;
+	unsigned int b;
+	for (b = 0; b <= RHEAP_KEY_BITS; b++) {
+		for (pos = addition->buckets[b]; pos; pos = next) {
+			next = pos->next;
+			rheap_insert(target, pos);
+		}
+		addition->buckets[b] = NULL;
+	}
+	addition->occupied = 0;
+	addition->last     = RHEAP_KEY_MIN;
+}
+
+/* Like iheap_peek(). The key returned becomes the lower bound for later
+ * insertions and decreases.
+ */
+static inline struct rheap_node* rheap_peek(struct rheap* heap)
+{
+	return __rheap_pull(heap);
+}
+
+static inline struct rheap_node* rheap_take(struct rheap* heap)
+{
+	struct rheap_node* node = __rheap_pull(heap);
+	if (!node)
+		return NULL;
+	__rheap_remove(heap, node);
+	node->bucket = NOT_IN_HEAP;
+	if (rheap_empty(heap))
+		heap->last = RHEAP_KEY_MIN;
+	return node;
+}
+
+static inline void rheap_decrease(struct rheap* heap, struct rheap_node* node,
+				  rheap_key_t new_key)
+{
+	unsigned int b;
+	if (new_key >= node->key)
+		return;
+	assert(new_key >= heap->last);
+	node->key = new_key;
+	b = __rheap_bucket(heap, new_key);
+	if (b != node->bucket) {
+		__rheap_remove(heap, node);
+		__rheap_add(heap, node);
+		__HEAP_STAT(heap, bubble_depth, 1);
+	}
+}
+
+static inline void rheap_delete(struct rheap* heap, struct rheap_node* node)
+{
+	__rheap_remove(heap, node);
+	node->bucket = NOT_IN_HEAP;
+	if (rheap_empty(heap))
+		heap->last = RHEAP_KEY_MIN;
+}
+
+#endif /* RHEAP_H */
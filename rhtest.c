@@ -0,0 +1,248 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "rheap.h"
+
+/* Insert, peek, take, decrease, and delete at random, with keys that never
+ * fall below the last minimum, against a table of the keys that should be in
+ * the heap. Check that equal keys are fine, that an empty heap accepts
+ * smaller keys again, and that assert() stops keys below the last minimum.
+ *
+ * With 64-bit keys, the keys start at 2^63, so that they differ in the
+ * highest bit from the keys below.
+ */
+#ifdef RHEAP_KEY64
+#define NAME		"rhtest64"
+#define KEY(prio)	((rheap_key_t) (prio) + ((rheap_key_t) 1 << 63))
+#else
+#define NAME		"rhtest"
+#define KEY(prio)	(prio)
+#endif
+
+#ifndef NDEBUG
+
+/* After peeking at 10, put 5 into the heap by insert (0), decrease (1), or
+ * union (2).
+ */
+static void violate(int how)
+{
+	struct rheap heap, other;
+	struct rheap_node a, b, c;
+
+	rheap_init(&heap);
+	rheap_init(&other);
+	rheap_node_init(&a, KEY(10), NULL);
+	rheap_node_init(&b, KEY(20), NULL);
+	rheap_node_init(&c, KEY(5), NULL);
+	rheap_insert(&heap, &a);
+	rheap_insert(&heap, &b);
+	rheap_peek(&heap);
+	switch (how) {
+	case 0:
+		rheap_insert(&heap, &c);
+		break;
+	case 1:
+		rheap_decrease(&heap, &b, KEY(5));
+		break;
+	case 2:
+		rheap_insert(&other, &c);
+		rheap_union(&heap, &other);
+		break;
+	}
+}
+
+/* each violation must be stopped by assert() in a child process */
+static int test_violations(void)
+{
+	int how, status;
+	pid_t pid;
+
+	fflush(stdout);
+	for (how = 0; how < 3; how++) {
+		pid = fork();
+		if (pid < 0) {
+			perror("fork");
+			return 1;
+		}
+		if (!pid) {
+			/* keep the assertion message off the test output */
+			if (!freopen("/dev/null", "w", stderr))
+				_exit(2);
+			violate(how);
+			_exit(0);
+		}
+		if (waitpid(pid, &status, 0) != pid ||
+		    !WIFSIGNALED(status) || WTERMSIG(status) != SIGABRT) {
+			fprintf(stderr, NAME ": violation %d not caught\n",
+				how);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+#endif
+
+/* Keys equal to the last minimum are fine, and a heap that ran empty
+ * accepts smaller keys again.
+ */
+static int test_monotone(void)
+{
+	struct rheap heap;
+	struct rheap_node a, b, c;
+
+	rheap_init(&heap);
+	rheap_node_init(&a, KEY(10), NULL);
+	rheap_node_init(&b, KEY(20), NULL);
+	rheap_node_init(&c, KEY(10), NULL);
+	rheap_insert(&heap, &a);
+	rheap_insert(&heap, &b);
+	rheap_peek(&heap);
+	rheap_insert(&heap, &c);
+	rheap_decrease(&heap, &b, KEY(10));
+	if (rheap_take(&heap)->key != KEY(10) ||
+	    rheap_take(&heap)->key != KEY(10) ||
+	    rheap_take(&heap)->key != KEY(10) || !rheap_empty(&heap)) {
+		fprintf(stderr, NAME ": equal keys lost\n");
+		return 1;
+	}
+	rheap_node_init(&a, KEY(5), NULL);
+	rheap_insert(&heap, &a);
+	if (rheap_take(&heap) != &a) {
+		fprintf(stderr, NAME ": empty heap rejected a smaller key\n");
+		return 1;
+	}
+	return 0;
+}
+
+#define N	1000
+#define STEPS	40000
+
+/* the value of each node is its slot */
+struct slot {
+	int			in_heap;
+	struct rheap_node	node;
+};
+
+static struct slot slots[N];
+
+/* the smallest key in the heap, and whether there is one */
+static int min_key(rheap_key_t* min)
+{
+	int i, found = 0;
+	for (i = 0; i < N; i++)
+		if (slots[i].in_heap && (!found || slots[i].node.key < *min)) {
+			*min  = slots[i].node.key;
+			found = 1;
+		}
+	return found;
+}
+
+/* random slot that is (not) in the heap, or NULL */
+static struct slot* pick(int in_heap)
+{
+	int i, start = rand() % N;
+	for (i = 0; i < N; i++)
+		if (slots[(start + i) % N].in_heap == in_heap)
+			return &slots[(start + i) % N];
+	return NULL;
+}
+
+/* a random key at or above last, now and then far above */
+static rheap_key_t random_key(rheap_key_t last)
+{
+	return last + (rheap_key_t) (rand() % 20 ? rand() % N :
+				     rand() % (1 << 16));
+}
+
+/* take (or peek at) the minimum; returns its key in *last */
+static int take(struct rheap* heap, int peek, rheap_key_t* last)
+{
+	struct rheap_node* hn;
+	struct slot* s;
+	rheap_key_t min = 0;
+	int found = min_key(&min);
+
+	hn = peek ? rheap_peek(heap) : rheap_take(heap);
+	if (!hn != !found) {
+		fprintf(stderr, NAME ": heap %s\n",
+			hn ? "not empty" : "ran empty too early");
+		return 1;
+	}
+	if (!hn)
+		return 0;
+	s = (struct slot*) rheap_node_value(hn);
+	if (&s->node != hn || !s->in_heap || hn->key != min) {
+		fprintf(stderr, NAME ": took the wrong node\n");
+		return 1;
+	}
+	*last = min;
+	if (!peek) {
+		s->in_heap = 0;
+		if (rheap_node_in_heap(hn)) {
+			fprintf(stderr, NAME ": taken node still in heap\n");
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static int test_random(void)
+{
+	struct rheap heap;
+	struct slot* s;
+	rheap_key_t last = KEY(0);
+	int i, dice, err = 0;
+
+	rheap_init(&heap);
+	for (i = 0; i < N; i++)
+		slots[i].in_heap = 0;
+	for (i = 0; i < STEPS && !err; i++) {
+		dice = rand() % 16;
+		if (dice < 6) {
+			if (!(s = pick(0)))
+				continue;
+			rheap_node_init(&s->node, random_key(last), s);
+			rheap_insert(&heap, &s->node);
+			s->in_heap = 1;
+		} else if (dice < 10) {
+			err = take(&heap, dice == 6, &last);
+		} else if (dice < 13) {
+			/* somewhere between the last minimum and the key */
+			if (!(s = pick(1)))
+				continue;
+			rheap_decrease(&heap, &s->node, last +
+				       (s->node.key - last) / 2);
+		} else {
+			if (!(s = pick(1)))
+				continue;
+			rheap_delete(&heap, &s->node);
+			s->in_heap = 0;
+		}
+	}
+	while (!err && !rheap_empty(&heap))
+		err = take(&heap, 0, &last);
+	if (!err && pick(1)) {
+		fprintf(stderr, NAME ": heap ran empty too early\n");
+		err = 1;
+	}
+	return err;
+}
+
+int main(int argc __attribute__((unused)), char** argv __attribute__((unused)))
+{
+	srand(1);
+	if (test_monotone() || test_random())
+		return 1;
+#ifndef NDEBUG
+	if (test_violations())
+		return 1;
+#endif
+	return 0;
+}
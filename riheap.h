@@ -0,0 +1,279 @@
+/* riheap.h -- Binomial Heaps with a degree-indexed root array
+ *
+ * Copyright (c) 2008, Bjoern B. Brandenburg <bbb [at] cs.unc.edu>
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University of North Carolina nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY  COPYRIGHT OWNER AND CONTRIBUTERS ``AS IS'' AND
+ * ANY  EXPRESS OR  IMPLIED  WARRANTIES,  INCLUDING, BUT  NOT  LIMITED TO,  THE
+ * IMPLIED WARRANTIES  OF MERCHANTABILITY AND FITNESS FOR  A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO  EVENT SHALL THE  COPYRIGHT OWNER OR  CONTRIBUTERS BE
+ * LIABLE  FOR  ANY  DIRECT,   INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT  OF
+ * SUBSTITUTE GOODS  OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+ * INTERRUPTION)  HOWEVER CAUSED  AND ON  ANY THEORY  OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR  TORT (INCLUDING  NEGLIGENCE OR  OTHERWISE)
+ * ARISING IN ANY WAY  OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RIHEAP_H
+#define RIHEAP_H
+
+#include "iheap.h"
+
+/* An integer-key binomial heap on struct iheap_node that keeps its roots in
+ * an array indexed by degree instead of a linked list. Hence, the roots form
+ * the binary representation of the heap's size: bit d of mask is set iff
+ * there is a tree of degree d, and inserting or merging trees works like
+ * adding to mask.
+ *
+ * The root keys are mirrored in a contiguous array, with INT_MAX in empty
+ * slots, so finding the minimum is a branch-free reduction over a fixed
+ * number of ints that the compiler can vectorize. There is no min cache.
+ */
+struct riheap {
+	int			keys[HEAP_MAX_DEGREE];
+	struct iheap_node*	roots[HEAP_MAX_DEGREE];
+	size_t			mask;
+#ifdef HEAP_STATS
+	struct heap_stats	stats;
+#endif
+};
+
+static inline void riheap_init(struct riheap* heap)
+{
+	unsigned int d;
+	for (d = 0; d < HEAP_MAX_DEGREE; d++) {
+		heap->keys[d]  = INT_MAX;
+		heap->roots[d] = NULL;
+	}
+	heap->mask = 0;
+#ifdef HEAP_STATS
+	heap_stats_reset(&heap->stats);
+#endif
+}
+
+static inline int riheap_empty(struct riheap* heap)
+{
+	return heap->mask == 0;
+}
+
+static inline int __riheap_less(struct riheap* heap,
+				struct iheap_node* a, struct iheap_node* b)
+{
+	__HEAP_STAT(heap, compares, 1);
+	return a->key < b->key;
+}
+
+static inline void __riheap_set(struct riheap* heap, struct iheap_node* node)
+{
+	heap->roots[node->degree] = node;
+	heap->keys[node->degree]  = node->key;
+	heap->mask |= (size_t) 1 << node->degree;
+}
+
+static inline void __riheap_clear(struct riheap* heap, unsigned int d)
+{
+	heap->roots[d] = NULL;
+	heap->keys[d]  = INT_MAX;
+	heap->mask &= ~((size_t) 1 << d);
+}
+
+/* add a tree whose root has no siblings: link through the occupied slots */
+static inline void __riheap_carry(struct riheap* heap, struct iheap_node* node)
+{
+	struct iheap_node* other;
+	while ((other = heap->roots[node->degree])) {
+		__riheap_clear(heap, node->degree);
+		if (__riheap_less(heap, other, node)) {
+			__iheap_link(other, node);
+			node = other;
+		} else
+			__iheap_link(node, other);
+		__HEAP_STAT(heap, links, 1);
+	}
+	__riheap_set(heap, node);
+}
+
+/* turn the children of a removed root into roots */
+static inline void __riheap_carry_children(struct riheap* heap,
+					   struct iheap_node* node)
+{
+	struct iheap_node *pos, *next;
+	for (pos = node->child; pos; pos = next) {
+		next        = pos->next;
+		pos->parent = NULL;
+		pos->next   = NULL;
+		__riheap_carry(heap, pos);
+	}
+}
+
+/* degree of the root with the minimum key; the heap must not be empty */
+static inline unsigned int __riheap_min(struct riheap* heap)
+{
+	int min = INT_MAX;
+	unsigned int d;
+
+	__HEAP_STAT(heap, min_scans, 1);
+	for (d = 0; d < HEAP_MAX_DEGREE; d++)
+		min = heap->keys[d] < min ? heap->keys[d] : min;
+	/* a root may have the key INT_MAX, too */
+	for (d = 0; heap->keys[d] != min || !heap->roots[d]; d++)
+		;
+	return d;
+}
+
+/* insert (and reinitialize) a node into the heap */
+static inline void riheap_insert(struct riheap* heap, struct iheap_node* node)
+{
+	node->child  = NULL;
+	node->parent = NULL;
+	node->next   = NULL;
+	node->degree = 0;
+	__riheap_carry(heap, node);
+}
+
+/* insert (and reinitialize) n nodes; the binary counter makes this O(n) */
+static inline void riheap_build(struct riheap* heap,
+				struct iheap_node** nodes, size_t n)
+{
+	size_t i;
+	for (i = 0; i < n; i++)
+		riheap_insert(heap, nodes[i]);
+}
+
+/* merge addition into target */
+static inline void riheap_union(struct riheap* target,
+				struct riheap* addition)
+{
+	struct iheap_node* node;
+	size_t bits = addition->mask;
+	unsigned int d;
+
+	/* lowest degree first, so that each carry stops below the next tree */
+	for (d = 0; bits; d++, bits >>= 1)
+		if (bits & 1) {
+			node = addition->roots[d];
+			__riheap_clear(addition, d);
+			__riheap_carry(target, node);
+		}
+}
+
+static inline struct iheap_node* riheap_peek(struct riheap* heap)
+{
+	if (riheap_empty(heap))
+		return NULL;
+	return heap->roots[__riheap_min(heap)];
+}
+
+static inline struct iheap_node* riheap_take(struct riheap* heap)
+{
+	struct iheap_node* node;
+	unsigned int d;
+
+	if (riheap_empty(heap))
+		return NULL;
+	d    = __riheap_min(heap);
+	node = heap->roots[d];
+	__riheap_clear(heap, d);
+	__riheap_carry_children(heap, node);
+	node->degree = NOT_IN_HEAP;
+	return node;
+}
+
+/* Take node's tree apart as in __iheap_cut(). No values move, so this works
+ * with and without refs.
+ */
+static inline void riheap_delete(struct riheap* heap, struct iheap_node* node)
+{
+	struct iheap_node* path[HEAP_MAX_DEGREE];
+	struct iheap_node *root, *down, *pos, *next;
+	unsigned int depth = 0;
+
+	for (root = node; root->parent; root = root->parent)
+		path[depth++] = root;
+	__HEAP_STAT(heap, bubble_depth, depth);
+	__riheap_clear(heap, root->degree);
+	while (depth--) {
+		down = path[depth];
+		/* children are ordered by decreasing degree */
+		for (pos = root->child; pos != down; pos = next) {
+			next        = pos->next;
+			pos->parent = NULL;
+			pos->next   = NULL;
+			__riheap_carry(heap, pos);
+		}
+		root->child  = down->next;
+		root->degree = down->degree;
+		root->next   = NULL;
+		__riheap_carry(heap, root);
+		down->parent = NULL;
+		root         = down;
+	}
+	__riheap_carry_children(heap, node);
+	node->degree = NOT_IN_HEAP;
+}
+
+/* Nodes with a ref exchange values with their ancestors, as in iheap.h;
+ * nodes without one are cut out of their tree and inserted again, as in
+ * iheap_decrease_relink().
+ */
+static inline void riheap_decrease(struct riheap* heap,
+				   struct iheap_node* node, int new_key)
+{
+	struct iheap_node *parent;
+	struct iheap_node** tmp_ref;
+	const void* tmp;
+	int tmp_key;
+
+	if (new_key >= node->key)
+		return;
+	node->key = new_key;
+	if (!node->ref) {
+		if (node->parent &&
+		    __riheap_less(heap, node, node->parent)) {
+			riheap_delete(heap, node);
+			riheap_insert(heap, node);
+			return;
+		}
+	} else {
+		parent = node->parent;
+		while (parent && __riheap_less(heap, node, parent)) {
+			/* swap parent and node */
+			tmp           = parent->value;
+			tmp_key       = parent->key;
+			parent->value = node->value;
+			parent->key   = node->key;
+			node->value   = tmp;
+			node->key     = tmp_key;
+			/* swap references */
+			if (parent->ref)
+				*(parent->ref) = node;
+			*(node->ref)   = parent;
+			tmp_ref        = parent->ref;
+			parent->ref    = node->ref;
+			node->ref      = tmp_ref;
+			/* step up */
+			node   = parent;
+			parent = node->parent;
+			__HEAP_STAT(heap, bubble_depth, 1);
+		}
+	}
+	/* keep the key array in sync */
+	if (!node->parent)
+		heap->keys[node->degree] = node->key;
+}
+
+#endif /* RIHEAP_H */
@@ -0,0 +1,189 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+
+#include "riheap.h"
+
+/* Random inserts, builds, takes, decreases, deletes, and unions on two
+ * riheaps, with and without refs, against a table of the keys that should
+ * be in each heap. After every step, the root array must mirror the heap:
+ * mask is the number of nodes, each root sits in the slot of its degree,
+ * and keys[] holds the root keys, or INT_MAX in empty slots. Some keys are
+ * INT_MAX themselves.
+ */
+
+#define N	1000
+#define STEPS	20000
+#define BATCH	8
+
+/* the value of each node is its slot */
+struct slot {
+	/* 0 or 1, or -1 if not in a heap */
+	int			heap;
+	struct iheap_node*	node;
+};
+
+static struct slot slots[N];
+static struct riheap heaps[2];
+static size_t sizes[2];
+static struct iheap_node* batch[BATCH];
+
+static int random_key(void)
+{
+	return rand() % 50 ? rand() % N : INT_MAX;
+}
+
+static int check_roots(int h)
+{
+	struct riheap* heap = heaps + h;
+	unsigned int d;
+
+	if (heap->mask != sizes[h]) {
+		fprintf(stderr, "ritest: mask %lu for %lu nodes\n",
+			(unsigned long) heap->mask, (unsigned long) sizes[h]);
+		return 1;
+	}
+	for (d = 0; d < HEAP_MAX_DEGREE; d++)
+		if (heap->roots[d] ?
+		    heap->roots[d]->degree != d || heap->roots[d]->parent ||
+		    heap->keys[d] != heap->roots[d]->key :
+		    heap->keys[d] != INT_MAX) {
+			fprintf(stderr, "ritest: root slot %u out of sync\n",
+				d);
+			return 1;
+		}
+	return 0;
+}
+
+/* the smallest key in heap h, and whether there is one */
+static int min_key(int h, int* min)
+{
+	int i, found = 0;
+	*min = INT_MAX;
+	for (i = 0; i < N; i++)
+		if (slots[i].heap == h) {
+			found = 1;
+			if (slots[i].node->key < *min)
+				*min = slots[i].node->key;
+		}
+	return found;
+}
+
+/* random slot with heap h (-1: not in a heap), or NULL */
+static struct slot* pick(int h)
+{
+	int i, start = rand() % N;
+	for (i = 0; i < N; i++)
+		if (slots[(start + i) % N].heap == h)
+			return &slots[(start + i) % N];
+	return NULL;
+}
+
+static void init_node(struct slot* s, int refs)
+{
+	if (refs)
+		iheap_node_init_ref(&s->node, random_key(), s);
+	else
+		iheap_node_init(s->node, random_key(), s);
+}
+
+static int take(int h)
+{
+	struct iheap_node* hn;
+	struct slot* s;
+	int min, found = min_key(h, &min);
+
+	hn = riheap_take(heaps + h);
+	if (!hn != !found) {
+		fprintf(stderr, "ritest: heap %d %s\n", h,
+			hn ? "not empty" : "ran empty too early");
+		return 1;
+	}
+	if (!hn)
+		return 0;
+	s = (struct slot*) iheap_node_value(hn);
+	if (hn->key != min || s->node != hn || s->heap != h) {
+		fprintf(stderr, "ritest: took %d from heap %d, expected %d\n",
+			hn->key, h, min);
+		return 1;
+	}
+	s->heap = -1;
+	sizes[h]--;
+	return 0;
+}
+
+static int test_random(int refs)
+{
+	struct slot* s;
+	int i, j, h, dice, err = 0;
+
+	for (h = 0; h < 2; h++) {
+		riheap_init(heaps + h);
+		sizes[h] = 0;
+	}
+	for (i = 0; i < N; i++) {
+		slots[i].heap = -1;
+		slots[i].node = malloc(sizeof(struct iheap_node));
+	}
+	for (i = 0; i < STEPS && !err; i++) {
+		h    = rand() % 2;
+		dice = rand() % 16;
+		if (dice < 5) {
+			if (!(s = pick(-1)))
+				continue;
+			init_node(s, refs);
+			riheap_insert(heaps + h, s->node);
+			s->heap = h;
+			sizes[h]++;
+		} else if (dice == 5) {
+			for (j = 0; j < BATCH && (s = pick(-1)); j++) {
+				init_node(s, refs);
+				batch[j] = s->node;
+				s->heap  = h;
+			}
+			riheap_build(heaps + h, batch, (size_t) j);
+			sizes[h] += (size_t) j;
+		} else if (dice < 9) {
+			err = take(h);
+		} else if (dice < 13) {
+			if (!(s = pick(h)))
+				continue;
+			riheap_decrease(heaps + h, s->node,
+					s->node->key - rand() % N);
+			if (iheap_node_value(s->node) != s) {
+				fprintf(stderr, "ritest: stale ref\n");
+				err = 1;
+			}
+		} else if (dice < 15) {
+			if (!(s = pick(h)))
+				continue;
+			riheap_delete(heaps + h, s->node);
+			s->heap = -1;
+			sizes[h]--;
+		} else {
+			riheap_union(heaps, heaps + 1);
+			for (j = 0; j < N; j++)
+				if (slots[j].heap == 1)
+					slots[j].heap = 0;
+			sizes[0] += sizes[1];
+			sizes[1]  = 0;
+		}
+		err = err || check_roots(0) || check_roots(1);
+	}
+	for (h = 0; h < 2 && !err; h++)
+		while (!err && !riheap_empty(heaps + h))
+			err = take(h) || check_roots(h);
+	for (h = 0; h < 2 && !err; h++)
+		err = take(h);
+	for (i = 0; i < N; i++)
+		free(slots[i].node);
+	return err;
+}
+
+int main(int argc __attribute__((unused)), char** argv __attribute__((unused)))
+{
+	srand(1);
+	if (test_random(0) || test_random(1))
+		return 1;
+	return 0;
+}
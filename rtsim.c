@@ -0,0 +1,461 @@
+/* rtsim.c -- discrete-event simulation of a real-time scheduler
+ *
+ * Usage: rtsim [-n tasks] [-m cpus] [-u utilization] [-j jobs] [-g granularity]
+ *              [-J jitter] [-s seed]
+ *
+ * Simulates global EDF and global fixed-priority (rate-monotonic) scheduling
+ * of n sporadic tasks with implicit deadlines on m processors, until a given
+ * number of jobs has completed. Periods are drawn from a harmonic set, task
+ * utilizations from UUniFast, and each job runs for 50-100% of its task's
+ * worst-case execution time. A job arrives one period plus a random jitter
+ * (up to J percent of the period) after its predecessor; arrivals are rounded
+ * up to multiples of the release granularity g, like a tick-based kernel.
+ *
+ * Each policy runs with two release queues:
+ *   - merge:  jobs that arrive at the same time wait in their own iheap,
+ *             and the release queue orders these heaps by time. At release,
+ *             a heap is merged into the ready queue with a single union.
+ *   - insert: the release queue holds jobs, which are moved into the ready
+ *             queue one by one.
+ *
+ * Times are in ticks. Reports simulated jobs per second of wall-clock time,
+ * the number of deadline misses, the maximum tardiness, and the average
+ * number of jobs per release.
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <stdint.h>
+#include <time.h>
+#include <math.h>
+
+#include "iheap.h"
+#include "heap_pool.h"
+
+/* highest possible number of processors */
+#define MAX_CPUS 64
+
+enum { EDF, FP };
+enum { MERGE, INSERT };
+
+struct config {
+	unsigned int	tasks;
+	unsigned int	cpus;
+	double		util;
+	unsigned long	jobs;
+	long		granularity;
+	unsigned int	jitter;
+	unsigned int	seed;
+};
+
+struct task {
+	long		period;
+	long		wcet;
+	/* fixed priority; smaller is higher */
+	int		prio;
+};
+
+/* The node comes first so that a node pointer is also a job pointer. */
+struct job {
+	struct iheap_node	node;
+	struct task*		task;
+	long			release;
+	long			deadline;
+	long			remaining;
+	/* other jobs released at the same time (merge mode) */
+	struct job*		next;
+};
+
+/* jobs that are released at the same time (merge mode) */
+struct release_heap {
+	struct iheap_node	node;
+	long			time;
+	struct iheap		jobs;
+	struct job*		list;
+	/* next heap in the same hash bucket */
+	struct release_heap*	chain;
+};
+
+struct sim {
+	const struct config*	cfg;
+	int			policy;
+	int			mode;
+	struct task*		tasks;
+	unsigned int		seed;
+	long			now;
+
+	/* ordered by priority */
+	struct iheap		ready;
+	/* ordered by release time */
+	struct iheap		releases;
+	/* pending release heaps, hashed by time */
+	struct release_heap**	buckets;
+	size_t			nbuckets;
+	struct heap_pool	job_pool;
+	struct heap_pool	rh_pool;
+	struct job*		running[MAX_CPUS];
+
+	unsigned long		completed;
+	unsigned long		misses;
+	unsigned long		preemptions;
+	unsigned long		releases_done;
+	unsigned long		released;
+	long			max_tardiness;
+};
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+}
+
+/* xorshift; seed must not be zero */
+static unsigned int rnd(unsigned int* seed)
+{
+	unsigned int x = *seed;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return *seed = x;
+}
+
+static double rnd_unit(unsigned int* seed)
+{
+	return (double) rnd(seed) / 4294967296.0;
+}
+
+static void out_of_memory(void)
+{
+	fprintf(stderr, "out of memory\n");
+	exit(1);
+}
+
+/* harmonic periods, so that many jobs are released together */
+static const long periods[] = {
+	100, 200, 400, 500, 1000, 2000, 4000, 5000, 10000
+};
+
+#define LENGTH(a) (sizeof(a) / sizeof(a[0]))
+
+static int period_cmp(const void* _a, const void* _b)
+{
+	const struct task *a = _a, *b = _b;
+	return a->period < b->period ? -1 : a->period > b->period;
+}
+
+/* UUniFast task utilizations; rate-monotonic priorities */
+static struct task* make_tasks(const struct config* cfg)
+{
+	struct task* tasks = malloc(sizeof(struct task) * cfg->tasks);
+	unsigned int seed = cfg->seed, i;
+	double sum = cfg->util, next, u;
+
+	if (!tasks)
+		out_of_memory();
+	for (i = 0; i < cfg->tasks; i++) {
+		if (i + 1 < cfg->tasks)
+			next = sum * pow(rnd_unit(&seed),
+					 1.0 / (double) (cfg->tasks - i - 1));
+		else
+			next = 0;
+		u = sum - next;
+		sum = next;
+		tasks[i].period = periods[rnd(&seed) % LENGTH(periods)];
+		tasks[i].wcet   = (long) (u * (double) tasks[i].period);
+		if (tasks[i].wcet < 1)
+			tasks[i].wcet = 1;
+		if (tasks[i].wcet > tasks[i].period)
+			tasks[i].wcet = tasks[i].period;
+	}
+	qsort(tasks, cfg->tasks, sizeof(struct task), period_cmp);
+	for (i = 0; i < cfg->tasks; i++)
+		tasks[i].prio = (int) i;
+	return tasks;
+}
+
+static int job_prio(struct sim* sim, struct job* job)
+{
+	if (sim->policy == EDF)
+		return (int) job->deadline;
+	return job->task->prio;
+}
+
+static struct release_heap* release_heap_get(struct sim* sim, long time)
+{
+	struct release_heap** bucket;
+	struct release_heap* rh;
+
+	bucket = sim->buckets + ((unsigned long) time & (sim->nbuckets - 1));
+	for (rh = *bucket; rh; rh = rh->chain)
+		if (rh->time == time)
+			return rh;
+	rh = heap_pool_alloc(&sim->rh_pool);
+	if (!rh)
+		out_of_memory();
+	rh->time  = time;
+	rh->list  = NULL;
+	rh->chain = *bucket;
+	*bucket   = rh;
+	iheap_init(&rh->jobs);
+	iheap_node_init(&rh->node, (int) time, NULL);
+	iheap_insert(&sim->releases, &rh->node);
+	return rh;
+}
+
+static void release_heap_put(struct sim* sim, struct release_heap* rh)
+{
+	struct release_heap** link;
+
+	link = sim->buckets + ((unsigned long) rh->time & (sim->nbuckets - 1));
+	while (*link != rh)
+		link = &(*link)->chain;
+	*link = rh->chain;
+	heap_pool_free(&sim->rh_pool, rh);
+}
+
+/* queue the job of task that arrives after time */
+static void add_job(struct sim* sim, struct task* task, long time)
+{
+	struct job* job = heap_pool_alloc(&sim->job_pool);
+	struct release_heap* rh;
+	long g = sim->cfg->granularity;
+
+	if (!job)
+		out_of_memory();
+	if (sim->cfg->jitter)
+		time += (long) (rnd(&sim->seed) %
+				(task->period * sim->cfg->jitter / 100 + 1));
+	time = (time + g - 1) / g * g;
+	job->task      = task;
+	job->release   = time;
+	job->deadline  = time + task->period;
+	job->remaining = task->wcet / 2 +
+		(long) (rnd(&sim->seed) % (unsigned long) (task->wcet / 2 + 1));
+	if (job->remaining < 1)
+		job->remaining = 1;
+	if (sim->mode == MERGE) {
+		rh = release_heap_get(sim, time);
+		iheap_node_init(&job->node, job_prio(sim, job), job);
+		iheap_insert(&rh->jobs, &job->node);
+		job->next = rh->list;
+		rh->list  = job;
+	} else {
+		iheap_node_init(&job->node, (int) time, job);
+		iheap_insert(&sim->releases, &job->node);
+	}
+}
+
+/* move every job that arrives at now into the ready queue */
+static void release_jobs(struct sim* sim)
+{
+	struct iheap_node* node;
+	struct release_heap* rh;
+	struct job* job;
+
+	while ((node = iheap_peek(&sim->releases)) && node->key <= sim->now) {
+		iheap_take(&sim->releases);
+		sim->releases_done++;
+		if (sim->mode == MERGE) {
+			rh = (struct release_heap*) node;
+			iheap_union(&sim->ready, &rh->jobs);
+			for (job = rh->list; job; job = job->next) {
+				add_job(sim, job->task,
+					job->release + job->task->period);
+				sim->released++;
+			}
+			release_heap_put(sim, rh);
+		} else {
+			job = (struct job*) node;
+			node->key = job_prio(sim, job);
+			iheap_insert(&sim->ready, node);
+			add_job(sim, job->task,
+				job->release + job->task->period);
+			sim->released++;
+		}
+	}
+}
+
+/* processor that runs the lowest-priority job, or an idle one */
+static unsigned int lowest_cpu(struct sim* sim)
+{
+	unsigned int cpu, low = 0;
+	for (cpu = 0; cpu < sim->cfg->cpus; cpu++) {
+		if (!sim->running[cpu])
+			return cpu;
+		if (sim->running[cpu]->node.key > sim->running[low]->node.key)
+			low = cpu;
+	}
+	return low;
+}
+
+/* preempt until the m highest-priority jobs are running */
+static void schedule(struct sim* sim)
+{
+	struct iheap_node* top;
+	struct job* job;
+	unsigned int cpu;
+
+	while ((top = iheap_peek(&sim->ready))) {
+		cpu = lowest_cpu(sim);
+		job = sim->running[cpu];
+		if (job && job->node.key <= top->key)
+			break;
+		iheap_take(&sim->ready);
+		if (job) {
+			iheap_insert(&sim->ready, &job->node);
+			sim->preemptions++;
+		}
+		sim->running[cpu] = (struct job*) top;
+	}
+}
+
+static void complete(struct sim* sim, unsigned int cpu)
+{
+	struct job* job = sim->running[cpu];
+	long tardiness = sim->now - job->deadline;
+
+	if (tardiness > 0) {
+		sim->misses++;
+		if (tardiness > sim->max_tardiness)
+			sim->max_tardiness = tardiness;
+	}
+	sim->running[cpu] = NULL;
+	sim->completed++;
+	heap_pool_free(&sim->job_pool, job);
+}
+
+/* returns the wall-clock time in nanoseconds */
+static uint64_t simulate(struct sim* sim)
+{
+	struct iheap_node* node;
+	unsigned int cpu, i;
+	long next, delta;
+	uint64_t t0;
+
+	for (i = 0; i < sim->cfg->tasks; i++)
+		add_job(sim, sim->tasks + i, 0);
+	t0 = now_ns();
+	while (sim->completed < sim->cfg->jobs) {
+		release_jobs(sim);
+		schedule(sim);
+		/* the next event is a release or a completion */
+		node = iheap_peek(&sim->releases);
+		next = node ? node->key : LONG_MAX;
+		for (cpu = 0; cpu < sim->cfg->cpus; cpu++)
+			if (sim->running[cpu] &&
+			    sim->now + sim->running[cpu]->remaining < next)
+				next = sim->now + sim->running[cpu]->remaining;
+		if (next > INT_MAX - 2 * periods[LENGTH(periods) - 1]) {
+			fprintf(stderr, "time overflow; use fewer jobs\n");
+			exit(1);
+		}
+		delta    = next - sim->now;
+		sim->now = next;
+		for (cpu = 0; cpu < sim->cfg->cpus; cpu++)
+			if (sim->running[cpu]) {
+				sim->running[cpu]->remaining -= delta;
+				if (!sim->running[cpu]->remaining)
+					complete(sim, cpu);
+			}
+	}
+	return now_ns() - t0;
+}
+
+static void run(const struct config* cfg, struct task* tasks, int policy,
+		int mode)
+{
+	struct sim sim;
+	uint64_t ns;
+
+	memset(&sim, 0, sizeof(sim));
+	sim.cfg    = cfg;
+	sim.policy = policy;
+	sim.mode   = mode;
+	sim.tasks  = tasks;
+	sim.seed   = cfg->seed;
+	iheap_init(&sim.ready);
+	iheap_init(&sim.releases);
+	/* at most one pending job per task */
+	for (sim.nbuckets = 1; sim.nbuckets < cfg->tasks; sim.nbuckets *= 2)
+		;
+	sim.buckets = calloc(sim.nbuckets, sizeof(struct release_heap*));
+	if (!sim.buckets)
+		out_of_memory();
+	heap_pool_init(&sim.job_pool, sizeof(struct job));
+	heap_pool_init(&sim.rh_pool, sizeof(struct release_heap));
+
+	ns = simulate(&sim);
+	printf("%-6s %-7s %10lu %10.2f %9lu %10ld %11lu %9.1f\n",
+	       policy == EDF ? "EDF" : "FP", mode == MERGE ? "merge" : "insert",
+	       sim.completed, (double) sim.completed * 1000.0 / (double) ns,
+	       sim.misses, sim.max_tardiness, sim.preemptions,
+	       sim.releases_done ?
+	       (double) sim.released / (double) sim.releases_done : 0.0);
+	fflush(stdout);
+
+	free(sim.buckets);
+	heap_pool_destroy(&sim.job_pool);
+	heap_pool_destroy(&sim.rh_pool);
+}
+
+static void usage(const char* prog)
+{
+	fprintf(stderr,
+		"usage: %s [-n tasks] [-m cpus] [-u utilization] [-j jobs] "
+		"[-g granularity] [-J jitter] [-s seed]\n", prog);
+	exit(1);
+}
+
+int main(int argc, char** argv)
+{
+	struct config cfg;
+	struct task* tasks;
+	int i;
+
+	cfg.tasks       = 1000;
+	cfg.cpus        = 4;
+	cfg.util        = 3.6;
+	cfg.jobs        = 2000000;
+	cfg.granularity = 10;
+	cfg.jitter      = 10;
+	cfg.seed        = 42;
+	for (i = 1; i < argc; i++) {
+		if (i + 1 == argc)
+			usage(argv[0]);
+		if (!strcmp(argv[i], "-n"))
+			cfg.tasks = (unsigned int) atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-m"))
+			cfg.cpus = (unsigned int) atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-u"))
+			cfg.util = atof(argv[++i]);
+		else if (!strcmp(argv[i], "-j"))
+			cfg.jobs = (unsigned long) atof(argv[++i]);
+		else if (!strcmp(argv[i], "-g"))
+			cfg.granularity = atol(argv[++i]);
+		else if (!strcmp(argv[i], "-J"))
+			cfg.jitter = (unsigned int) atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-s"))
+			cfg.seed = (unsigned int) strtoul(argv[++i], NULL, 0);
+		else
+			usage(argv[0]);
+	}
+	if (!cfg.tasks || !cfg.cpus || cfg.cpus > MAX_CPUS || cfg.util <= 0 ||
+	    !cfg.jobs || cfg.granularity < 1 || !cfg.seed)
+		usage(argv[0]);
+
+	tasks = make_tasks(&cfg);
+	printf("%-6s %-7s %10s %10s %9s %10s %11s %9s\n",
+	       "policy", "release", "jobs", "Mjobs/s", "misses",
+	       "tardiness", "preemptions", "jobs/rel");
+	run(&cfg, tasks, EDF, MERGE);
+	run(&cfg, tasks, EDF, INSERT);
+	run(&cfg, tasks, FP, MERGE);
+	run(&cfg, tasks, FP, INSERT);
+	free(tasks);
+	return 0;
+}
@@ -0,0 +1,310 @@
+/* sheap.h -- Skew Binomial Heaps
+ *
+ * Copyright (c) 2008, Bjoern B. Brandenburg <bbb [at] cs.unc.edu>
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University of North Carolina nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY  COPYRIGHT OWNER AND CONTRIBUTERS ``AS IS'' AND
+ * ANY  EXPRESS OR  IMPLIED  WARRANTIES,  INCLUDING, BUT  NOT  LIMITED TO,  THE
+ * IMPLIED WARRANTIES  OF MERCHANTABILITY AND FITNESS FOR  A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO  EVENT SHALL THE  COPYRIGHT OWNER OR  CONTRIBUTERS BE
+ * LIABLE  FOR  ANY  DIRECT,   INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT  OF
+ * SUBSTITUTE GOODS  OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+ * INTERRUPTION)  HOWEVER CAUSED  AND ON  ANY THEORY  OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR  TORT (INCLUDING  NEGLIGENCE OR  OTHERWISE)
+ * ARISING IN ANY WAY  OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SHEAP_H
+#define SHEAP_H
+
+#define NOT_IN_HEAP UINT_MAX
+
+/* upper bound on the rank of any node; requires <limits.h> */
+#define SHEAP_MAX_RANK (sizeof(size_t) * CHAR_BIT)
+
+#ifdef HEAP_STATS
+#include "heap_stats.h"
+#define __HEAP_STAT(heap, field, n)	((heap)->stats.field += (n))
+#else
+#define __HEAP_STAT(heap, field, n)	((void) (heap))
+#endif
+
+/* A skew binomial heap (Brodal and Okasaki) is a list of heap-ordered trees
+ * by increasing rank in which only the first two trees may have the same
+ * rank. An insertion either prepends the node as a tree of rank 0 or, if the
+ * first two trees have the same rank, combines the node and both trees into
+ * one tree of the next rank (a skew link). Either way, insertion touches at
+ * most three roots and never carries through the list, so it is O(1) in the
+ * worst case. A tree of rank r still has at least 2^r nodes, so there are at
+ * most log2(n) + 2 roots, and take and union remain O(log n).
+ *
+ * Nodes have no parent pointer, so there is no decrease or delete.
+ */
+struct sheap_node {
+	struct sheap_node*	next;
+	struct sheap_node*	child;
+
+	unsigned int		rank;
+	void*			value;
+};
+
+struct sheap {
+	struct sheap_node*	head;
+	/* the root with the highest priority, NULL iff the heap is empty */
+	struct sheap_node*	min;
+#ifdef HEAP_STATS
+	struct heap_stats	stats;
+#endif
+};
+
+/* item comparison function:
+ * return 1 if a has higher prio than b, 0 otherwise
+ */
+typedef int (*sheap_prio_t)(struct sheap_node* a, struct sheap_node* b);
+
+static inline void sheap_init(struct sheap* heap)
+{
+	heap->head = NULL;
+	heap->min  = NULL;
+#ifdef HEAP_STATS
+	heap_stats_reset(&heap->stats);
+#endif
+}
+
+static inline void sheap_node_init(struct sheap_node* h, void* value)
+{
+	h->next  = NULL;
+	h->child = NULL;
+	h->rank  = NOT_IN_HEAP;
+	h->value = value;
+}
+
+static inline void* sheap_node_value(struct sheap_node* h)
+{
+	return h->value;
+}
+
+static inline int sheap_node_in_heap(struct sheap_node* h)
+{
+	return h->rank != NOT_IN_HEAP;
+}
+
+static inline int sheap_empty(struct sheap* heap)
+{
+	return heap->head == NULL;
+}
+
+/* all priority comparisons go through here so that they can be counted */
+static inline int __sheap_higher(sheap_prio_t higher_prio, struct sheap* heap,
+				 struct sheap_node* a, struct sheap_node* b)
+{
+	__HEAP_STAT(heap, compares, 1);
+	return higher_prio(a, b);
+}
+
+/* make child a subtree of root */
+static inline void __sheap_add_child(struct sheap_node* root,
+				     struct sheap_node* child)
+{
+	child->next = root->child;
+	root->child = child;
+}
+
+/* link two trees of equal rank; returns the new root */
+static inline struct sheap_node* __sheap_link(sheap_prio_t higher_prio,
+					      struct sheap* heap,
+					      struct sheap_node* a,
+					      struct sheap_node* b)
+{
+	__HEAP_STAT(heap, links, 1);
+	if (__sheap_higher(higher_prio, heap, b, a)) {
+		__sheap_add_child(b, a);
+		b->rank++;
+		return b;
+	} else {
+		__sheap_add_child(a, b);
+		a->rank++;
+		return a;
+	}
+}
+
+/* Combine a single node with two trees of rank r into a tree of rank r + 1.
+ * The trees are linked first. If node has a higher priority than the
+ * resulting root, node becomes the new root with that tree as its only
+ * child; otherwise, node becomes a childless child of the root. Both cases
+ * add a single node to a tree of rank r + 1, so the size bound holds.
+ */
+static inline struct sheap_node* __sheap_skew_link(sheap_prio_t higher_prio,
+						   struct sheap* heap,
+						   struct sheap_node* node,
+						   struct sheap_node* a,
+						   struct sheap_node* b)
+{
+	struct sheap_node* root = __sheap_link(higher_prio, heap, a, b);
+	if (__sheap_higher(higher_prio, heap, node, root)) {
+		__sheap_add_child(node, root);
+		node->rank = root->rank;
+		return node;
+	} else {
+		__sheap_add_child(root, node);
+		return root;
+	}
+}
+
+/* Linking trees into a rank-indexed array works like incrementing a binary
+ * counter: trees[r] holds the tree of rank r, if any, and a new tree carries
+ * through the occupied slots. Returns the rank of the slot that was filled.
+ */
+static inline unsigned int __sheap_carry(sheap_prio_t higher_prio,
+					 struct sheap* heap,
+					 struct sheap_node** trees,
+					 struct sheap_node* node)
+{
+	struct sheap_node* other;
+	unsigned int r = node->rank;
+	while ((other = trees[r])) {
+		trees[r] = NULL;
+		node = __sheap_link(higher_prio, heap, other, node);
+		r++;
+	}
+	trees[r] = node;
+	return r;
+}
+
+/* carry every tree of a list into trees[]; limit is one past the highest
+ * occupied slot
+ */
+static inline void __sheap_carry_list(sheap_prio_t higher_prio,
+				      struct sheap* heap,
+				      struct sheap_node** trees,
+				      struct sheap_node* list,
+				      unsigned int* limit)
+{
+	struct sheap_node* next;
+	unsigned int r;
+	for (; list; list = next) {
+		next = list->next;
+		r = __sheap_carry(higher_prio, heap, trees, list);
+		if (r >= *limit)
+			*limit = r + 1;
+	}
+}
+
+/* Turn the first limit slots of trees[] into the root list, ordered by
+ * rank, and find the new minimum on the way.
+ */
+static inline void __sheap_collect(sheap_prio_t higher_prio,
+				   struct sheap* heap,
+				   struct sheap_node** trees,
+				   unsigned int limit)
+{
+	unsigned int r = limit;
+	heap->head = NULL;
+	heap->min  = NULL;
+	__HEAP_STAT(heap, min_scans, 1);
+	while (r--)
+		if (trees[r]) {
+			__HEAP_STAT(heap, roots_scanned, 1);
+			if (!heap->min ||
+			    __sheap_higher(higher_prio, heap, trees[r],
+					   heap->min))
+				heap->min = trees[r];
+			trees[r]->next = heap->head;
+			heap->head = trees[r];
+		}
+}
+
+/* insert (and reinitialize) a node into the heap in O(1) */
+static inline void sheap_insert(sheap_prio_t higher_prio, struct sheap* heap,
+				struct sheap_node* node)
+{
+	struct sheap_node* a = heap->head;
+	struct sheap_node* b = a ? a->next : NULL;
+	node->child = NULL;
+	node->rank  = 0;
+	if (b && a->rank == b->rank) {
+		heap->head = b->next;
+		node = __sheap_skew_link(higher_prio, heap, node, a, b);
+		/* if the minimum was a or b, node is now the root above it */
+		if (heap->min == a || heap->min == b)
+			heap->min = node;
+	}
+	node->next = heap->head;
+	heap->head = node;
+	if (!heap->min ||
+	    (heap->min != node &&
+	     __sheap_higher(higher_prio, heap, node, heap->min)))
+		heap->min = node;
+}
+
+static inline struct sheap_node* sheap_peek(sheap_prio_t higher_prio,
+					    struct sheap* heap)
+{
+	(void) higher_prio;
+	return heap->min;
+}
+
+/* Remove the minimum and merge its children with the remaining roots. The
+ * result has unique ranks, which is a special case of the invariant.
+ */
+static inline struct sheap_node* sheap_take(sheap_prio_t higher_prio,
+					    struct sheap* heap)
+{
+	struct sheap_node* trees[SHEAP_MAX_RANK];
+	struct sheap_node *node = heap->min, **pos;
+	unsigned int r, limit = 0;
+	if (!node)
+		return NULL;
+	for (pos = &heap->head; *pos != node; pos = &(*pos)->next)
+		;
+	*pos = node->next;
+	for (r = 0; r < SHEAP_MAX_RANK; r++)
+		trees[r] = NULL;
+	__sheap_carry_list(higher_prio, heap, trees, heap->head, &limit);
+	__sheap_carry_list(higher_prio, heap, trees, node->child, &limit);
+	__sheap_collect(higher_prio, heap, trees, limit);
+	node->next  = NULL;
+	node->child = NULL;
+	node->rank  = NOT_IN_HEAP;
+	return node;
+}
+
+/* merge addition into target */
+static inline void sheap_union(sheap_prio_t higher_prio,
+			       struct sheap* target, struct sheap* addition)
+{
+	struct sheap_node* trees[SHEAP_MAX_RANK];
+	unsigned int r, limit = 0;
+	if (!addition->head)
+		return;
+	if (target->head) {
+		for (r = 0; r < SHEAP_MAX_RANK; r++)
+			trees[r] = NULL;
+		__sheap_carry_list(higher_prio, target, trees, target->head,
+				   &limit);
+		__sheap_carry_list(higher_prio, target, trees, addition->head,
+				   &limit);
+		__sheap_collect(higher_prio, target, trees, limit);
+	} else {
+		target->head = addition->head;
+		target->min  = addition->min;
+	}
+	addition->head = NULL;
+	addition->min  = NULL;
+}
+
+#endif /* SHEAP_H */
@@ -0,0 +1,203 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+
+#include "sheap.h"
+
+/* Check the structure of skew binomial heaps while inserting in several
+ * orders, and then while inserting, taking, and merging at random against a
+ * table of the keys that should be in each heap.
+ */
+
+#define N	200
+
+static int keys[N];
+static struct sheap_node nodes[N];
+
+static int int_cmp(struct sheap_node* a, struct sheap_node* b)
+{
+	return *(int*) sheap_node_value(a) < *(int*) sheap_node_value(b);
+}
+
+/* size of a tree; sets *err if a child has a higher priority than its parent */
+static size_t tree_size(struct sheap_node* root, int* err)
+{
+	struct sheap_node* c;
+	size_t n = 1;
+	for (c = root->child; c; c = c->next) {
+		if (int_cmp(c, root))
+			*err = 1;
+		n += tree_size(c, err);
+	}
+	return n;
+}
+
+/* Check the invariant: heap-ordered trees of at least 2^rank nodes, ranks
+ * increasing along the root list except for the first two roots, and the
+ * cached minimum.
+ */
+static int check_heap(struct sheap* heap, int min)
+{
+	struct sheap_node* r;
+	int err = 0;
+	for (r = heap->head; r && !err; r = r->next) {
+		if (tree_size(r, &err) < (size_t) 1 << r->rank)
+			err = 1;
+		if (r->next && r->next->rank < r->rank + (r != heap->head))
+			err = 1;
+	}
+	if (err || !heap->min || *(int*) sheap_node_value(heap->min) != min) {
+		fprintf(stderr, "shtest: broken heap with minimum %d\n",
+			min);
+		return 1;
+	}
+	return 0;
+}
+
+/* Insert ascending (0), descending (1), and random (2) keys. Whenever the
+ * first two roots have equal ranks, the next insertion skew links them. The
+ * third insertion is the first to do so and shows which way: with ascending
+ * keys, the new node becomes a childless child of the linked tree, with
+ * descending keys, its root.
+ */
+static int test_skew_link(int order)
+{
+	struct sheap heap;
+	struct sheap_node* hn;
+	int i, min = INT_MAX, last = INT_MIN;
+
+	sheap_init(&heap);
+	for (i = 0; i < N; i++) {
+		keys[i] = order == 0 ? i : order == 1 ? N - i : rand() % N;
+		if (keys[i] < min)
+			min = keys[i];
+		sheap_node_init(nodes + i, keys + i);
+		sheap_insert(int_cmp, &heap, nodes + i);
+		if (check_heap(&heap, min))
+			return 1;
+		if (i != 2 || order == 2)
+			continue;
+		if (heap.head->rank != 1 || heap.head->next ||
+		    (order == 0 && heap.head->child != nodes + 2) ||
+		    (order == 1 && heap.head != nodes + 2)) {
+			fprintf(stderr, "shtest: no skew link on the third "
+				"insertion\n");
+			return 1;
+		}
+	}
+	while ((hn = sheap_take(int_cmp, &heap))) {
+		if (*(int*) sheap_node_value(hn) < last) {
+			fprintf(stderr, "shtest: took %d after %d\n",
+				*(int*) sheap_node_value(hn), last);
+			return 1;
+		}
+		last = *(int*) sheap_node_value(hn);
+		if (heap.head && check_heap(&heap,
+				*(int*) sheap_node_value(heap.min)))
+			return 1;
+	}
+	return 0;
+}
+
+#define M	1000
+#define STEPS	20000
+
+/* the value of each node is its slot, which starts with the key */
+struct slot {
+	int key;
+	/* 0 or 1, or -1 if not in a heap */
+	int heap;
+};
+
+static struct slot slots[M];
+static struct sheap_node snodes[M];
+static struct sheap heaps[2];
+
+static int min_key(int h)
+{
+	int i, min = INT_MAX;
+	for (i = 0; i < M; i++)
+		if (slots[i].heap == h && slots[i].key < min)
+			min = slots[i].key;
+	return min;
+}
+
+/* random slot in heap h (-1: not in a heap), or -1 if there is none */
+static int pick(int h)
+{
+	int i, start = rand() % M;
+	for (i = 0; i < M; i++)
+		if (slots[(start + i) % M].heap == h)
+			return (start + i) % M;
+	return -1;
+}
+
+static int take(int h)
+{
+	struct sheap_node* hn;
+	struct slot* s;
+	int expected = min_key(h);
+
+	hn = sheap_take(int_cmp, heaps + h);
+	if (!hn)
+		return expected != INT_MAX;
+	s = (struct slot*) sheap_node_value(hn);
+	if (s->heap != h || s->key != expected || sheap_node_in_heap(hn)) {
+		fprintf(stderr, "shtest: took %d from heap %d, expected %d\n",
+			s->key, h, expected);
+		return 1;
+	}
+	s->heap = -1;
+	return 0;
+}
+
+static int test_random(void)
+{
+	int i, h, s, dice, err = 0;
+
+	for (h = 0; h < 2; h++)
+		sheap_init(heaps + h);
+	for (i = 0; i < M; i++)
+		slots[i].heap = -1;
+	for (i = 0; i < STEPS && !err; i++) {
+		h    = rand() % 2;
+		dice = rand() % 16;
+		if (dice < 8) {
+			if ((s = pick(-1)) < 0)
+				continue;
+			slots[s].key  = rand() % M;
+			slots[s].heap = h;
+			sheap_node_init(snodes + s, slots + s);
+			sheap_insert(int_cmp, heaps + h, snodes + s);
+		} else if (dice < 14) {
+			err = take(h);
+		} else if (rand() % 4 == 0) {
+			sheap_union(int_cmp, heaps + h, heaps + !h);
+			for (s = 0; s < M; s++)
+				if (slots[s].heap == !h)
+					slots[s].heap = h;
+		}
+		for (h = 0; h < 2 && !err; h++)
+			if (!sheap_empty(heaps + h))
+				err = check_heap(heaps + h, min_key(h));
+	}
+	for (h = 0; h < 2 && !err; h++)
+		while (!err && !sheap_empty(heaps + h))
+			err = take(h);
+	if (!err && (pick(0) >= 0 || pick(1) >= 0)) {
+		fprintf(stderr, "shtest: heap ran empty too early\n");
+		err = 1;
+	}
+	return err;
+}
+
+int main(int argc __attribute__((unused)), char** argv __attribute__((unused)))
+{
+	int order;
+
+	srand(1);
+	for (order = 0; order < 3; order++)
+		if (test_skew_link(order))
+			return 1;
+	return test_random();
+}
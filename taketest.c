@@ -0,0 +1,212 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+
+#include "heap.h"
+#include "iheap.h"
+
+/* Take batches of k nodes with heap_take_many() and iheap_take_many() and
+ * check them against a sorted copy of the keys that are left. The batch sizes
+ * cover the single-take fallback below 8, the 256-node candidate heap, and
+ * more nodes than the heap holds. Between batches, keys are inserted and
+ * decreased, and the minimum is peeked at, so that some batches start with a
+ * cached minimum and with a lazy heap that has not been consolidated.
+ */
+
+#define N	3000
+
+static const size_t batches[] = {
+	0, 1, 7, 8, 9, 64, 255, 256, 257, 300, 1000, 2 * N
+};
+
+#define LENGTH(a) (sizeof(a) / sizeof(a[0]))
+
+struct item {
+	int key;
+	int in_heap;
+};
+
+static struct item items[N];
+static struct heap_node hnodes[N];
+static struct heap_node* taken[2 * N];
+static struct iheap_node inodes[N];
+static struct iheap_node* itaken[2 * N];
+static int live[N];
+
+static int int_cmp(const void* a, const void* b)
+{
+	int x = *(const int*) a, y = *(const int*) b;
+	return (x > y) - (x < y);
+}
+
+static int item_less(struct heap_node* a, struct heap_node* b)
+{
+	return ((struct item*) heap_node_value(a))->key <
+	       ((struct item*) heap_node_value(b))->key;
+}
+
+/* sorted keys of all items in the heap; returns their number */
+static size_t sorted_live(void)
+{
+	size_t i, n = 0;
+	for (i = 0; i < N; i++)
+		if (items[i].in_heap)
+			live[n++] = items[i].key;
+	qsort(live, n, sizeof(int), int_cmp);
+	return n;
+}
+
+static int check(const char* what, size_t k, size_t got, size_t n, size_t i,
+		 int key)
+{
+	if (got != (k < n ? k : n)) {
+		fprintf(stderr, "taketest: %s: took %lu of %lu, %lu left\n",
+			what, (unsigned long) got, (unsigned long) k,
+			(unsigned long) n);
+		return 1;
+	}
+	if (key != live[i]) {
+		fprintf(stderr, "taketest: %s: k = %lu: key %lu is %d, "
+			"expected %d\n", what, (unsigned long) k,
+			(unsigned long) i, key, live[i]);
+		return 1;
+	}
+	return 0;
+}
+
+/* insert some of the items that are not in the heap */
+static void refill(void (*insert)(int), int* keys)
+{
+	int i;
+	for (i = 0; i < N; i++)
+		if (!items[i].in_heap && rand() % 2) {
+			items[i].key = rand() % (4 * N);
+			if (keys)
+				keys[i] = items[i].key;
+			insert(i);
+		}
+}
+
+static struct heap hheap;
+
+static void heap_add(int i)
+{
+	heap_node_init(hnodes + i, items + i);
+	heap_insert(item_less, &hheap, hnodes + i);
+	items[i].in_heap = 1;
+}
+
+static int test_heap(int lazy)
+{
+	struct item* it;
+	size_t b, i, n, got;
+	int j;
+
+	if (lazy)
+		heap_init_lazy(&hheap);
+	else
+		heap_init(&hheap);
+	for (j = 0; j < N; j++)
+		items[j].in_heap = 0;
+	for (b = 0; b < LENGTH(batches); b++) {
+		refill(heap_add, NULL);
+		/* cache the minimum, then beat it twice: once by an insert,
+		 * which swaps the cache, and once by a decrease */
+		heap_peek(item_less, &hheap);
+		for (j = 0; j < N && items[j].in_heap; j++)
+			;
+		if (j < N) {
+			items[j].key = -1;
+			heap_add(j);
+		}
+		for (j = N - 1; j >= 0 && !items[j].in_heap; j--)
+			;
+		items[j].key = -2;
+		heap_decrease(item_less, &hheap, hnodes + j);
+
+		n   = sorted_live();
+		got = heap_take_many(item_less, &hheap, taken, batches[b]);
+		for (i = 0; i < got; i++) {
+			it = heap_node_value(taken[i]);
+			if (check("heap", batches[b], got, n, i, it->key))
+				return 1;
+			it->in_heap = 0;
+		}
+		if (!got && check("heap", batches[b], got, n, 0, live[0]))
+			return 1;
+	}
+	/* whatever take_many left behind must still be a valid heap */
+	n = sorted_live();
+	for (i = 0; i < n; i++) {
+		it = heap_node_value(heap_take(item_less, &hheap));
+		if (check("heap", n, n, n, i, it->key))
+			return 1;
+	}
+	return 0;
+}
+
+static struct iheap iheap;
+static int ikeys[N];
+
+static void iheap_add(int i)
+{
+	iheap_node_init(inodes + i, ikeys[i], items + i);
+	iheap_insert(&iheap, inodes + i);
+	items[i].in_heap = 1;
+}
+
+static int test_iheap(int lazy)
+{
+	struct item* it;
+	size_t b, i, n, got;
+	int j;
+
+	if (lazy)
+		iheap_init_lazy(&iheap);
+	else
+		iheap_init(&iheap);
+	for (j = 0; j < N; j++)
+		items[j].in_heap = 0;
+	for (b = 0; b < LENGTH(batches); b++) {
+		refill(iheap_add, ikeys);
+		iheap_peek(&iheap);
+		for (j = 0; j < N && items[j].in_heap; j++)
+			;
+		if (j < N) {
+			items[j].key = ikeys[j] = -1;
+			iheap_add(j);
+		}
+		for (j = N - 1; j >= 0 && !items[j].in_heap; j--)
+			;
+		items[j].key = -2;
+		iheap_decrease(&iheap, inodes + j, -2);
+
+		n   = sorted_live();
+		got = iheap_take_many(&iheap, itaken, batches[b]);
+		for (i = 0; i < got; i++) {
+			it = (struct item*) iheap_node_value(itaken[i]);
+			if (check("iheap", batches[b], got, n, i,
+				  itaken[i]->key))
+				return 1;
+			it->in_heap = 0;
+		}
+		if (!got && check("iheap", batches[b], got, n, 0, live[0]))
+			return 1;
+	}
+	n = sorted_live();
+	for (i = 0; i < n; i++)
+		if (check("iheap", n, n, n, i, iheap_take(&iheap)->key))
+			return 1;
+	return 0;
+}
+
+int main(int argc __attribute__((unused)), char** argv __attribute__((unused)))
+{
+	int lazy;
+
+	srand(1);
+	for (lazy = 0; lazy < 2; lazy++)
+		if (test_heap(lazy) || test_iheap(lazy))
+			return 1;
+	return 0;
+}
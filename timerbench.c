@@ -0,0 +1,360 @@
+/* timerbench.c -- timerq.h versus a hierarchical timing wheel
+ *
+ * Usage: timerbench [-n connections] [-o ops] [-r ops per tick]
+ *                   [-t timeout] [-c cancel %] [-e earlier %] [-s seed]
+ *
+ * Replays a synthetic trace of connection timeouts, in simulated time, on
+ *   - wheel:        a five-level cascading timing wheel (256 slots for the
+ *                   first level, 64 for the others) with doubly linked slots,
+ *   - timerq:       timerq.h, which re-arms later deadlines lazily, and
+ *   - timerq-eager: timerq.h with every re-arm done as cancel and insert.
+ *
+ * Every connection starts with a timeout of up to t ticks. Each operation
+ * picks a random connection and either cancels its timer (c percent),
+ * re-arms it for an eighth of the timeout (e percent), or re-arms it for
+ * the full timeout plus some jitter (all others). After every r operations,
+ * time advances by a tick and all due timers fire. The timerfd is not used;
+ * all three see the same trace and must fire the same timers at the same
+ * ticks, which a checksum verifies.
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "timerq.h"
+
+struct config {
+	unsigned long	n;
+	unsigned long	ops;
+	unsigned long	rate;
+	unsigned int	timeout;
+	unsigned int	cancel;
+	unsigned int	earlier;
+	unsigned int	seed;
+};
+
+enum { OP_CANCEL, OP_EARLIER, OP_LATER };
+
+struct result {
+	unsigned long	fired;
+	unsigned long	checksum;
+	uint64_t	ns;
+};
+
+/* xorshift; seed must not be zero */
+static unsigned int rnd(unsigned int* seed)
+{
+	unsigned int x = *seed;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return *seed = x;
+}
+
+/* next operation of the trace; returns the connection and the delay */
+static unsigned long next_op(const struct config* cfg, unsigned int* seed,
+			     int* op, unsigned int* delay)
+{
+	unsigned long conn = rnd(seed) % cfg->n;
+	unsigned int r = rnd(seed) % 100;
+
+	if (r < cfg->cancel)
+		*op = OP_CANCEL;
+	else if (r < cfg->cancel + cfg->earlier)
+		*op = OP_EARLIER;
+	else
+		*op = OP_LATER;
+	if (*op == OP_EARLIER)
+		*delay = cfg->timeout / 8 + 1;
+	else
+		*delay = cfg->timeout + rnd(seed) % (cfg->timeout / 8 + 1);
+	return conn;
+}
+
+/* Linux-style cascading timing wheel */
+#define TVR_BITS	8
+#define TVN_BITS	6
+#define TVR_SIZE	(1 << TVR_BITS)
+#define TVN_SIZE	(1 << TVN_BITS)
+#define TVR_MASK	(TVR_SIZE - 1)
+#define TVN_MASK	(TVN_SIZE - 1)
+#define TVN_LEVELS	4
+#define MAX_DELAY	0xffffffffull
+
+struct wtimer {
+	struct wtimer*	next;
+	struct wtimer*	prev;
+	uint64_t	expires;
+};
+
+struct wheel {
+	/* next tick to process */
+	uint64_t	now;
+	/* list heads; only next and prev are used */
+	struct wtimer	tv1[TVR_SIZE];
+	struct wtimer	tvn[TVN_LEVELS][TVN_SIZE];
+};
+
+static void wheel_init(struct wheel* w, uint64_t now)
+{
+	int i, j;
+	w->now = now;
+	for (i = 0; i < TVR_SIZE; i++)
+		w->tv1[i].next = w->tv1[i].prev = w->tv1 + i;
+	for (i = 0; i < TVN_LEVELS; i++)
+		for (j = 0; j < TVN_SIZE; j++)
+			w->tvn[i][j].next = w->tvn[i][j].prev = w->tvn[i] + j;
+}
+
+static void wheel_add(struct wheel* w, struct wtimer* t)
+{
+	uint64_t idx = t->expires - w->now;
+	struct wtimer* head;
+	int level;
+
+	if (t->expires < w->now) {
+		/* already due: runs at the next tick */
+		head = w->tv1 + (w->now & TVR_MASK);
+	} else if (idx < TVR_SIZE)
+		head = w->tv1 + (t->expires & TVR_MASK);
+	else {
+		if (idx > MAX_DELAY) {
+			idx        = MAX_DELAY;
+			t->expires = w->now + idx;
+		}
+		for (level = 0; level < TVN_LEVELS - 1; level++)
+			if (idx < 1ull << (TVR_BITS + (level + 1) * TVN_BITS))
+				break;
+		head = w->tvn[level] + ((t->expires >>
+					 (TVR_BITS + level * TVN_BITS)) &
+					TVN_MASK);
+	}
+	t->next          = head;
+	t->prev          = head->prev;
+	head->prev->next = t;
+	head->prev       = t;
+}
+
+static int wtimer_pending(struct wtimer* t)
+{
+	return t->next != NULL;
+}
+
+static void wheel_cancel(struct wtimer* t)
+{
+	if (wtimer_pending(t)) {
+		t->prev->next = t->next;
+		t->next->prev = t->prev;
+		t->next       = NULL;
+	}
+}
+
+/* re-add the timers of a slot one level down; returns the slot index */
+static int wheel_cascade(struct wheel* w, int level)
+{
+	int idx = (int) (w->now >> (TVR_BITS + level * TVN_BITS)) & TVN_MASK;
+	struct wtimer *head = w->tvn[level] + idx, *t, *next;
+
+	t = head->next;
+	head->next = head->prev = head;
+	for (; t != head; t = next) {
+		next = t->next;
+		wheel_add(w, t);
+	}
+	return idx;
+}
+
+/* Fire every timer that is due at or before tick. fired() receives them. */
+static void wheel_advance(struct wheel* w, uint64_t tick,
+			  void (*fired)(struct wtimer*, uint64_t))
+{
+	struct wtimer *head, *t;
+	int idx, level;
+
+	while (w->now <= tick) {
+		idx = (int) (w->now & TVR_MASK);
+		for (level = 0; !idx && level < TVN_LEVELS; level++)
+			idx = wheel_cascade(w, level);
+		head = w->tv1 + (w->now & TVR_MASK);
+		w->now++;
+		while ((t = head->next) != head) {
+			wheel_cancel(t);
+			fired(t, w->now - 1);
+		}
+	}
+}
+
+static unsigned long fired_count, fired_sum;
+static void* conn_base;
+static size_t conn_size;
+
+static void count(const void* conn, uint64_t tick)
+{
+	unsigned long i = (unsigned long)
+		(((const char*) conn - (const char*) conn_base) / conn_size);
+	fired_count++;
+	fired_sum += i * 31 + (unsigned long) tick;
+}
+
+static void wheel_fired(struct wtimer* t, uint64_t tick)
+{
+	count(t, tick);
+}
+
+static struct result run_wheel(const struct config* cfg)
+{
+	struct wheel* w = malloc(sizeof(struct wheel));
+	struct wtimer* conns = calloc(cfg->n, sizeof(struct wtimer));
+	unsigned int seed = cfg->seed, delay;
+	unsigned long i, c;
+	uint64_t tick = 0, t0;
+	struct result res;
+	int op;
+
+	if (!w || !conns) {
+		fprintf(stderr, "out of memory\n");
+		exit(1);
+	}
+	fired_count = fired_sum = 0;
+	conn_base   = conns;
+	conn_size   = sizeof(struct wtimer);
+	t0 = timerq_clock();
+	wheel_init(w, 1);
+	for (i = 0; i < cfg->n; i++) {
+		conns[i].expires = 1 + rnd(&seed) % cfg->timeout;
+		wheel_add(w, conns + i);
+	}
+	for (i = 0; i < cfg->ops; i++) {
+		if (i % cfg->rate == 0)
+			wheel_advance(w, ++tick, wheel_fired);
+		c = next_op(cfg, &seed, &op, &delay);
+		wheel_cancel(conns + c);
+		if (op != OP_CANCEL) {
+			conns[c].expires = tick + delay;
+			wheel_add(w, conns + c);
+		}
+	}
+	res.ns       = timerq_clock() - t0;
+	res.fired    = fired_count;
+	res.checksum = fired_sum;
+	free(conns);
+	free(w);
+	return res;
+}
+
+static struct result run_timerq(const struct config* cfg, int eager)
+{
+	struct timerq q;
+	struct timer* conns = malloc(sizeof(struct timer) * cfg->n);
+	struct timer* t;
+	unsigned int seed = cfg->seed, delay;
+	unsigned long i, c;
+	uint64_t tick = 0, t0;
+	struct result res;
+	int op;
+
+	if (!conns) {
+		fprintf(stderr, "out of memory\n");
+		exit(1);
+	}
+	fired_count = fired_sum = 0;
+	conn_base   = conns;
+	conn_size   = sizeof(struct timer);
+	/* one tick per millisecond */
+	timerq_init(&q, 1000000);
+	t0 = timerq_clock();
+	for (i = 0; i < cfg->n; i++) {
+		delay = 1 + rnd(&seed) % cfg->timeout;
+		timer_init(conns + i, NULL, NULL);
+		timerq_arm(&q, conns + i, q.base + delay * q.resolution);
+	}
+	for (i = 0; i < cfg->ops; i++) {
+		if (i % cfg->rate == 0) {
+			tick++;
+			while ((t = timerq_expire(&q, q.base +
+						  tick * q.resolution)))
+				count(t, tick);
+		}
+		c = next_op(cfg, &seed, &op, &delay);
+		if (op == OP_CANCEL || eager)
+			timerq_cancel(&q, conns + c);
+		if (op != OP_CANCEL)
+			timerq_arm(&q, conns + c,
+				   q.base + (tick + delay) * q.resolution);
+	}
+	res.ns       = timerq_clock() - t0;
+	res.fired    = fired_count;
+	res.checksum = fired_sum;
+	timerq_destroy(&q);
+	free(conns);
+	return res;
+}
+
+static void report(const struct config* cfg, const char* name,
+		   struct result res, const struct result* ref)
+{
+	printf("%-13s %10.2f %9.1f %10lu %s\n", name,
+	       (double) cfg->ops * 1000.0 / (double) res.ns,
+	       (double) res.ns / (double) cfg->ops, res.fired,
+	       !ref || (res.fired == ref->fired &&
+			res.checksum == ref->checksum) ? "ok" : "MISMATCH");
+	fflush(stdout);
+}
+
+static void usage(const char* prog)
+{
+	fprintf(stderr,
+		"usage: %s [-n connections] [-o ops] [-r ops per tick] "
+		"[-t timeout] [-c cancel %%] [-e earlier %%] [-s seed]\n",
+		prog);
+	exit(1);
+}
+
+int main(int argc, char** argv)
+{
+	struct config cfg;
+	struct result wheel;
+	int i;
+
+	cfg.n       = 1000000;
+	cfg.ops     = 10000000;
+	cfg.rate    = 100;
+	cfg.timeout = 30000;
+	cfg.cancel  = 20;
+	cfg.earlier = 5;
+	cfg.seed    = 42;
+	for (i = 1; i < argc; i++) {
+		if (i + 1 == argc)
+			usage(argv[0]);
+		if (!strcmp(argv[i], "-n"))
+			cfg.n = (unsigned long) atof(argv[++i]);
+		else if (!strcmp(argv[i], "-o"))
+			cfg.ops = (unsigned long) atof(argv[++i]);
+		else if (!strcmp(argv[i], "-r"))
+			cfg.rate = (unsigned long) atof(argv[++i]);
+		else if (!strcmp(argv[i], "-t"))
+			cfg.timeout = (unsigned int) atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-c"))
+			cfg.cancel = (unsigned int) atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-e"))
+			cfg.earlier = (unsigned int) atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-s"))
+			cfg.seed = (unsigned int) strtoul(argv[++i], NULL, 0);
+		else
+			usage(argv[0]);
+	}
+	if (!cfg.n || !cfg.rate || !cfg.timeout ||
+	    cfg.cancel + cfg.earlier > 100 || !cfg.seed)
+		usage(argv[0]);
+
+	printf("%-13s %10s %9s %10s %s\n",
+	       "queue", "Mops/s", "ns/op", "fired", "check");
+	wheel = run_wheel(&cfg);
+	report(&cfg, "wheel", wheel, NULL);
+	report(&cfg, "timerq", run_timerq(&cfg, 0), &wheel);
+	report(&cfg, "timerq-eager", run_timerq(&cfg, 1), &wheel);
+	return 0;
+}
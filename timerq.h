@@ -0,0 +1,305 @@
+/* timerq.h -- Timer queue on top of iheap.h and Linux timerfd
+ *
+ * Copyright (c) 2008, Bjoern B. Brandenburg <bbb [at] cs.unc.edu>
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University of North Carolina nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY  COPYRIGHT OWNER AND CONTRIBUTERS ``AS IS'' AND
+ * ANY  EXPRESS OR  IMPLIED  WARRANTIES,  INCLUDING, BUT  NOT  LIMITED TO,  THE
+ * IMPLIED WARRANTIES  OF MERCHANTABILITY AND FITNESS FOR  A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO  EVENT SHALL THE  COPYRIGHT OWNER OR  CONTRIBUTERS BE
+ * LIABLE  FOR  ANY  DIRECT,   INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT  OF
+ * SUBSTITUTE GOODS  OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+ * INTERRUPTION)  HOWEVER CAUSED  AND ON  ANY THEORY  OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR  TORT (INCLUDING  NEGLIGENCE OR  OTHERWISE)
+ * ARISING IN ANY WAY  OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TIMERQ_H
+#define TIMERQ_H
+
+#include <limits.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
+
+#include "iheap.h"
+
+/* A timer queue keeps one iheap node per timer, keyed by its deadline in
+ * ticks (of a given resolution) since a base time. Cancellation is an
+ * iheap_delete(), and moving a deadline earlier is an iheap_decrease().
+ *
+ * Deadlines usually move later, e.g., whenever a connection sees traffic.
+ * Such a re-arm only records the new deadline in the timer; its node stays
+ * where it is, with a key that is too small. When the stale node reaches the
+ * top, timerq_expire() re-inserts it with the actual deadline instead of
+ * expiring it. Hence, a timer that is pushed back many times before it
+ * fires costs one extra re-insertion, not one per re-arm.
+ *
+ * Optionally, the queue owns a timerfd that is armed for the earliest key.
+ * It is reprogrammed only when a timer is armed before every other one or
+ * when expired timers are processed; cancellations never touch it. The fd
+ * may therefore fire early (for a stale or cancelled node), which
+ * timerq_run() simply ignores.
+ *
+ * All times are CLOCK_MONOTONIC nanoseconds. Timers never fire early, but
+ * up to one tick late. Timer nodes have no refs, so timers stay in place.
+ */
+struct timer;
+struct timerq;
+
+typedef void (*timer_fn_t)(struct timerq* q, struct timer* t);
+
+struct timer {
+	struct iheap_node	node;
+	/* actual deadline; node.key may be earlier */
+	uint64_t		expires;
+	timer_fn_t		fn;
+};
+
+struct timerq {
+	struct iheap		heap;
+	/* time of tick zero */
+	uint64_t		base;
+	/* nanoseconds per tick */
+	uint64_t		resolution;
+	/* -1 unless timerq_open() was called */
+	int			fd;
+	/* deadline that the timerfd was last armed for, 0 if none */
+	uint64_t		armed;
+};
+
+static inline uint64_t timerq_clock(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+}
+
+static inline void timerq_init(struct timerq* q, uint64_t resolution)
+{
+	iheap_init(&q->heap);
+	q->base       = timerq_clock();
+	q->resolution = resolution ? resolution : 1;
+	q->fd         = -1;
+	q->armed      = 0;
+}
+
+/* Create the queue's timerfd. Returns it (for epoll etc.), or -1 on error. */
+static inline int timerq_open(struct timerq* q)
+{
+	if (q->fd < 0)
+		q->fd = timerfd_create(CLOCK_MONOTONIC,
+				       TFD_NONBLOCK | TFD_CLOEXEC);
+	return q->fd;
+}
+
+static inline void timer_init(struct timer* t, timer_fn_t fn,
+			      const void* value)
+{
+	iheap_node_init(&t->node, 0, value);
+	t->expires = 0;
+	t->fn      = fn;
+}
+
+static inline const void* timer_value(struct timer* t)
+{
+	return iheap_node_value(&t->node);
+}
+
+static inline int timer_pending(struct timer* t)
+{
+	return iheap_node_in_heap(&t->node);
+}
+
+static inline uint64_t timer_expires(struct timer* t)
+{
+	return t->expires;
+}
+
+/* Pending timers are disarmed as if they had been cancelled: afterwards, they
+ * are not pending and can be armed on another queue.
+ */
+static inline void timerq_destroy(struct timerq* q)
+{
+	struct iheap_node* node;
+	struct timer* t;
+
+	if (q->fd >= 0)
+		close(q->fd);
+	q->fd    = -1;
+	q->armed = 0;
+	while ((node = iheap_take(&q->heap))) {
+		t = (struct timer*) node;
+		timer_init(t, t->fn, timer_value(t));
+	}
+}
+
+/* first tick at or after time, clamped to the range of keys */
+static inline int __timerq_ticks(struct timerq* q, uint64_t time)
+{
+	uint64_t ticks;
+	if (time <= q->base)
+		return 0;
+	ticks = (time - q->base + q->resolution - 1) / q->resolution;
+	return ticks < INT_MAX ? (int) ticks : INT_MAX;
+}
+
+static inline uint64_t __timerq_time(struct timerq* q, int key)
+{
+	return q->base + (key > 0 ? (uint64_t) key * q->resolution : 0);
+}
+
+static inline int __timerq_settime(struct timerq* q, uint64_t time)
+{
+	struct itimerspec its;
+	its.it_interval.tv_sec  = 0;
+	its.it_interval.tv_nsec = 0;
+	its.it_value.tv_sec     = (time_t) (time / 1000000000ull);
+	its.it_value.tv_nsec    = (long) (time % 1000000000ull);
+	if (timerfd_settime(q->fd, TFD_TIMER_ABSTIME, &its, NULL))
+		return -1;
+	q->armed = time;
+	return 0;
+}
+
+/* Set t's deadline, whether or not it is pending. Returns -1 if the timerfd
+ * could not be reprogrammed, 0 otherwise.
+ */
+static inline int timerq_arm(struct timerq* q, struct timer* t,
+			     uint64_t expires)
+{
+	int key = __timerq_ticks(q, expires);
+
+	t->expires = expires;
+	if (!timer_pending(t)) {
+		t->node.key = key;
+		iheap_insert(&q->heap, &t->node);
+	} else if (key < t->node.key)
+		iheap_decrease(&q->heap, &t->node, key);
+	else
+		/* later: leave the node where it is */
+		return 0;
+	if (q->fd >= 0 && (!q->armed || __timerq_time(q, key) < q->armed))
+		return __timerq_settime(q, __timerq_time(q, key));
+	return 0;
+}
+
+static inline void timerq_cancel(struct timerq* q, struct timer* t)
+{
+	if (timer_pending(t))
+		iheap_delete(&q->heap, &t->node);
+}
+
+static inline int __timerq_shift_key(int key, int ticks)
+{
+	return key >= INT_MIN + ticks ? key - ticks : INT_MIN;
+}
+
+/* subtract ticks from every key in the trees rooted at h */
+static inline void __timerq_shift(struct iheap_node* h, int ticks)
+{
+	for (; h; h = h->next) {
+		h->key = __timerq_shift_key(h->key, ticks);
+		__timerq_shift(h->child, ticks);
+	}
+}
+
+/* Returns the number of whole ticks up to now. Before keys run out, the base
+ * moves forward; shifting every key by the same amount keeps the heap
+ * ordered. Overdue keys may saturate, and clamped ones become stale.
+ */
+static inline int __timerq_now(struct timerq* q, uint64_t now)
+{
+	uint64_t ticks = now > q->base ? (now - q->base) / q->resolution : 0;
+	int shift;
+
+	while (ticks >= INT_MAX / 2) {
+		shift = ticks < INT_MAX ? (int) ticks : INT_MAX;
+		__timerq_shift(q->heap.head, shift);
+		/* the cached minimum is not part of any tree */
+		if (q->heap.min)
+			q->heap.min->key = __timerq_shift_key(q->heap.min->key,
+							      shift);
+		q->base += (uint64_t) shift * q->resolution;
+		ticks   -= (uint64_t) shift;
+	}
+	return (int) ticks;
+}
+
+/* Remove and return the timer with the earliest deadline if it is at or
+ * before now, or NULL if there is none. Stale nodes are re-inserted along
+ * the way.
+ */
+static inline struct timer* timerq_expire(struct timerq* q, uint64_t now)
+{
+	struct iheap_node* node;
+	struct timer* t;
+	int ticks = __timerq_now(q, now), key;
+
+	while ((node = iheap_peek(&q->heap)) && node->key <= ticks) {
+		t   = (struct timer*) node;
+		key = __timerq_ticks(q, t->expires);
+		iheap_take(&q->heap);
+		if (key == node->key)
+			return t;
+		/* Re-armed for later. If the new deadline has passed as well,
+		 * it still has to wait for all earlier ones.
+		 */
+		t->node.key = key;
+		iheap_insert(&q->heap, &t->node);
+	}
+	return NULL;
+}
+
+/* earliest pending deadline (possibly stale, thus too early), 0 if none */
+static inline uint64_t timerq_next(struct timerq* q)
+{
+	struct iheap_node* node = iheap_peek(&q->heap);
+	return node ? __timerq_time(q, node->key) : 0;
+}
+
+/* Call when the timerfd is readable. Runs the callbacks of all expired
+ * timers, which may arm or cancel any timer, and rearms the timerfd. Returns
+ * the number of expired timers, or -1 if the timerfd could not be rearmed.
+ */
+static inline int timerq_run(struct timerq* q)
+{
+	uint64_t count, next;
+	struct timer* t;
+	int fd = q->fd, n = 0;
+
+	/* clear readability; EAGAIN after a spurious wakeup is fine */
+	if (read(fd, &count, sizeof(count)) != sizeof(count))
+		count = 0;
+	/* callbacks do not program the timerfd; that happens once below */
+	q->fd = -1;
+	while ((t = timerq_expire(q, timerq_clock()))) {
+		n++;
+		if (t->fn)
+			t->fn(q, t);
+	}
+	q->fd = fd;
+	next  = timerq_next(q);
+	if (!next)
+		q->armed = 0;
+	else if (next != q->armed && __timerq_settime(q, next))
+		return -1;
+	return n;
+}
+
+#endif /* TIMERQ_H */
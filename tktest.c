@@ -0,0 +1,145 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+
+#include "topk.h"
+
+/* Offer random keys to a top-k heap, now and then taking the minimum, and
+ * check every offer against a table of the nodes that should be retained:
+ * the heap must keep the k largest keys and hand back exactly the node that
+ * did not make it. Draining yields the retained nodes by decreasing key. On
+ * ties, the nodes already retained win.
+ */
+
+#define K	100
+#define OFFERS	20000
+
+static struct iheap_node nodes[OFFERS];
+static struct iheap_node* out[K];
+static int retained[OFFERS];
+static size_t size;
+
+/* the retained node with the smallest key, or -1 if there is none */
+static int min_retained(int n)
+{
+	int i, min = -1;
+	for (i = 0; i < n; i++)
+		if (retained[i] && (min < 0 || nodes[i].key < nodes[min].key))
+			min = i;
+	return min;
+}
+
+/* offer node i, with nodes 0..i-1 offered before */
+static int offer(struct topk* t, int i)
+{
+	struct iheap_node* got = topk_offer(t, nodes + i);
+	int min = min_retained(i), j = got ? (int) (got - nodes) : -1;
+
+	if (size < K ? got != NULL :
+	    nodes[i].key <= nodes[min].key ? got != nodes + i :
+	    j < 0 || j >= i || !retained[j] || got->key != nodes[min].key) {
+		fprintf(stderr, "tktest: offer %d returned the wrong node\n",
+			i);
+		return 1;
+	}
+	if (j >= 0 && j < i)
+		retained[j] = 0;
+	else if (j < 0)
+		size++;
+	if (j != i)
+		retained[i] = 1;
+	return 0;
+}
+
+static int test_random(void)
+{
+	struct topk t;
+	struct iheap_node* hn;
+	int i, min;
+	size_t n;
+
+	topk_init(&t, K);
+	size = 0;
+	for (i = 0; i < OFFERS; i++) {
+		iheap_node_init(nodes + i, rand() % (OFFERS / 4), NULL);
+		retained[i] = 0;
+		if (offer(&t, i))
+			return 1;
+		if (rand() % 100)
+			continue;
+		/* shrink the heap, to be refilled by the next offers */
+		min = min_retained(i + 1);
+		hn  = topk_take(&t);
+		if (!hn || hn->key != nodes[min].key ||
+		    !retained[hn - nodes] || topk_size(&t) != size - 1) {
+			fprintf(stderr, "tktest: took the wrong node\n");
+			return 1;
+		}
+		retained[hn - nodes] = 0;
+		size--;
+	}
+	n = topk_drain(&t, out);
+	if (n != size || topk_size(&t)) {
+		fprintf(stderr, "tktest: drained %lu of %lu nodes\n",
+			(unsigned long) n, (unsigned long) size);
+		return 1;
+	}
+	for (i = (int) n - 1; i >= 0; i--) {
+		min = min_retained(OFFERS);
+		if (out[i]->key != nodes[min].key ||
+		    !retained[out[i] - nodes]) {
+			fprintf(stderr, "tktest: drained %d, expected %d\n",
+				out[i]->key, nodes[min].key);
+			return 1;
+		}
+		retained[out[i] - nodes] = 0;
+	}
+	return 0;
+}
+
+/* With keys equal to the threshold, the nodes already retained win. A full
+ * heap of keys 5, 5, 7 rejects another 5, but a 6 evicts one of the 5s. The
+ * next 5 loses to the other one, which the next 6 evicts in turn. From then
+ * on, 6 is the threshold that a candidate has to beat.
+ */
+static int test_ties(void)
+{
+	struct topk t;
+	struct iheap_node n[9], *out[3];
+	static const int keys[9] = {5, 5, 7, 5, 6, 5, 6, 6, 4};
+	/* the node each offer returns: -1 for NULL, -2 for n[0] or n[1] */
+	static const int expected[9] = {-1, -1, -1, 3, -2, 5, -2, 7, 8};
+	struct iheap_node *got, *evicted = NULL;
+	int i;
+
+	topk_init(&t, 3);
+	for (i = 0; i < 9; i++) {
+		iheap_node_init(n + i, keys[i], NULL);
+		got = topk_offer(&t, n + i);
+		if (expected[i] == -2 ?
+		    (got != n && got != n + 1) || got == evicted :
+		    got != (expected[i] < 0 ? NULL : n + expected[i])) {
+			fprintf(stderr, "tktest: offer %d returned the wrong "
+				"node\n", i);
+			return 1;
+		}
+		if (expected[i] == -2)
+			evicted = got;
+	}
+	/* the 6 offered last was rejected, not the two retained before */
+	if (topk_size(&t) != 3 || topk_drain(&t, out) != 3 ||
+	    out[0] != n + 2 || out[1]->key != 6 || out[2]->key != 6 ||
+	    out[1] == n + 7 || out[2] == n + 7 || topk_size(&t)) {
+		fprintf(stderr, "tktest: wrong nodes retained\n");
+		return 1;
+	}
+	return 0;
+}
+
+int main(int argc __attribute__((unused)), char** argv __attribute__((unused)))
+{
+	srand(1);
+	if (test_ties() || test_random())
+		return 1;
+	return 0;
+}
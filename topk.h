@@ -0,0 +1,123 @@
+/* topk.h -- Bounded heaps that retain the k largest keys
+ *
+ * Copyright (c) 2008, Bjoern B. Brandenburg <bbb [at] cs.unc.edu>
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University of North Carolina nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY  COPYRIGHT OWNER AND CONTRIBUTERS ``AS IS'' AND
+ * ANY  EXPRESS OR  IMPLIED  WARRANTIES,  INCLUDING, BUT  NOT  LIMITED TO,  THE
+ * IMPLIED WARRANTIES  OF MERCHANTABILITY AND FITNESS FOR  A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO  EVENT SHALL THE  COPYRIGHT OWNER OR  CONTRIBUTERS BE
+ * LIABLE  FOR  ANY  DIRECT,   INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT  OF
+ * SUBSTITUTE GOODS  OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+ * INTERRUPTION)  HOWEVER CAUSED  AND ON  ANY THEORY  OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR  TORT (INCLUDING  NEGLIGENCE OR  OTHERWISE)
+ * ARISING IN ANY WAY  OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TOPK_H
+#define TOPK_H
+
+#include "iheap.h"
+
+/* A top-k heap keeps at most capacity nodes: those with the largest keys
+ * offered so far. It is an iheap, so the smallest key retained, which is the
+ * threshold for new candidates, is always at hand in the cached minimum. Once
+ * the heap is full, a candidate that does not beat the threshold costs a
+ * single comparison; otherwise, the minimum is evicted in O(1) and the
+ * candidate inserted in O(log n), and the next offer finds the new minimum
+ * in O(log n). Ties go to the node that was retained first.
+ *
+ * To keep the k smallest keys instead, negate them.
+ */
+struct topk {
+	struct iheap	heap;
+	size_t		size;
+	size_t		capacity;
+};
+
+static inline void topk_init(struct topk* t, size_t capacity)
+{
+	iheap_init(&t->heap);
+	t->size     = 0;
+	t->capacity = capacity;
+}
+
+static inline size_t topk_size(struct topk* t)
+{
+	return t->size;
+}
+
+static inline int topk_full(struct topk* t)
+{
+	return t->size >= t->capacity;
+}
+
+/* the node with the smallest key retained, or NULL if there is none */
+static inline struct iheap_node* topk_peek(struct topk* t)
+{
+	return iheap_peek(&t->heap);
+}
+
+/* Offer node to the heap. Returns the node that did not make it: NULL if
+ * node was added to a heap that was not full yet, node itself if it was
+ * rejected, or the evicted node. Either way, the returned node is out of the
+ * heap and can be reused for the next candidate.
+ */
+static inline struct iheap_node* topk_offer(struct topk* t,
+					    struct iheap_node* node)
+{
+	struct iheap_node* min;
+	if (t->size < t->capacity) {
+		iheap_insert(&t->heap, node);
+		t->size++;
+		return NULL;
+	}
+	min = iheap_peek(&t->heap);
+	if (!min || !__iheap_less(&t->heap, min, node))
+		return node;
+	iheap_take(&t->heap);
+	iheap_insert(&t->heap, node);
+	return min;
+}
+
+/* Remove the node with the smallest key, e.g., to shrink the heap. */
+static inline struct iheap_node* topk_take(struct topk* t)
+{
+	struct iheap_node* node = iheap_take(&t->heap);
+	if (node)
+		t->size--;
+	return node;
+}
+
+/* Empty the heap into nodes, which must have room for topk_size() nodes,
+ * in order of decreasing key. Returns the number of nodes stored.
+ */
+static inline size_t topk_drain(struct topk* t, struct iheap_node** nodes)
+{
+	struct iheap_node* tmp;
+	size_t n, i;
+	n = iheap_take_many(&t->heap, nodes, t->size);
+	for (i = 0; i < n / 2; i++) {
+		tmp              = nodes[i];
+		nodes[i]         = nodes[n - 1 - i];
+		nodes[n - 1 - i] = tmp;
+	}
+	t->size = 0;
+	return n;
+}
+
+#endif /* TOPK_H */
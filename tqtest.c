@@ -0,0 +1,175 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <poll.h>
+
+#include "timerq.h"
+
+/* Timers are armed, re-armed earlier and later, and cancelled at random
+ * while the clock advances. Deadlines fall on ticks, so each timer must
+ * expire exactly when the clock reaches its latest deadline, and not at
+ * all if it was cancelled. The timerfd must fire the callbacks in order,
+ * keys must survive the base moving forward, and destroying the queue must
+ * disarm the timers that are still pending.
+ */
+
+#define N		1000
+#define STEPS		50000
+#define RESOLUTION	1000
+
+static struct timer timers[N];
+/* the deadline that each timer should expire at, 0 if not pending */
+static uint64_t expires[N];
+
+static int check_expire(struct timerq* q, uint64_t now)
+{
+	struct timer* t;
+	uint64_t last = 0;
+	int i;
+
+	while ((t = timerq_expire(q, now))) {
+		i = (int) (t - timers);
+		if (!expires[i] || t->expires != expires[i] ||
+		    expires[i] > now || expires[i] < last || timer_pending(t)) {
+			fprintf(stderr, "tqtest: timer %d expired wrongly\n",
+				i);
+			return 1;
+		}
+		last = expires[i];
+		expires[i] = 0;
+	}
+	for (i = 0; i < N; i++)
+		if (expires[i] && expires[i] <= now) {
+			fprintf(stderr, "tqtest: timer %d missed\n", i);
+			return 1;
+		}
+	return 0;
+}
+
+static int test_random(void)
+{
+	struct timerq q;
+	uint64_t now;
+	int i, t, dice, err = 0;
+
+	timerq_init(&q, RESOLUTION);
+	now = q.base;
+	for (i = 0; i < N; i++) {
+		timer_init(timers + i, NULL, NULL);
+		expires[i] = 0;
+	}
+	for (i = 0; i < STEPS && !err; i++) {
+		t    = rand() % N;
+		dice = rand() % 8;
+		if (dice < 5) {
+			/* arm, or move the deadline earlier or later */
+			expires[t] = now + (uint64_t) (1 + rand() % N) *
+				     RESOLUTION;
+			timerq_arm(&q, timers + t, expires[t]);
+		} else if (dice < 6) {
+			timerq_cancel(&q, timers + t);
+			expires[t] = 0;
+		} else {
+			now += (uint64_t) (rand() % 16) * RESOLUTION;
+			err = check_expire(&q, now);
+		}
+		if (!err && !timer_pending(timers + t) != !expires[t]) {
+			fprintf(stderr, "tqtest: timer %d pending: %d\n", t,
+				timer_pending(timers + t));
+			err = 1;
+		}
+	}
+	if (!err)
+		err = check_expire(&q, now + (uint64_t) N * RESOLUTION);
+	if (!err && !iheap_empty(&q.heap)) {
+		fprintf(stderr, "tqtest: queue not empty\n");
+		err = 1;
+	}
+	timerq_destroy(&q);
+	return err;
+}
+
+/* With nanosecond ticks, keys run out after about two seconds. The base
+ * moves forward instead, and deadlines beyond the range of keys wait.
+ */
+static int test_shift(void)
+{
+	struct timerq q;
+	struct timer near, far;
+	uint64_t base;
+
+	timerq_init(&q, 1);
+	base = q.base;
+	timer_init(&near, NULL, NULL);
+	timer_init(&far, NULL, NULL);
+	timerq_arm(&q, &near, base + 2000000000ull);
+	timerq_arm(&q, &far, base + 5000000000ull);
+	if (timerq_expire(&q, base + 1999999999ull) ||
+	    timerq_expire(&q, base + 2000000000ull) != &near ||
+	    timerq_expire(&q, base + 4999999999ull) ||
+	    timerq_expire(&q, base + 5000000000ull) != &far || q.base == base) {
+		fprintf(stderr, "tqtest: keys lost when the base moved\n");
+		return 1;
+	}
+	return 0;
+}
+
+static int fired[3], nfired;
+
+static void fire(struct timerq* q __attribute__((unused)), struct timer* t)
+{
+	fired[nfired++] = (int) (size_t) timer_value(t);
+}
+
+/* the timerfd runs the callbacks, earliest deadline first */
+static int test_fd(void)
+{
+	struct timerq q;
+	struct timer t[3], late;
+	struct pollfd pfd;
+	uint64_t now;
+	int i;
+
+	timerq_init(&q, RESOLUTION);
+	pfd.fd     = timerq_open(&q);
+	pfd.events = POLLIN;
+	if (pfd.fd < 0) {
+		perror("timerfd_create");
+		return 1;
+	}
+	now = timerq_clock();
+	for (i = 0; i < 3; i++) {
+		timer_init(t + i, fire, (const void*) (size_t) i);
+		timerq_arm(&q, t + i, now + (uint64_t) (3 - i) * 1000000ull);
+	}
+	/* pushed back behind the others */
+	timerq_arm(&q, t + 2, now + 4000000ull);
+	while (!iheap_empty(&q.heap))
+		if (poll(&pfd, 1, 1000) < 0 || timerq_run(&q) < 0) {
+			perror("timerq");
+			return 1;
+		}
+	if (nfired != 3 || fired[0] != 1 || fired[1] != 0 || fired[2] != 2) {
+		fprintf(stderr, "tqtest: callbacks out of order\n");
+		return 1;
+	}
+	/* destroying the queue disarms the timers that are still pending */
+	timer_init(&late, fire, NULL);
+	timerq_arm(&q, &late, timerq_clock() + 1000000000ull);
+	timerq_destroy(&q);
+	if (timer_pending(&late) || q.fd >= 0) {
+		fprintf(stderr, "tqtest: timer still pending\n");
+		return 1;
+	}
+	return 0;
+}
+
+int main(int argc __attribute__((unused)), char** argv __attribute__((unused)))
+{
+	srand(1);
+	if (test_random() || test_shift() || test_fd())
+		return 1;
+	return 0;
+}